@@ -56,6 +56,8 @@ void AdderTree::Initialize(int _numSubcoreRow, int _numAdderBit, int _numAdderTr
 	numStage = ceil(log2(numSubcoreRow));            // # of stage of the adder tree, used for CalculateLatency ...
 	numAdderBit = _numAdderBit;                      // # of input bits of the Adder
 	numAdderTree = _numAdderTree;                    // # of Adder Tree
+	latencyPerRead.clear();
+	powerPerRead.clear();
 	
 	initialized = true;
 }
@@ -68,6 +70,8 @@ void AdderTree::CalculateArea(double _newHeight, double _newWidth, AreaModify _o
 		area = 0;
 		height = 0;
 		width = 0;
+		latencyPerRead.clear();    // adder的面积和电容会变化，缓存的代价作废
+		powerPerRead.clear();
 		// Adder
 		int numAdderEachStage = 0;                          // define # of adder in each stage
 		int numBitEachStage = numAdderBit;                  // define # of bits of the adder in each stage
@@ -135,16 +139,23 @@ void AdderTree::CalculateLatency(double numRead, int numUnitAdd, double _capLoad
 			j = numUnitAdd;
 		}
 
-		while (i != 0) {   // calculate the total # of full adder in each Adder Tree
-			numAdderEachStage = ceil(j/2);
-			adder.Initialize(numBitEachStage, numAdderEachStage);   
-			adder.CalculateLatency(1e20, _capLoad, 1);
-			readLatency += adder.readLatency;
-			numBitEachStage += 1;
-			j = ceil(j/2);
-			i -= 1;
+		map<pair<int, double>, double>::iterator cost = latencyPerRead.find(make_pair(j, _capLoad));
+		if (cost != latencyPerRead.end()) {   // 相同加数个数和负载下单次累加的延迟不变，直接复用
+			readLatency = cost->second;
+		} else {
+			int numUnit = j;
+			while (i != 0) {   // calculate the total # of full adder in each Adder Tree
+				numAdderEachStage = ceil(j/2);
+				adder.Initialize(numBitEachStage, numAdderEachStage);   
+				adder.CalculateLatency(1e20, _capLoad, 1);
+				readLatency += adder.readLatency;
+				numBitEachStage += 1;
+				j = ceil(j/2);
+				i -= 1;
 			
-			adder.initialized = false;
+				adder.initialized = false;
+			}
+			latencyPerRead[make_pair(numUnit, _capLoad)] = readLatency;
 		}
         readLatency *= numRead;		
 	}
@@ -171,17 +182,25 @@ void AdderTree::CalculatePower(double numRead, int numUnitAdd) {
 			j = numUnitAdd;
 		}
 		
-		while (i != 0) {  // calculate the total # of full adder in each Adder Tree
-			numAdderEachStage = ceil(j/2);
-			adder.Initialize(numBitEachStage, numAdderEachStage);     
-			adder.CalculatePower(1, numAdderEachStage);	
-			readDynamicEnergy += adder.readDynamicEnergy;	
-			leakage += adder.leakage;
-			numBitEachStage += 1;
-			j = ceil(j/2);
-			i -= 1;
+		map<int, pair<double, double> >::iterator cost = powerPerRead.find(j);
+		if (cost != powerPerRead.end()) {
+			readDynamicEnergy = cost->second.first;
+			leakage = cost->second.second;
+		} else {
+			int numUnit = j;
+			while (i != 0) {  // calculate the total # of full adder in each Adder Tree
+				numAdderEachStage = ceil(j/2);
+				adder.Initialize(numBitEachStage, numAdderEachStage);     
+				adder.CalculatePower(1, numAdderEachStage);	
+				readDynamicEnergy += adder.readDynamicEnergy;	
+				leakage += adder.leakage;
+				numBitEachStage += 1;
+				j = ceil(j/2);
+				i -= 1;
 			
-			adder.initialized = false;
+				adder.initialized = false;
+			}
+			powerPerRead[numUnit] = make_pair(readDynamicEnergy, leakage);
 		}
 		readDynamicEnergy *= numAdderTree;	
 		readDynamicEnergy *= numRead;
@@ -39,6 +39,7 @@
 #ifndef ADDERTREE_H_
 #define ADDERTREE_H_
 
+#include <map>
 #include "typedef.h"
 #include "InputParameter.h"
 #include "Technology.h"
@@ -69,6 +70,8 @@ public:
 	int numAdderBit;                      // # of input bits of the Adder
 	int numAdderTree;                     // # of Adder Tree
 	int numReadPulse;
+	std::map<std::pair<int, double>, double> latencyPerRead;                // (加数个数, 负载电容) -> 单次累加的延迟
+	std::map<int, std::pair<double, double> > powerPerRead;                 // 加数个数 -> 单次累加的能耗（每棵树）和漏电
 
 	Adder adder;
 };
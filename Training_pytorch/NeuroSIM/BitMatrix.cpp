@@ -0,0 +1,133 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#include <iostream>
+#include <stdlib.h>
+#include "BitMatrix.h"
+
+using namespace std;
+
+BitMatrixView::BitMatrixView() {
+	data = NULL;
+	numRow = 0;
+	numCol = 0;
+	rowOffset = 0;
+	wordsPerColumn = 0;
+}
+
+BitMatrixView::BitMatrixView(const uint64_t *_data, int _numRow, int _numCol, int _rowOffset, int _wordsPerColumn) {
+	data = _data;
+	numRow = _numRow;
+	numCol = _numCol;
+	rowOffset = _rowOffset;
+	wordsPerColumn = _wordsPerColumn;
+}
+
+bool BitMatrixView::Get(int row, int col) const {
+	int bit = rowOffset + row;
+	return (data[(long)col*wordsPerColumn + bit/64] >> (bit%64)) & 1;
+}
+
+BitMatrixView BitMatrixView::SubView(int positionRow, int positionCol, int numRowView, int numColView) const {
+	if (positionRow < 0 || positionCol < 0 || positionRow+numRowView > numRow || positionCol+numColView > numCol) {
+		cerr << "Error: bit matrix view [" << positionRow << "+" << numRowView << ", " << positionCol << "+" << numColView << "] is out of range "
+			 << numRow << "x" << numCol << endl;
+		exit(1);
+	}
+	int bit = rowOffset + positionRow;
+	return BitMatrixView(data + (long)positionCol*wordsPerColumn + bit/64, numRowView, numColView, bit%64, wordsPerColumn);
+}
+
+int BitMatrixView::GetColumn(int col, vector<uint64_t> &bits) const {
+	int numWord = (numRow + 63)/64;
+	int numSourceWord = (rowOffset + numRow + 63)/64;
+	const uint64_t *column = data + (long)col*wordsPerColumn;
+	bits.resize(numWord);
+	int numOne = 0;
+	for (int w=0; w<numWord; w++) {
+		uint64_t word = column[w] >> rowOffset;
+		if (rowOffset > 0 && w+1 < numSourceWord) {
+			word |= column[w+1] << (64 - rowOffset);
+		}
+		if (w == numWord-1 && numRow%64 != 0) {
+			word &= ((uint64_t) 1 << (numRow%64)) - 1;
+		}
+		bits[w] = word;
+		numOne += __builtin_popcountll(word);
+	}
+	return numOne;
+}
+
+BitMatrix::BitMatrix() {
+	numRow = 0;
+	numCol = 0;
+	wordsPerColumn = 0;
+}
+
+BitMatrix::BitMatrix(int _numRow, int _numCol, bool value) {
+	numRow = _numRow;
+	numCol = _numCol;
+	wordsPerColumn = (numRow + 63)/64;
+	data.assign((long)numCol*wordsPerColumn, 0);
+	if (value) {
+		for (int j=0; j<numCol; j++) {
+			for (int w=0; w<wordsPerColumn; w++) {
+				int numBit = (w == wordsPerColumn-1 && numRow%64 != 0)? numRow%64 : 64;	// 每列最后一个字中超出numRow的位保持为0
+				data[(long)j*wordsPerColumn + w] = (numBit == 64)? ~(uint64_t) 0 : ((uint64_t) 1 << numBit) - 1;
+			}
+		}
+	}
+}
+
+bool BitMatrix::Get(int row, int col) const {
+	return (data[(long)col*wordsPerColumn + row/64] >> (row%64)) & 1;
+}
+
+void BitMatrix::Set(int row, int col, bool value) {
+	uint64_t &word = data[(long)col*wordsPerColumn + row/64];
+	uint64_t bit = (uint64_t) 1 << (row%64);
+	if (value) {
+		word |= bit;
+	} else {
+		word &= ~bit;
+	}
+}
+
+BitMatrixView BitMatrix::SubView(int positionRow, int positionCol, int numRowView, int numColView) const {
+	return BitMatrixView(*this).SubView(positionRow, positionCol, numRowView, numColView);
+}
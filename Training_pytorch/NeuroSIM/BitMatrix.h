@@ -0,0 +1,84 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#ifndef BITMATRIX_H_
+#define BITMATRIX_H_
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+class BitMatrix;
+
+// 只读的0/1矩阵视图（输入激活的bit平面），不拥有数据
+// 按列存储：每列的各行依次打包进64位字中（第row行位于第row/64个字的第row%64位），每列占wordsPerColumn个字
+// 视图的首行可以不对齐到字边界，由rowOffset记录
+class BitMatrixView {
+public:
+	BitMatrixView();
+	BitMatrixView(const uint64_t *_data, int _numRow, int _numCol, int _rowOffset, int _wordsPerColumn);
+
+	bool Get(int row, int col) const;
+	BitMatrixView SubView(int positionRow, int positionCol, int numRowView, int numColView) const;
+	int GetColumn(int col, vector<uint64_t> &bits) const;	// 第col列对齐到第0位后写入bits，返回其中1的个数
+	int size() const { return numRow; }
+	bool empty() const { return numRow == 0 || numCol == 0; }
+
+	const uint64_t *data;
+	int numRow, numCol, rowOffset, wordsPerColumn;
+};
+
+class BitMatrix {
+public:
+	BitMatrix();
+	BitMatrix(int _numRow, int _numCol, bool value = false);
+
+	bool Get(int row, int col) const;
+	void Set(int row, int col, bool value);
+	operator BitMatrixView() const { return BitMatrixView(data.empty()? NULL : &data[0], numRow, numCol, 0, wordsPerColumn); }
+	BitMatrixView SubView(int positionRow, int positionCol, int numRowView, int numColView) const;
+	int size() const { return numRow; }
+	bool empty() const { return numRow == 0 || numCol == 0; }
+
+	vector<uint64_t> data;
+	int numRow, numCol, wordsPerColumn;
+};
+
+#endif /* BITMATRIX_H_ */
@@ -45,7 +45,7 @@
 
 using namespace std;
 
-extern Param *param;
+extern thread_local Param *param;
 
 
 Buffer::Buffer(const InputParameter& _inputParameter, const Technology& _tech, const MemCell& _cell): inputParameter(_inputParameter), tech(_tech), cell(_cell), 
@@ -79,6 +79,8 @@ void Buffer::Initialize(int _numBit, int _interface_width, int _num_interface, d
 	}
 	
 	wlDecoder.Initialize(REGULAR_ROW, (int)ceil((double)log2((double)ceil((double)numBit/(double)interface_width))), false, false);
+	latencyModeled = false;
+	powerModeled = false;
 	
 	initialized = true;
 }
@@ -90,6 +92,8 @@ void Buffer::CalculateArea(double _newHeight, double _newWidth, AreaModify _opti
 		area = 0;
 		height = 0;
 		width = 0;
+		latencyModeled = false;
+		powerModeled = false;
 		
 		if (SRAM) {
 			memoryArea = lengthRow * lengthCol;
@@ -147,33 +151,36 @@ void Buffer::CalculateLatency(double numAccessBitRead, double numRead, double nu
 	} else {
 		readLatency = 0;
 		writeLatency = 0;
-		readWholeLatency = 0;
-		writeWholeLatency = 0;
+		if (!latencyModeled) {   // 每行的平均读写延迟只由Initialize/CalculateArea确定的结构决定，只需计算一次
+			readWholeLatency = 0;
+			writeWholeLatency = 0;
 		
-		if (SRAM) {
-			wlDecoder.CalculateLatency(1e20, lengthRow * 0.2e-15/1e-6, NULL, (double) numBit/interface_width, (double) numBit/interface_width);
-			precharger.CalculateLatency(1e20, lengthCol * 0.2e-15/1e-6, (double) numBit/interface_width, (double) numBit/interface_width);
-			sramWriteDriver.CalculateLatency(1e20, lengthCol * 0.2e-15/1e-6, lengthCol * unitWireRes, (double) numBit/interface_width);
+			if (SRAM) {
+				wlDecoder.CalculateLatency(1e20, lengthRow * 0.2e-15/1e-6, NULL, (double) numBit/interface_width, (double) numBit/interface_width);
+				precharger.CalculateLatency(1e20, lengthCol * 0.2e-15/1e-6, (double) numBit/interface_width, (double) numBit/interface_width);
+				sramWriteDriver.CalculateLatency(1e20, lengthCol * 0.2e-15/1e-6, lengthCol * unitWireRes, (double) numBit/interface_width);
 			
-			double resCellAccess = CalculateOnResistance(param->widthAccessCMOS * tech.featureSize, NMOS, inputParameter.temperature, tech);
-			double capCellAccess = CalculateDrainCap(param->widthAccessCMOS * tech.featureSize, NMOS, param->widthInFeatureSizeSRAM * tech.featureSize, tech);
-			double resPullDown = CalculateOnResistance(param->widthSRAMCellNMOS * tech.featureSize, NMOS, inputParameter.temperature, tech);
-			double tau = (resCellAccess + resPullDown) * (capCellAccess + lengthCol * 0.2e-15/1e-6) + lengthCol * unitWireRes * (lengthCol * 0.2e-15/1e-6) / 2;
-			tau *= log(tech.vdd / (tech.vdd - param->minSenseVoltage / 2));   
-			double gm = CalculateTransconductance(param->widthAccessCMOS * tech.featureSize, NMOS, tech);
-			double beta = 1 / (resPullDown * gm);
-			double colRamp = 0;
-			colDelay = horowitz(tau, beta, wlDecoder.rampOutput, &colRamp)*((double) numBit/interface_width);
-			readWholeLatency += wlDecoder.readLatency + precharger.readLatency + colDelay;
-			writeWholeLatency += wlDecoder.writeLatency + precharger.writeLatency + sramWriteDriver.writeLatency;
-		} else {
-			wlDecoder.CalculateLatency(1e20, wDff * interface_width * 0.2e-15/1e-6, NULL, (double) numBit/interface_width, (double) numBit/interface_width);
-			readWholeLatency += wlDecoder.readLatency;
-			readWholeLatency += ((double) 1/clkFreq/2)*((double) numBit/interface_width);  // assume dff need half clock cycle to access
-			writeWholeLatency += wlDecoder.writeLatency + ((double) 1/clkFreq/2)*((double) numBit/interface_width);
+				double resCellAccess = CalculateOnResistance(param->widthAccessCMOS * tech.featureSize, NMOS, inputParameter.temperature, tech);
+				double capCellAccess = CalculateDrainCap(param->widthAccessCMOS * tech.featureSize, NMOS, param->widthInFeatureSizeSRAM * tech.featureSize, tech);
+				double resPullDown = CalculateOnResistance(param->widthSRAMCellNMOS * tech.featureSize, NMOS, inputParameter.temperature, tech);
+				double tau = (resCellAccess + resPullDown) * (capCellAccess + lengthCol * 0.2e-15/1e-6) + lengthCol * unitWireRes * (lengthCol * 0.2e-15/1e-6) / 2;
+				tau *= log(tech.vdd / (tech.vdd - param->minSenseVoltage / 2));   
+				double gm = CalculateTransconductance(param->widthAccessCMOS * tech.featureSize, NMOS, tech);
+				double beta = 1 / (resPullDown * gm);
+				double colRamp = 0;
+				colDelay = horowitz(tau, beta, wlDecoder.rampOutput, &colRamp)*((double) numBit/interface_width);
+				readWholeLatency += wlDecoder.readLatency + precharger.readLatency + colDelay;
+				writeWholeLatency += wlDecoder.writeLatency + precharger.writeLatency + sramWriteDriver.writeLatency;
+			} else {
+				wlDecoder.CalculateLatency(1e20, wDff * interface_width * 0.2e-15/1e-6, NULL, (double) numBit/interface_width, (double) numBit/interface_width);
+				readWholeLatency += wlDecoder.readLatency;
+				readWholeLatency += ((double) 1/clkFreq/2)*((double) numBit/interface_width);  // assume dff need half clock cycle to access
+				writeWholeLatency += wlDecoder.writeLatency + ((double) 1/clkFreq/2)*((double) numBit/interface_width);
+			}
+			avgBitReadLatency = (double) readWholeLatency/(numBit/interface_width);     // average latency per line(sec/line)
+			avgBitWriteLatency = (double) writeWholeLatency/(numBit/interface_width);
+			latencyModeled = true;
 		}
-		avgBitReadLatency = (double) readWholeLatency/(numBit/interface_width);     // average latency per line(sec/line)
-		avgBitWriteLatency = (double) writeWholeLatency/(numBit/interface_width);
 		readLatency = avgBitReadLatency*numRead;
 		writeLatency = avgBitWriteLatency*numWrite;
 	}
@@ -185,39 +192,42 @@ void Buffer::CalculatePower(double numAccessBitRead, double numRead, double numA
 	} else {
 		readDynamicEnergy = 0;
 		writeDynamicEnergy = 0;
-		leakage = 0;
-		readWholeDynamicEnergy = 0;
-		writeWholeDynamicEnergy = 0;
+		if (!powerModeled) {   // 每bit的平均读写能耗和漏电同样只需计算一次
+			leakage = 0;
+			readWholeDynamicEnergy = 0;
+			writeWholeDynamicEnergy = 0;
 		
-		if (SRAM) {
-			wlDecoder.CalculatePower(numBit/interface_width, numBit/interface_width);
-			precharger.CalculatePower(numBit/interface_width, numBit/interface_width);
-			sramWriteDriver.CalculatePower(numBit/interface_width);
-			readWholeDynamicEnergy += wlDecoder.readDynamicEnergy + precharger.readDynamicEnergy + sramWriteDriver.readDynamicEnergy;
-			writeWholeDynamicEnergy += wlDecoder.writeDynamicEnergy + precharger.writeDynamicEnergy + sramWriteDriver.writeDynamicEnergy;
-			leakage += wlDecoder.leakage + precharger.leakage + sramWriteDriver.leakage + senseAmp.leakage;
-		} else {
-			dffDynamicEnergy = 0;
-			wlDecoder.CalculatePower(numBit/interface_width, numBit/interface_width);
-			// Assume input D=1 and the energy of CLK INV and CLK TG are for 1 clock cycles
-			// CLK INV (all DFFs have energy consumption)
-			dffDynamicEnergy += (capInvInput + capInvOutput) * tech.vdd * tech.vdd * 4 * numBit;
-			// CLK TG (all DFFs have energy consumption)
-			dffDynamicEnergy += capTgGateN * tech.vdd * tech.vdd * 2 * numBit;
-			dffDynamicEnergy += capTgGateP * tech.vdd * tech.vdd * 2 * numBit;
-			// D to Q path (only selected DFFs have energy consumption)
-			dffDynamicEnergy += (capTgDrain * 3 + capInvInput) * tech.vdd * tech.vdd * numBit;	    // D input side
-			dffDynamicEnergy += (capTgDrain  + capInvOutput) * tech.vdd * tech.vdd * numBit;	    // D feedback side
-			dffDynamicEnergy += (capInvInput + capInvOutput) * tech.vdd * tech.vdd * numBit;	    // Q output side
+			if (SRAM) {
+				wlDecoder.CalculatePower(numBit/interface_width, numBit/interface_width);
+				precharger.CalculatePower(numBit/interface_width, numBit/interface_width);
+				sramWriteDriver.CalculatePower(numBit/interface_width);
+				readWholeDynamicEnergy += wlDecoder.readDynamicEnergy + precharger.readDynamicEnergy + sramWriteDriver.readDynamicEnergy;
+				writeWholeDynamicEnergy += wlDecoder.writeDynamicEnergy + precharger.writeDynamicEnergy + sramWriteDriver.writeDynamicEnergy;
+				leakage += wlDecoder.leakage + precharger.leakage + sramWriteDriver.leakage + senseAmp.leakage;
+			} else {
+				dffDynamicEnergy = 0;
+				wlDecoder.CalculatePower(numBit/interface_width, numBit/interface_width);
+				// Assume input D=1 and the energy of CLK INV and CLK TG are for 1 clock cycles
+				// CLK INV (all DFFs have energy consumption)
+				dffDynamicEnergy += (capInvInput + capInvOutput) * tech.vdd * tech.vdd * 4 * numBit;
+				// CLK TG (all DFFs have energy consumption)
+				dffDynamicEnergy += capTgGateN * tech.vdd * tech.vdd * 2 * numBit;
+				dffDynamicEnergy += capTgGateP * tech.vdd * tech.vdd * 2 * numBit;
+				// D to Q path (only selected DFFs have energy consumption)
+				dffDynamicEnergy += (capTgDrain * 3 + capInvInput) * tech.vdd * tech.vdd * numBit;	    // D input side
+				dffDynamicEnergy += (capTgDrain  + capInvOutput) * tech.vdd * tech.vdd * numBit;	    // D feedback side
+				dffDynamicEnergy += (capInvInput + capInvOutput) * tech.vdd * tech.vdd * numBit;	    // Q output side
 			
-			readWholeDynamicEnergy += wlDecoder.readDynamicEnergy + dffDynamicEnergy;
-			writeWholeDynamicEnergy += wlDecoder.writeDynamicEnergy + dffDynamicEnergy;
+				readWholeDynamicEnergy += wlDecoder.readDynamicEnergy + dffDynamicEnergy;
+				writeWholeDynamicEnergy += wlDecoder.writeDynamicEnergy + dffDynamicEnergy;
 			
-			leakage += CalculateGateLeakage(INV, 1, widthInvN, widthInvP, inputParameter.temperature, tech) * tech.vdd * 8 * numBit;
-			leakage += wlDecoder.leakage;
+				leakage += CalculateGateLeakage(INV, 1, widthInvN, widthInvP, inputParameter.temperature, tech) * tech.vdd * 8 * numBit;
+				leakage += wlDecoder.leakage;
+			}
+			avgBitReadDynamicEnergy = readWholeDynamicEnergy/numBit;
+			avgBitWriteDynamicEnergy = writeWholeDynamicEnergy/numBit;
+			powerModeled = true;
 		}
-		avgBitReadDynamicEnergy = readWholeDynamicEnergy/numBit;
-		avgBitWriteDynamicEnergy = writeWholeDynamicEnergy/numBit;
 		
 		readDynamicEnergy = avgBitReadDynamicEnergy*numAccessBitRead*numRead;
 		writeDynamicEnergy = avgBitWriteDynamicEnergy*numAccessBitWrite*numWrite;
@@ -72,6 +72,7 @@ public:
 	int numBit, interface_width, num_interface;
 	double unitWireRes, clkFreq, lengthRow, lengthCol, memoryArea, hDff, wDff, colDelay;
 	bool DDR, givenClkFreq, SRAM;
+	bool latencyModeled, powerModeled;	/* 平均每行延迟、每bit能耗已计算 */
 
 	double capTgDrain, capTgGateN, capTgGateP, capInvInput, capInvOutput;
 	double widthInvN, widthInvP, widthTgN, widthTgP, hDffInv, wDffInv;
@@ -46,7 +46,7 @@
 
 using namespace std;
 
-extern Param *param;
+extern thread_local Param *param;
 
 Bus::Bus(const InputParameter& _inputParameter, const Technology& _tech, const MemCell& _cell): inputParameter(_inputParameter), tech(_tech), cell(_cell), FunctionUnit() {
 	initialized = false;
@@ -134,25 +134,34 @@ void Bus::CalculateArea(double foldedratio, bool overLap) {
 		// Capacitance
 		// INV
 		CalculateGateCapacitance(INV, 1, widthInvN, widthInvP, hInv, tech, &capInvInput, &capInvOutput);
-	}
-}
-
-void Bus::CalculateLatency(double numRead){
-	if (!initialized) {
-		cout << "[Bus] Error: Require initialization first!" << endl;
-	} else {
-		readLatency = 0;
 		
+		// 单次读出的延迟、每bit能耗和漏电在结构确定后不再变化，此处一次算好，CalculateLatency/CalculatePower只需乘以次数
 		double resOnRep = CalculateOnResistance(widthInvN, NMOS, inputParameter.temperature, tech) + CalculateOnResistance(widthInvP, PMOS, inputParameter.temperature, tech);
 		unitLatencyRep = 0.7*(resOnRep*(capInvInput+capInvOutput+unitLengthWireCap*minDist)+0.5*unitLengthWireResistance*minDist*unitLengthWireCap*minDist+unitLengthWireResistance*minDist*capInvInput)/minDist;
 		unitLatencyWire = 0.7*unitLengthWireResistance*minDist*unitLengthWireCap*minDist/minDist;
-		
 		if (numRepeater > 0) {
-			readLatency += wireLength*unitLatencyRep;
+			latencyPerRead = wireLength*unitLatencyRep;
 		} else {
-			readLatency += wireLength*unitLatencyWire;
+			latencyPerRead = wireLength*unitLatencyWire;
 		}
 		
+		unitLengthLeakage = CalculateGateLeakage(INV, 1, widthInvN, widthInvP, inputParameter.temperature, tech) * tech.vdd / minDist;
+		leakagePerBus = unitLengthLeakage * wireLength * (numRow + numCol);
+		unitLengthEnergyRep = (capInvInput+capInvOutput+unitLengthWireCap*minDist)*tech.vdd*tech.vdd/minDist * 0.25;
+		unitLengthEnergyWire = (unitLengthWireCap*minDist)*tech.vdd*tech.vdd/minDist * 0.25;
+		if (numRepeater > 0) {
+			energyPerBit = wireLength*unitLengthEnergyRep;
+		} else {
+			energyPerBit = wireLength*unitLengthEnergyWire;
+		}
+	}
+}
+
+void Bus::CalculateLatency(double numRead){
+	if (!initialized) {
+		cout << "[Bus] Error: Require initialization first!" << endl;
+	} else {
+		readLatency = latencyPerRead;
 		readLatency *= numRead;	
 	}
 }
@@ -161,20 +170,8 @@ void Bus::CalculatePower(double numBitAccess, double numRead) {
 	if (!initialized) {
 		cout << "[Bus] Error: Require initialization first!" << endl;
 	} else {
-		leakage = 0;
-		readDynamicEnergy = 0;
-		
-		unitLengthLeakage = CalculateGateLeakage(INV, 1, widthInvN, widthInvP, inputParameter.temperature, tech) * tech.vdd / minDist;
-		leakage = unitLengthLeakage * wireLength * (numRow + numCol);
-
-		unitLengthEnergyRep = (capInvInput+capInvOutput+unitLengthWireCap*minDist)*tech.vdd*tech.vdd/minDist * 0.25;
-		unitLengthEnergyWire = (unitLengthWireCap*minDist)*tech.vdd*tech.vdd/minDist * 0.25;
-		
-		if (numRepeater > 0) {
-			readDynamicEnergy += wireLength*unitLengthEnergyRep;
-		} else {
-			readDynamicEnergy += wireLength*unitLengthEnergyWire;
-		}
+		leakage = leakagePerBus;
+		readDynamicEnergy = energyPerBit;
 		readDynamicEnergy *= numBitAccess*numRead;
 	}
 }
@@ -70,6 +70,7 @@ public:
 	double unitHeight, unitWidth, wireWidth;
 	double busWidth, delaytolerance, unitLengthWireCap, wireLength;
 	double unitLatencyRep, unitLatencyWire, unitLengthLeakage, unitLengthEnergyRep, unitLengthEnergyWire;
+	double latencyPerRead, energyPerBit, leakagePerBus;	/* CalculateArea时算好的单次读出代价 */
 	BusMode mode;
 };
 
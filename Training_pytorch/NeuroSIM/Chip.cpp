@@ -43,6 +43,7 @@
 #include <stdlib.h>
 #include <vector>
 #include <sstream>
+#include <algorithm>
 #include "MaxPooling.h"
 #include "Sigmoid.h"
 #include "BitShifter.h"
@@ -57,28 +58,38 @@
 #include "formula.h"
 #include "Param.h"
 #include "Chip.h"
+#include "LayerLoader.h"
+#include "SimulationContext.h"
 #include "Adder.h"
+#include "TraceFile.h"
+#include "CsvParser.h"
 
 using namespace std;
 
-extern Param *param;
-double globalBusWidth = 0;
-int numBufferCore = 0;
+extern thread_local Param *param;
+thread_local double globalBusWidth = 0;
+thread_local int numBufferCore = 0;
 
 /*** Circuit Modules ***/
-Buffer *globalBuffer;
-HTree *GhTree;
-AdderTree *Gaccumulation;
-Sigmoid *Gsigmoid;
-BitShifter *GreLu;
-MaxPooling *maxPool;
-DRAM *dRAM;
-WeightGradientUnit *weightGradientUnit;
-Adder *gradientAccum;
-
-vector<int> ChipDesignInitialize(InputParameter& inputParameter, Technology& tech, MemCell& cell, bool pip, const vector<vector<double> > &netStructure,
+// 模块实例为线程私有，由SimulationContext::Bind通过ChipSetComponents绑定到当前线程
+thread_local Buffer *globalBuffer;
+thread_local HTree *GhTree;
+thread_local AdderTree *Gaccumulation;
+thread_local Sigmoid *Gsigmoid;
+thread_local BitShifter *GreLu;
+thread_local MaxPooling *maxPool;
+thread_local DRAM *dRAM;
+thread_local WeightGradientUnit *weightGradientUnit;
+thread_local Adder *gradientAccum;
+
+vector<int> ChipDesignInitialize(SimulationContext& context, bool pip, const vector<vector<double> > &netStructure,
 					double *maxPESizeNM, double *maxTileSizeCM, double *numPENM){
 
+	context.Bind();
+	InputParameter& inputParameter = *context.inputParameter;
+	Technology& tech = *context.tech;
+	MemCell& cell = *context.cell;
+
 	globalBuffer = new Buffer(inputParameter, tech, cell);
 	GhTree = new HTree(inputParameter, tech, cell);
 	Gaccumulation = new AdderTree(inputParameter, tech, cell);
@@ -88,6 +99,7 @@ vector<int> ChipDesignInitialize(InputParameter& inputParameter, Technology& tec
 	dRAM = new DRAM(inputParameter, tech, cell);
 	weightGradientUnit = new WeightGradientUnit(inputParameter, tech, cell);
 	gradientAccum = new Adder(inputParameter, tech, cell);
+	context.components = ChipGetComponents();
 	
 	int numRowPerSynapse, numColPerSynapse;
 	numRowPerSynapse = param->numRowPerSynapse;
@@ -184,10 +196,12 @@ vector<int> ChipDesignInitialize(InputParameter& inputParameter, Technology& tec
 }
 
 
-vector<vector<double> > ChipFloorPlan(bool findNumTile, bool findUtilization, bool findSpeedUp, const vector<vector<double> > &netStructure, const vector<int > &markNM, 
+vector<vector<double> > ChipFloorPlan(SimulationContext& context, bool findNumTile, bool findUtilization, bool findSpeedUp, const vector<vector<double> > &netStructure, const vector<int > &markNM, 
 					double maxPESizeNM, double maxTileSizeCM, double numPENM, const vector<int> &pipelineSpeedUp,
 					double *desiredNumTileNM, double *desiredPESizeNM, double *desiredNumTileCM, double *desiredTileSizeCM, double *desiredPESizeCM, int *numTileRow, int *numTileCol) {
 	
+	context.Bind();
+	
 	
 	int numRowPerSynapse, numColPerSynapse;
 	numRowPerSynapse = param->numRowPerSynapse;
@@ -363,9 +377,14 @@ vector<vector<double> > ChipFloorPlan(bool findNumTile, bool findUtilization, bo
 }
 
 
-void ChipInitialize(InputParameter& inputParameter, Technology& tech, MemCell& cell, const vector<vector<double> > &netStructure, const vector<int > &markNM, const vector<vector<double> > &numTileEachLayer,
+void ChipInitialize(SimulationContext& context, const vector<vector<double> > &netStructure, const vector<int > &markNM, const vector<vector<double> > &numTileEachLayer,
 					double numPENM, double desiredNumTileNM, double desiredPESizeNM, double desiredNumTileCM, double desiredTileSizeCM, double desiredPESizeCM, int numTileRow, int numTileCol, int *numArrayWriteParallel) { 
 
+	context.Bind();
+	InputParameter& inputParameter = *context.inputParameter;
+	Technology& tech = *context.tech;
+	MemCell& cell = *context.cell;
+
 	/*** Initialize Tile ***/
 
 	TileInitialize(inputParameter, tech, cell, numPENM, desiredPESizeNM, ceil((double)(desiredTileSizeCM)/(double)(desiredPESizeCM)), desiredPESizeCM, param->digital);
@@ -529,13 +548,16 @@ void ChipInitialize(InputParameter& inputParameter, Technology& tech, MemCell& c
 			}
 		}
 	}
+	context.components = ChipGetComponents();
 }
 
 
 
-vector<double> ChipCalculateArea(InputParameter& inputParameter, Technology& tech, MemCell& cell, double desiredNumTileNM, double numPENM, double desiredPESizeNM, double desiredNumTileCM, double desiredTileSizeCM, 
+vector<double> ChipCalculateArea(SimulationContext& context, double desiredNumTileNM, double numPENM, double desiredPESizeNM, double desiredNumTileCM, double desiredTileSizeCM, 
 						double desiredPESizeCM, int numTileRow, double *height, double *width, double *CMTileheight, double *CMTilewidth, double *NMTileheight, double *NMTilewidth) {
 	
+	context.Bind();
+	
 	vector<double> areaResults;
 	
 	double area = 0;
@@ -647,7 +669,7 @@ vector<double> ChipCalculateArea(InputParameter& inputParameter, Technology& tec
 }
 
 
-double ChipCalculatePerformance(InputParameter& inputParameter, Technology& tech, MemCell& cell, int layerNumber, const string &newweightfile, const string &oldweightfile, const string &inputfile, bool followedByMaxPool, 
+double ChipCalculatePerformance(SimulationContext& context, int layerNumber, const string &newweightfile, const string &oldweightfile, const string &inputfile, bool followedByMaxPool, 
 							const vector<vector<double> > &netStructure, const vector<int> &markNM, int digital , int seq_len, int seq_len_total , const vector<vector<double> > &numTileEachLayer, const vector<vector<double> > &utilizationEachLayer, 
 							const vector<vector<double> > &speedUpEachLayer, const vector<vector<double> > &tileLocaEachLayer, double numPENM, double desiredPESizeNM, double desiredTileSizeCM, 
 							double desiredPESizeCM, double CMTileheight, double CMTilewidth, double NMTileheight, double NMTilewidth, int numArrayWriteParallel,
@@ -655,8 +677,9 @@ double ChipCalculatePerformance(InputParameter& inputParameter, Technology& tech
 							double *writeLatencyWU, double *writeDynamicEnergyWU, double *bufferLatency, double *bufferDynamicEnergy, double *icLatency, double *icDynamicEnergy, double *coreLatencyADC, 
 							double *coreLatencyAccum, double *coreLatencyOther, double *coreEnergyADC, double *coreEnergyAccum, double *coreEnergyOther, double *dramLatency, double *dramDynamicEnergy,
 							double *readLatencyPeakFW, double *readDynamicEnergyPeakFW, double *readLatencyPeakAG, double *readDynamicEnergyPeakAG, double *readLatencyPeakWG, double *readDynamicEnergyPeakWG,
-							double *writeLatencyPeakWU, double *writeDynamicEnergyPeakWU) {
+							double *writeLatencyPeakWU, double *writeDynamicEnergyPeakWU, const LayerData *preloaded) {
 	
+	context.Bind();
 	
 	int numRowPerSynapse, numColPerSynapse;
 	numRowPerSynapse = param->numRowPerSynapse;
@@ -668,22 +691,27 @@ double ChipCalculatePerformance(InputParameter& inputParameter, Technology& tech
 	int weightMatrixRow;
 	int weightMatrixCol;
 	if(!digital){
-		int weightMatrixRow = netStructure[l][2]*netStructure[l][3]*netStructure[l][4]*numRowPerSynapse;
-		int weightMatrixCol = netStructure[l][5]*numColPerSynapse;
+		weightMatrixRow = netStructure[l][2]*netStructure[l][3]*netStructure[l][4]*numRowPerSynapse;
+		weightMatrixCol = netStructure[l][5]*numColPerSynapse;
 	}
 	
 	
 	// load in whole file 
 
-	vector<vector<double> > inputVector;
-	vector<vector<double> > newMemory;
-	vector<vector<double> > oldMemory;
-	
-	if(digital == 0){
-		inputVector = LoadInInputData(inputfile); 
-		newMemory = LoadInWeightData(newweightfile, numRowPerSynapse, numColPerSynapse, param->maxConductance, param->minConductance);
-		oldMemory = LoadInWeightData(oldweightfile, numRowPerSynapse, numColPerSynapse, param->maxConductance, param->minConductance);
+	LayerData loadedData;       // 二进制trace直接mmap，输入视图指向映射的内存，各tile/PE的划分不再复制
+	if(preloaded == NULL){
+		if(digital == 0){
+			LayerFiles files;
+			files.newWeight = newweightfile;
+			files.oldWeight = oldweightfile;
+			files.input = inputfile;
+			LoadLayerData(files, &loadedData);
+		}
+		preloaded = &loadedData;
 	}
+	const BitMatrixView &inputView = preloaded->inputView;
+	const Matrix &newMemory = preloaded->newMemory;
+	const Matrix &oldMemory = preloaded->oldMemory;
 	
 	
 
@@ -747,12 +775,12 @@ double ChipCalculatePerformance(InputParameter& inputParameter, Technology& tech
 	if(digital){ //进行数字计算的transformer推理，完成指定序列输入和指定KV缓存大小下的输出一个token的过程仿真
 		int numPE = ceil((double)desiredTileSizeCM/(double)desiredPESizeCM);
 		cout << "----------------- Start Tile Performance ------------------" <<  endl;
-		vector<vector<double> > tileMemoryOld;
-		vector<vector<double> > tileMemory;
-		vector<vector<double> > tileInput;
+		MatrixView tileMemoryOld;
+		MatrixView tileMemory;
+		BitMatrixView tileInput;
 
 		TileCalculatePerformance(tileMemory, tileMemoryOld, tileInput, false, true, seq_len, seq_len_total, layerNumber, numPE, desiredPESizeCM, 1, 1,
-			0, 0, 0, tech, cell, &tileReadLatency, &tileReadDynamicEnergy, &tileLeakage,
+			0, 0, 0, context, &tileReadLatency, &tileReadDynamicEnergy, &tileLeakage,
 			&tileReadLatencyAG, &tileReadDynamicEnergyAG, &tileWriteLatencyWU, &tileWriteDynamicEnergyWU,
 			&tilebufferLatency, &tilebufferDynamicEnergy, &tileicLatency, &tileicDynamicEnergy, 
 			&tileLatencyADC, &tileLatencyAccum, &tileLatencyOther, &tileEnergyADC, &tileEnergyAccum, &tileEnergyOther, 
@@ -805,16 +833,16 @@ double ChipCalculatePerformance(InputParameter& inputParameter, Technology& tech
 				int numColMatrix = min(desiredTileSizeCM, weightMatrixCol-j*desiredTileSizeCM);
 				
 				// assign weight and input to specific tile
-				vector<vector<double> > tileMemoryOld;
+				MatrixView tileMemoryOld;
 				tileMemoryOld = CopyArray(oldMemory, i*desiredTileSizeCM, j*desiredTileSizeCM, numRowMatrix, numColMatrix);
-				vector<vector<double> > tileMemory;
+				MatrixView tileMemory;
 				tileMemory = CopyArray(newMemory, i*desiredTileSizeCM, j*desiredTileSizeCM, numRowMatrix, numColMatrix);
 				
-				vector<vector<double> > tileInput;
-				tileInput = CopyInput(inputVector, i*desiredTileSizeCM, numInVector*param->numBitInput, numRowMatrix);
+				BitMatrixView tileInput;
+				tileInput = CopyInput(inputView, i*desiredTileSizeCM, numInVector*param->numBitInput, numRowMatrix);
 				
 				TileCalculatePerformance(tileMemory, tileMemoryOld, tileInput, markNM[l], false, 0, 0, layerNumber, ceil((double)desiredTileSizeCM/(double)desiredPESizeCM), desiredPESizeCM, speedUpEachLayer[0][l], speedUpEachLayer[1][l],
-									numRowMatrix, numColMatrix, numInVector*param->numBitInput, tech, cell, &tileReadLatency, &tileReadDynamicEnergy, &tileLeakage,
+									numRowMatrix, numColMatrix, numInVector*param->numBitInput, context, &tileReadLatency, &tileReadDynamicEnergy, &tileLeakage,
 									&tileReadLatencyAG, &tileReadDynamicEnergyAG, &tileWriteLatencyWU, &tileWriteDynamicEnergyWU,
 									&tilebufferLatency, &tilebufferDynamicEnergy, &tileicLatency, &tileicDynamicEnergy, 
 									&tileLatencyADC, &tileLatencyAccum, &tileLatencyOther, &tileEnergyADC, &tileEnergyAccum, &tileEnergyOther, 
@@ -933,20 +961,20 @@ double ChipCalculatePerformance(InputParameter& inputParameter, Technology& tech
 				int numColMatrix = min(desiredPESizeNM, weightMatrixCol-j*desiredPESizeNM);
 				
 				// assign weight and input to specific tile
-				vector<vector<double> > tileMemoryOld;
+				Matrix tileMemoryOld;
 				tileMemoryOld = ReshapeArray(oldMemory, i*desiredPESizeNM, j*desiredPESizeNM, (int) netStructure[l][2]*numRowPerSynapse/numtileEachLayerRow, 
 									(int) netStructure[l][5]*numColPerSynapse/numtileEachLayerCol, numPENM, (int) netStructure[l][2]*numRowPerSynapse);
 				
-				vector<vector<double> > tileMemory;
+				Matrix tileMemory;
 				tileMemory = ReshapeArray(newMemory, i*desiredPESizeNM, j*desiredPESizeNM, (int) netStructure[l][2]*numRowPerSynapse/numtileEachLayerRow, 
 									(int) netStructure[l][5]*numColPerSynapse/numtileEachLayerCol, numPENM, (int) netStructure[l][2]*numRowPerSynapse);
 				
-				vector<vector<double> > tileInput;
-				tileInput = ReshapeInput(inputVector, i*desiredPESizeNM, (int) (netStructure[l][0]-netStructure[l][3]+1)*(netStructure[l][1]-netStructure[l][4]+1)*param->numBitInput, 
+				BitMatrix tileInput;
+				tileInput = ReshapeInput(inputView, i*desiredPESizeNM, (int) (netStructure[l][0]-netStructure[l][3]+1)*(netStructure[l][1]-netStructure[l][4]+1)*param->numBitInput, 
 									(int) netStructure[l][2]*numRowPerSynapse/numtileEachLayerRow, numPENM, (int) netStructure[l][2]*numRowPerSynapse);
 	
 				TileCalculatePerformance(tileMemory, tileMemoryOld, tileInput, markNM[l], false, 0, 0, layerNumber, numPENM, desiredPESizeNM, speedUpEachLayer[0][l], speedUpEachLayer[1][l],
-									numRowMatrix, numColMatrix, numInVector*param->numBitInput, tech, cell, 
+									numRowMatrix, numColMatrix, numInVector*param->numBitInput, context, 
 									&tileReadLatency, &tileReadDynamicEnergy, &tileLeakage, &tileReadLatencyAG, &tileReadDynamicEnergyAG, &tileWriteLatencyWU, &tileWriteDynamicEnergyWU,
 									&tilebufferLatency, &tilebufferDynamicEnergy, &tileicLatency, &tileicDynamicEnergy,
 									&tileLatencyADC, &tileLatencyAccum, &tileLatencyOther, &tileEnergyADC, &tileEnergyAccum, &tileEnergyOther, 
@@ -1250,6 +1278,72 @@ double ChipCalculatePerformance(InputParameter& inputParameter, Technology& tech
 
 
 
+ChipComponents ChipGetComponents() {
+	ChipComponents components;
+	components.globalBuffer = globalBuffer;
+	components.GhTree = GhTree;
+	components.Gaccumulation = Gaccumulation;
+	components.Gsigmoid = Gsigmoid;
+	components.GreLu = GreLu;
+	components.maxPool = maxPool;
+	components.dRAM = dRAM;
+	components.weightGradientUnit = weightGradientUnit;
+	components.gradientAccum = gradientAccum;
+	components.globalBusWidth = globalBusWidth;
+	components.numBufferCore = numBufferCore;
+	components.tile = TileGetComponents();
+	return components;
+}
+
+
+ChipComponents ChipCopyComponents(const ChipComponents &original) {
+	ChipComponents components;
+	components.globalBuffer = new Buffer(*original.globalBuffer);
+	components.GhTree = new HTree(*original.GhTree);
+	components.Gaccumulation = new AdderTree(*original.Gaccumulation);
+	components.Gsigmoid = new Sigmoid(*original.Gsigmoid);
+	components.GreLu = new BitShifter(*original.GreLu);
+	components.maxPool = new MaxPooling(*original.maxPool);
+	components.dRAM = new DRAM(*original.dRAM);
+	components.weightGradientUnit = new WeightGradientUnit(*original.weightGradientUnit);
+	components.gradientAccum = new Adder(*original.gradientAccum);
+	components.globalBusWidth = original.globalBusWidth;
+	components.numBufferCore = original.numBufferCore;
+	components.tile = TileCopyComponents(original.tile);
+	return components;
+}
+
+
+void ChipSetComponents(const ChipComponents &components) {
+	globalBuffer = components.globalBuffer;
+	GhTree = components.GhTree;
+	Gaccumulation = components.Gaccumulation;
+	Gsigmoid = components.Gsigmoid;
+	GreLu = components.GreLu;
+	maxPool = components.maxPool;
+	dRAM = components.dRAM;
+	weightGradientUnit = components.weightGradientUnit;
+	gradientAccum = components.gradientAccum;
+	globalBusWidth = components.globalBusWidth;
+	numBufferCore = components.numBufferCore;
+	TileSetComponents(components.tile);
+}
+
+
+void ChipDeleteComponents(ChipComponents &components) {
+	delete components.globalBuffer;
+	delete components.GhTree;
+	delete components.Gaccumulation;
+	delete components.Gsigmoid;
+	delete components.GreLu;
+	delete components.maxPool;
+	delete components.dRAM;
+	delete components.weightGradientUnit;
+	delete components.gradientAccum;
+	TileDeleteComponents(components.tile);
+}
+
+
 vector<double> TileDesignCM(double tileSize, const vector<int > &markNM, const vector<vector<double> > &netStructure, int numRowPerSynapse, int numColPerSynapse) {
 	double numTileTotal = 0;
 	double matrixTotalCM = 0;
@@ -1480,270 +1574,234 @@ vector<vector<double> > OverallEachLayer(bool utilization, bool speedUp, const v
 
 
 
-vector<vector<double> > LoadInWeightData(const string &weightfile, int numRowPerSynapse, int numColPerSynapse, double maxConductance, double minConductance) {
+// 把一个权重值映射为该突触的各单元电导，追加到weightrow（XNOR模式下互补的单元追加到weightrowb）
+static void AppendSynapse(double f, int numColPerSynapse, double maxConductance, double minConductance, vector<double> &weightrow, vector<double> &weightrowb) {
 	
-	ifstream fileone(weightfile.c_str());                           
-	string lineone;
-	string valone;
+	double NormalizedMin = 0;
+	double NormalizedMax = pow(2, param->synapseBit);
 	
-	int ROW = 0;
-	int COL = 0;
+	double RealMax = param->algoWeightMax;
+	double RealMin = param->algoWeightMin;
 	
-	if (!fileone.good()) {                                       
-		cerr << "Error: the fileone cannot be opened!" << endl;
-		exit(1);
-	}else{
-		while (getline(fileone, lineone, '\n')) {                   
-			ROW++;                                             
+	if ((param->memcelltype != 1)&&(param->synapseBit == param->cellBit)) { // training version: linear mapping
+		weightrow.push_back((f+1)/2*(maxConductance-minConductance)+minConductance);
+	} else {
+		//normalize weight to integer
+		double newdata = ((NormalizedMax-NormalizedMin)/(RealMax-RealMin)*(f-RealMax)+NormalizedMax);
+		if (newdata >= 0) {
+			newdata += 0.5;
+		}else {
+			newdata -= 0.5;
 		}
-		fileone.clear();
-		fileone.seekg(0, ios::beg);                               
-		if (getline(fileone, lineone, '\n')) {                      
-			istringstream iss (lineone);                         
-			while (getline(iss, valone, ',')) {                   
-				COL++;
+		// map and expend the weight in memory array
+		int cellrange = pow(2, param->cellBit);
+		vector<int> synapsevector(numColPerSynapse);       
+		int value = newdata; 
+		if (param->BNNparallelMode) {
+			if (value == 1) {
+				weightrow.push_back(maxConductance);
+				weightrow.push_back(minConductance);
+			} else {
+				weightrow.push_back(minConductance);
+				weightrow.push_back(maxConductance);
 			}
-		}	
+		} else if (param->XNORparallelMode || param->XNORsequentialMode) {
+			if (value == 1) {
+				weightrow.push_back(maxConductance);
+				weightrowb.push_back(minConductance);
+			} else {
+				weightrow.push_back(minConductance);
+				weightrowb.push_back(maxConductance);
+			}
+		} else {
+			int remainder;   
+			for (int z=0; z<numColPerSynapse; z++) {   
+				remainder = (int) value%cellrange;
+				value = (int) value/cellrange;
+				synapsevector.insert(synapsevector.begin(), value/*remainder*/);
+			}
+			for (int u=0; u<numColPerSynapse; u++) {
+				int cellvalue = synapsevector[u];
+				double conductance = cellvalue/(cellrange-1) * (maxConductance-minConductance) + minConductance;
+				weightrow.push_back(conductance);
+			}
+		}
 	}
-	fileone.clear();
-	fileone.seekg(0, ios::beg);                   
+}
+
+
+
+// XNOR模式下每个权重占上下两行（正、反电导）
+static void AppendWeightRow(Matrix &weight, const vector<double> &weightrow, const vector<double> &weightrowb) {
+	weight.AppendRow(weightrow);
+	if (param->XNORparallelMode || param->XNORsequentialMode) {
+		weight.AppendRow(weightrowb);
+	}
+}
+
+
+
+Matrix LoadInWeightData(const string &weightfile, int numRowPerSynapse, int numColPerSynapse, double maxConductance, double minConductance) {
 	
-	double NormalizedMin = 0;
-	double NormalizedMax = pow(2, param->synapseBit);
+	TraceFile trace;
+	if (trace.Open(weightfile)) {       // 二进制trace：尺寸取自文件头，权重直接从映射的内存中读取
+		return ConvertWeightData(trace.GetFloat32(), trace.header.numRow, trace.header.numCol, numRowPerSynapse, numColPerSynapse, maxConductance, minConductance);
+	}
 	
-	double RealMax = param->algoWeightMax;
-	double RealMin = param->algoWeightMin;
+	CsvMatrix csv;
+	if (!LoadCsvMatrix(weightfile, &csv)) {
+		cerr << "Error: the fileone cannot be opened!" << endl;
+		exit(1);
+	}
 	
-	vector<vector<double> > weight;            
+	Matrix weight;            
 	// load the data into a weight matrix ...
-	for (int row=0; row<ROW; row++) {	
+	for (int row=0; row<csv.size(); row++) {	
 		vector<double> weightrow;
 		vector<double> weightrowb;
-		getline(fileone, lineone, '\n');              
-		istringstream iss;
-		iss.str(lineone);
-		for (int col=0; col<COL; col++) {       
-			while(getline(iss, valone, ',')){	
-				istringstream fs;
-				fs.str(valone);
-				double f=0;
-				fs >> f;	
-				if ((param->memcelltype != 1)&&(param->synapseBit == param->cellBit)) { // training version: linear mapping
-					weightrow.push_back((f+1)/2*(maxConductance-minConductance)+minConductance);
-				} else {
-					//normalize weight to integer
-					double newdata = ((NormalizedMax-NormalizedMin)/(RealMax-RealMin)*(f-RealMax)+NormalizedMax);
-					if (newdata >= 0) {
-						newdata += 0.5;
-					}else {
-						newdata -= 0.5;
-					}
-					// map and expend the weight in memory array
-					int cellrange = pow(2, param->cellBit);
-					vector<int> synapsevector(numColPerSynapse);       
-					int value = newdata; 
-					if (param->BNNparallelMode) {
-						if (value == 1) {
-							weightrow.push_back(maxConductance);
-							weightrow.push_back(minConductance);
-						} else {
-							weightrow.push_back(minConductance);
-							weightrow.push_back(maxConductance);
-						}
-					} else if (param->XNORparallelMode || param->XNORsequentialMode) {
-						if (value == 1) {
-							weightrow.push_back(maxConductance);
-							weightrowb.push_back(minConductance);
-						} else {
-							weightrow.push_back(minConductance);
-							weightrowb.push_back(maxConductance);
-						}
-					} else {
-						int remainder;   
-						for (int z=0; z<numColPerSynapse; z++) {   
-							remainder = (int) value%cellrange;
-							value = (int) value/cellrange;
-							synapsevector.insert(synapsevector.begin(), value/*remainder*/);
-						}
-						for (int u=0; u<numColPerSynapse; u++) {
-							int cellvalue = synapsevector[u];
-							double conductance = cellvalue/(cellrange-1) * (maxConductance-minConductance) + minConductance;
-							weightrow.push_back(conductance);
-						}
-					}
-				}
-			}
-		}
-		if (param->XNORparallelMode || param->XNORsequentialMode) {
-			weight.push_back(weightrow);
-			weightrow.clear();
-			weight.push_back(weightrowb);
-			weightrowb.clear();
-		} else {
-			weight.push_back(weightrow);
-			weightrow.clear();
+		const double *csvRow = csv[row];
+		for (int col=0; col<csv.NumField(row); col++) {
+			AppendSynapse(csvRow[col], numColPerSynapse, maxConductance, minConductance, weightrow, weightrowb);
 		}
+		AppendWeightRow(weight, weightrow, weightrowb);
 	}
-	fileone.close();
 	
 	return weight;
-	weight.clear();
 }
 
 
 
-vector<vector<double> > CopyArray(const vector<vector<double> > &orginal, int positionRow, int positionCol, int numRow, int numCol) {
+Matrix ConvertWeightData(const float *data, int numRow, int numCol, int numRowPerSynapse, int numColPerSynapse, double maxConductance, double minConductance) {
 	
-	vector<vector<double> > copy;
-	for (int i=0; i<numRow; i++) {
-		vector<double> copyRow;
-		for (int j=0; j<numCol; j++) {
-			copyRow.push_back(orginal[positionRow+i][positionCol+j]);
+	Matrix weight;
+	for (int row=0; row<numRow; row++) {
+		vector<double> weightrow;
+		vector<double> weightrowb;
+		const float *dataRow = data + (long)row*numCol;
+		for (int col=0; col<numCol; col++) {
+			AppendSynapse(dataRow[col], numColPerSynapse, maxConductance, minConductance, weightrow, weightrowb);
 		}
-		copy.push_back(copyRow);
-		copyRow.clear();
+		AppendWeightRow(weight, weightrow, weightrowb);
 	}
 	
-	return copy;
-	copy.clear();
+	return weight;
+}
+
+
+
+MatrixView CopyArray(const MatrixView &orginal, int positionRow, int positionCol, int numRow, int numCol) {
+	
+	return orginal.SubView(positionRow, positionCol, numRow, numCol);
 } 
 
 
 
-vector<vector<double> > ReshapeArray(const vector<vector<double> > &orginal, int positionRow, int positionCol, int numRow, int numCol, int numPE, int weightMatrixRow) {
+Matrix ReshapeArray(const MatrixView &orginal, int positionRow, int positionCol, int numRow, int numCol, int numPE, int weightMatrixRow) {
 	
-	vector<vector<double> > copy;
+	// 各PE的行在原矩阵中不连续，无法用视图表示，因此整体复制到一块连续存储中
+	Matrix copy(numPE*numRow, numCol);
+	copy.CopyLevels(orginal);
 
 	for (int k=0; k<numPE; k++) {
 		for (int i=0; i<numRow; i++) {
-			vector<double> copyRow;
-			for (int j=0; j<numCol; j++) {
-				copyRow.push_back(orginal[positionRow+k*weightMatrixRow+i][positionCol+j]);
-			}
-			copy.push_back(copyRow);
-			copyRow.clear();
+			const uint8_t *orginalRow = orginal[positionRow+k*weightMatrixRow+i] + positionCol;
+			std::copy(orginalRow, orginalRow+numCol, copy[k*numRow+i]);
 		}
 	}
 	
 	return copy;
-	copy.clear();
 } 
 
 
 
-vector<vector<double> > LoadInInputData(const string &inputfile) {
+BitMatrix LoadInInputData(const string &inputfile) {
 	
-	ifstream infile(inputfile.c_str());     
-	string inputline;
-	string inputval;
+	bool XNOR = param->XNORparallelMode || param->XNORsequentialMode;
+	TraceFile trace;
+	if (trace.Open(inputfile)) {       // 二进制trace已按BitMatrix的格式打包，整列复制即可
+		return ConvertInputData(trace.GetBitMatrix());
+	}
 	
-	int ROWin=0, COLin=0;      
-	if (!infile.good()) {       
+	CsvMatrix csv;
+	if (!LoadCsvMatrix(inputfile, &csv)) {
 		cerr << "Error: the input file cannot be opened!" << endl;
 		exit(1);
-	}else{
-		while (getline(infile, inputline, '\n')) {      
-			ROWin++;                               
-		}
-		infile.clear();
-		infile.seekg(0, ios::beg);    
-		if (getline(infile, inputline, '\n')) {        
-			istringstream iss (inputline);      
-			while (getline(iss, inputval, ',')) {       
-				COLin++;
-			}
-		}	
 	}
-	infile.clear();
-	infile.seekg(0, ios::beg);          
+	int ROWin = csv.size();
+	int COLin = ROWin? csv.NumField(0) : 0;
 	
-	vector<vector<double> > inputvector;              
+	// 输入文件的每一列是一个bit平面，每个值只有0/1两种状态，按位打包存储
+	BitMatrix inputvector(XNOR? 2*ROWin : ROWin, COLin);
 	// load the data into inputvector ...
 	for (int row=0; row<ROWin; row++) {	
-		vector<double> inputvectorrow;
-		vector<double> inputvectorrowb;
-		getline(infile, inputline, '\n');             
-		istringstream iss;
-		iss.str(inputline);
+		if (csv.NumField(row) != COLin) {
+			cerr << "Error: row " << row << " of the input file has " << csv.NumField(row) << " elements, expected " << COLin << endl;
+			exit(1);
+		}
+		const double *csvRow = csv[row];
 		for (int col=0; col<COLin; col++) {
-			while(getline(iss, inputval, ',')){	
-				istringstream fs;
-				fs.str(inputval);
-				double f=0;
-				fs >> f;
-				
-				if (param->BNNparallelMode) {
-					if (f == 1) {
-						inputvectorrow.push_back(1);
-					} else {
-						inputvectorrow.push_back(0);
-					}
-				} else if (param->XNORparallelMode || param->XNORsequentialMode) {
-					if (f == 1) {
-						inputvectorrow.push_back(1);
-						inputvectorrowb.push_back(0);
-					} else {
-						inputvectorrow.push_back(0);
-						inputvectorrowb.push_back(1);
-					}
-				} else {
-					inputvectorrow.push_back(f);
-				}
+			double f = csvRow[col];
+			if (param->BNNparallelMode) {
+				inputvector.Set(row, col, f == 1);
+			} else if (XNOR) {
+				inputvector.Set(2*row, col, f == 1);
+				inputvector.Set(2*row+1, col, f != 1);
+			} else {
+				inputvector.Set(row, col, f != 0);
 			}
 		}
-		if (param->XNORparallelMode || param->XNORsequentialMode) {
-			inputvector.push_back(inputvectorrow);
-			inputvectorrow.clear();
-			inputvector.push_back(inputvectorrowb);
-			inputvectorrowb.clear();
-		} else {
-			inputvector.push_back(inputvectorrow);
-			inputvectorrow.clear();
-		}
 	}
-	// close the input file ...
-	infile.close();
 	
 	return inputvector;
-	inputvector.clear();
 }
 
 
 
-vector<vector<double> > CopyInput(const vector<vector<double> > &orginal, int positionRow, int numInputVector, int numRow) {
+BitMatrix ConvertInputData(const BitMatrixView &view) {
 	
-	vector<vector<double> > copy;
-	for (int i=0; i<numRow; i++) {
-		vector<double> copyRow;
-		for (int j=0; j<numInputVector; j++) {
-			copyRow.push_back(orginal[positionRow+i][j]);
+	bool XNOR = param->XNORparallelMode || param->XNORsequentialMode;
+	BitMatrix inputvector(XNOR? 2*view.numRow : view.numRow, view.numCol);
+	if (XNOR) {
+		for (int col=0; col<view.numCol; col++) {
+			for (int row=0; row<view.numRow; row++) {
+				bool f = view.Get(row, col);
+				inputvector.Set(2*row, col, f);
+				inputvector.Set(2*row+1, col, !f);
+			}
+		}
+	} else {
+		for (int col=0; col<view.numCol; col++) {
+			vector<uint64_t> bits;
+			view.GetColumn(col, bits);
+			std::copy(bits.begin(), bits.end(), inputvector.data.begin() + (long)col*inputvector.wordsPerColumn);
 		}
-		copy.push_back(copyRow);
-		copyRow.clear();
 	}
+	return inputvector;
+}
+
+
+
+BitMatrixView CopyInput(const BitMatrixView &orginal, int positionRow, int numInputVector, int numRow) {
 	
-	return copy;
-	copy.clear();
+	return orginal.SubView(positionRow, 0, numRow, numInputVector);
 	
 } 
 
 
 
-vector<vector<double> > ReshapeInput(const vector<vector<double> > &orginal, int positionRow, int numInputVector, int numRow, int numPE, int weightMatrixRow) {
+BitMatrix ReshapeInput(const BitMatrixView &orginal, int positionRow, int numInputVector, int numRow, int numPE, int weightMatrixRow) {
 	
-	vector<vector<double> > copy;
+	BitMatrix copy(numPE*numRow, numInputVector);
 
 	for (int k=0; k<numPE; k++) {
 		for (int i=0; i<numRow; i++) {
-			vector<double> copyRow;
 			for (int j=0; j<numInputVector; j++) {
-				copyRow.push_back(orginal[positionRow+k*weightMatrixRow+i][j]);
+				if (orginal.Get(positionRow+k*weightMatrixRow+i, j)) {
+					copy.Set(k*numRow+i, j, true);
+				}
 			}
-			copy.push_back(copyRow);
-			copyRow.clear();
 		}
 	}
 	
 	return copy;
-	copy.clear();
 } 
@@ -39,21 +39,56 @@
 #ifndef CHIP_H_
 #define CHIP_H_
 
+#include "Buffer.h"
+#include "HTree.h"
+#include "AdderTree.h"
+#include "Sigmoid.h"
+#include "BitShifter.h"
+#include "MaxPooling.h"
+#include "DRAM.h"
+#include "WeightGradientUnit.h"
+#include "Adder.h"
+#include "Tile.h"
+
+class SimulationContext;
+struct LayerData;
+
+// Chip级模块实例（包含Tile和PE的模块），由SimulationContext持有
+struct ChipComponents {
+	Buffer *globalBuffer;
+	HTree *GhTree;
+	AdderTree *Gaccumulation;
+	Sigmoid *Gsigmoid;
+	BitShifter *GreLu;
+	MaxPooling *maxPool;
+	DRAM *dRAM;
+	WeightGradientUnit *weightGradientUnit;
+	Adder *gradientAccum;
+	double globalBusWidth;
+	int numBufferCore;
+	TileComponents tile;
+};
+
 /*** Functions ***/
-vector<int> ChipDesignInitialize(InputParameter& inputParameter, Technology& tech, MemCell& cell, bool pip, const vector<vector<double> > &netStructure,
+ChipComponents ChipGetComponents();		// 当前线程的模块实例
+ChipComponents ChipCopyComponents(const ChipComponents &original);
+void ChipSetComponents(const ChipComponents &components);	// 当前线程改为使用给定的模块实例
+void ChipDeleteComponents(ChipComponents &components);
+
+vector<int> ChipDesignInitialize(SimulationContext& context, bool pip, const vector<vector<double> > &netStructure,
 					double *maxPESizeNM, double *maxTileSizeCM, double *numPENM);
 					
-vector<vector<double> > ChipFloorPlan(bool findNumTile, bool findUtilization, bool findSpeedUp, const vector<vector<double> > &netStructure, const vector<int > &markNM, 
+vector<vector<double> > ChipFloorPlan(SimulationContext& context, bool findNumTile, bool findUtilization, bool findSpeedUp, const vector<vector<double> > &netStructure, const vector<int > &markNM, 
 					double maxPESizeNM, double maxTileSizeCM, double numPENM, const vector<int> &pipelineSpeedUp,
 					double *desiredNumTileNM, double *desiredPESizeNM, double *desiredNumTileCM, double *desiredTileSizeCM, double *desiredPESizeCM, int *numTileRow, int *numTileCol);
 					
-void ChipInitialize(InputParameter& inputParameter, Technology& tech, MemCell& cell, const vector<vector<double> > &netStructure, const vector<int > &markNM, const vector<vector<double> > &numTileEachLayer,
+void ChipInitialize(SimulationContext& context, const vector<vector<double> > &netStructure, const vector<int > &markNM, const vector<vector<double> > &numTileEachLayer,
 					double numPENM, double desiredNumTileNM, double desiredPESizeNM, double desiredNumTileCM, double desiredTileSizeCM, double desiredPESizeCM, int numTileRow, int numTileCol, int *numArrayWriteParallel);
 					
-vector<double> ChipCalculateArea(InputParameter& inputParameter, Technology& tech, MemCell& cell, double desiredNumTileNM, double numPENM, double desiredPESizeNM, double desiredNumTileCM, double desiredTileSizeCM, double desiredPESizeCM, 
+vector<double> ChipCalculateArea(SimulationContext& context, double desiredNumTileNM, double numPENM, double desiredPESizeNM, double desiredNumTileCM, double desiredTileSizeCM, double desiredPESizeCM, 
 						int numTileRow, double *height, double *width, double *CMTileheight, double *CMTilewidth, double *NMTileheight, double *NMTilewidth);
 						
-double ChipCalculatePerformance(InputParameter& inputParameter, Technology& tech, MemCell& cell, int layerNumber, const string &newweightfile, const string &oldweightfile, const string &inputfile, bool followedByMaxPool, const vector<vector<double> > &netStructure, 
+double ChipCalculatePerformance(SimulationContext& context, int layerNumber, const string &newweightfile, const string &oldweightfile, const string &inputfile, bool followedByMaxPool, const vector<vector<double> > &netStructure, 
 							const vector<int> &markNM, int digital, int seq_len, int seq_len_total, const vector<vector<double> > &numTileEachLayer, const vector<vector<double> > &utilizationEachLayer, const vector<vector<double> > &speedUpEachLayer,  //对于chip来说，不区分该任务是否为完整推理，只根据获取的输入长度以及当前的KV缓存大小计算对应生成一个token的延迟和能耗具体管理在Main中进行
 							const vector<vector<double> > &tileLocaEachLayer, double numPENM, double desiredPESizeNM, double desiredTileSizeCM, double desiredPESizeCM,	//使用digital来表征是否为数字计算
 							double CMTileheight, double CMTilewidth, double NMTileheight, double NMTilewidth, int numArrayWriteParallel, double *readLatency, double *readDynamicEnergy, 
@@ -61,7 +96,7 @@ double ChipCalculatePerformance(InputParameter& inputParameter, Technology& tech
 							double *bufferLatency, double *bufferDynamicEnergy, double *icLatency, double *icDynamicEnergy,double *coreLatencyADC, double *coreLatencyAccum, 
 							double *coreLatencyOther, double *coreEnergyADC, double *coreEnergyAccum, double *coreEnergyOther, double *dramLatency, double *dramDynamicEnergy,
 							double *readLatencyPeakFW, double *readDynamicEnergyPeakFW, double *readLatencyPeakAG, double *readDynamicEnergyPeakAG, double *readLatencyPeakWG, double *readDynamicEnergyPeakWG,
-							double *writeLatencyPeakWU, double *writeDynamicEnergyPeakWU);
+							double *writeLatencyPeakWU, double *writeDynamicEnergyPeakWU, const LayerData *preloaded = NULL);	// preloaded为NULL时在函数内读入该层的文件
 							
 vector<double> TileDesignCM(double tileSize, const vector<int > &markNM, const vector<vector<double> > &netStructure, int numRowPerSynapse, int numColPerSynapse);
 vector<double> TileDesignNM(double peSize, const vector<int > &markNM, const vector<vector<double> > &netStructure, int numRowPerSynapse, int numColPerSynapse, double numPENM);
@@ -70,11 +105,13 @@ vector<vector<double> > SubArrayDup(double desiredPESizeCM, double desiredPESize
 vector<vector<double> > OverallEachLayer(bool utilization, bool speedUp, const vector<vector<double> > &peDup, const vector<vector<double> > &subArrayDup, const vector<int> &pipelineSpeedUp, double desiredTileSizeCM, 
 										double desiredPESizeNM, const vector<int > &markNM, const vector<vector<double> > &netStructure, int numRowPerSynapse, int numColPerSynapse, double numPENM);
 
-vector<vector<double> > LoadInWeightData(const string &weightfile, int numRowPerSynapse, int numColPerSynapse, double maxConductance, double minConductance);
-vector<vector<double> > CopyArray(const vector<vector<double> > &orginal, int positionRow, int positionCol, int numRow, int numCol);
-vector<vector<double> > ReshapeArray(const vector<vector<double> > &orginal, int positionRow, int positionCol, int numRow, int numCol, int numPE, int weightMatrixRow);
-vector<vector<double> > LoadInInputData(const string &inputfile);
-vector<vector<double> > CopyInput(const vector<vector<double> > &orginal, int positionRow, int numInputVector, int numRow);
-vector<vector<double> > ReshapeInput(const vector<vector<double> > &orginal, int positionRow, int numInputVector, int numRow, int numPE, int weightMatrixRow);
+Matrix LoadInWeightData(const string &weightfile, int numRowPerSynapse, int numColPerSynapse, double maxConductance, double minConductance);
+Matrix ConvertWeightData(const float *data, int numRow, int numCol, int numRowPerSynapse, int numColPerSynapse, double maxConductance, double minConductance);	// data为行主序的numRow x numCol矩阵
+MatrixView CopyArray(const MatrixView &orginal, int positionRow, int positionCol, int numRow, int numCol);
+Matrix ReshapeArray(const MatrixView &orginal, int positionRow, int positionCol, int numRow, int numCol, int numPE, int weightMatrixRow);
+BitMatrix LoadInInputData(const string &inputfile);
+BitMatrix ConvertInputData(const BitMatrixView &view);	// 复制为连续存储，XNOR模式下每一行展开为正、反两行
+BitMatrixView CopyInput(const BitMatrixView &orginal, int positionRow, int numInputVector, int numRow);
+BitMatrix ReshapeInput(const BitMatrixView &orginal, int positionRow, int numInputVector, int numRow, int numPE, int weightMatrixRow);
 
 #endif /* CHIP_H_ */
\ No newline at end of file
@@ -0,0 +1,179 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#include <algorithm>
+#include <vector>
+#include "ConductanceKernel.h"
+
+using namespace std;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONDUCTANCE_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+void ColumnConductanceBatchScalar(const double *conductance, int numCol, int numRow, const uint64_t *mask, int numVector, double *columnG) {
+	int numWord = (numRow + 63) >> 6;
+	for (int v=0; v<numVector; v++) {
+		const uint64_t *vectorMask = mask + (long)v*numWord;
+		for (int j=0; j<numCol; j++) {
+			const double *column = conductance + (long)j*numRow;
+			double sum = 0;
+			for (int w=0; w<numWord; w++) {
+				uint64_t bits = vectorMask[w];
+				while (bits) {	// 只遍历被激活的行，按行号从小到大累加
+					sum += column[(w << 6) + __builtin_ctzll(bits)];
+					bits &= bits - 1;
+				}
+			}
+			columnG[(long)v*numCol + j] = sum;
+		}
+	}
+}
+
+// 把numLane个输入向量的第i行的激活位收集到laneMask[i]的第0~numLane-1位，作为SIMD各lane的掩码
+static void GatherLaneMask(const uint64_t *mask, int numWord, int numRow, int numLane, unsigned char *laneMask) {
+	for (int i=0; i<numRow; i++) {
+		unsigned char bits = 0;
+		for (int l=0; l<numLane; l++) {
+			bits |= ((mask[(long)l*numWord + (i >> 6)] >> (i & 63)) & 1) << l;
+		}
+		laneMask[i] = bits;
+	}
+}
+
+#ifdef CONDUCTANCE_KERNEL_X86
+
+// 每个lane对应一个输入向量，每个lane内仍按行号从小到大累加，因此结果与标量版本逐位一致
+// 一次处理4列，4个累加器共用同一行的lane掩码，隐藏加法延迟
+__attribute__((target("avx2")))
+static void ColumnConductanceBatchAVX2(const double *conductance, int numCol, int numRow, const uint64_t *mask, int numVector, double *columnG) {
+	int numWord = (numRow + 63) >> 6;
+	vector<unsigned char> laneMask(numRow);
+	const __m256i lane = _mm256_set_epi64x(8, 4, 2, 1);
+	double sum[4][4];
+	for (int v0=0; v0<numVector; v0+=4) {
+		int numLane = min(4, numVector - v0);
+		GatherLaneMask(mask + (long)v0*numWord, numWord, numRow, numLane, &laneMask[0]);
+		for (int j0=0; j0<numCol; j0+=4) {
+			int numColBlock = min(4, numCol - j0);
+			const double *column[4];
+			for (int c=0; c<4; c++) {
+				column[c] = conductance + (long)(j0 + min(c, numColBlock-1))*numRow;	// 不足4列时重复计算最后一列
+			}
+			__m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd(), sum2 = _mm256_setzero_pd(), sum3 = _mm256_setzero_pd();
+			for (int i=0; i<numRow; i++) {
+				if (laneMask[i] == 0) {
+					continue;
+				}
+				__m256d active = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(laneMask[i]), lane), lane));
+				sum0 = _mm256_add_pd(sum0, _mm256_and_pd(active, _mm256_set1_pd(column[0][i])));
+				sum1 = _mm256_add_pd(sum1, _mm256_and_pd(active, _mm256_set1_pd(column[1][i])));
+				sum2 = _mm256_add_pd(sum2, _mm256_and_pd(active, _mm256_set1_pd(column[2][i])));
+				sum3 = _mm256_add_pd(sum3, _mm256_and_pd(active, _mm256_set1_pd(column[3][i])));
+			}
+			_mm256_storeu_pd(sum[0], sum0);
+			_mm256_storeu_pd(sum[1], sum1);
+			_mm256_storeu_pd(sum[2], sum2);
+			_mm256_storeu_pd(sum[3], sum3);
+			for (int l=0; l<numLane; l++) {
+				for (int c=0; c<numColBlock; c++) {
+					columnG[(long)(v0 + l)*numCol + j0 + c] = sum[c][l];
+				}
+			}
+		}
+	}
+}
+
+__attribute__((target("avx512f")))
+static void ColumnConductanceBatchAVX512(const double *conductance, int numCol, int numRow, const uint64_t *mask, int numVector, double *columnG) {
+	int numWord = (numRow + 63) >> 6;
+	vector<unsigned char> laneMask(numRow);
+	double sum[4][8];
+	for (int v0=0; v0<numVector; v0+=8) {
+		int numLane = min(8, numVector - v0);
+		GatherLaneMask(mask + (long)v0*numWord, numWord, numRow, numLane, &laneMask[0]);
+		for (int j0=0; j0<numCol; j0+=4) {
+			int numColBlock = min(4, numCol - j0);
+			const double *column[4];
+			for (int c=0; c<4; c++) {
+				column[c] = conductance + (long)(j0 + min(c, numColBlock-1))*numRow;
+			}
+			__m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd(), sum2 = _mm512_setzero_pd(), sum3 = _mm512_setzero_pd();
+			for (int i=0; i<numRow; i++) {
+				__mmask8 active = laneMask[i];
+				if (active == 0) {
+					continue;
+				}
+				sum0 = _mm512_mask_add_pd(sum0, active, sum0, _mm512_set1_pd(column[0][i]));
+				sum1 = _mm512_mask_add_pd(sum1, active, sum1, _mm512_set1_pd(column[1][i]));
+				sum2 = _mm512_mask_add_pd(sum2, active, sum2, _mm512_set1_pd(column[2][i]));
+				sum3 = _mm512_mask_add_pd(sum3, active, sum3, _mm512_set1_pd(column[3][i]));
+			}
+			_mm512_storeu_pd(sum[0], sum0);
+			_mm512_storeu_pd(sum[1], sum1);
+			_mm512_storeu_pd(sum[2], sum2);
+			_mm512_storeu_pd(sum[3], sum3);
+			for (int l=0; l<numLane; l++) {
+				for (int c=0; c<numColBlock; c++) {
+					columnG[(long)(v0 + l)*numCol + j0 + c] = sum[c][l];
+				}
+			}
+		}
+	}
+}
+
+#endif
+
+static ColumnConductanceBatchKernel SelectColumnConductanceBatchKernel() {
+#ifdef CONDUCTANCE_KERNEL_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		return ColumnConductanceBatchAVX512;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		return ColumnConductanceBatchAVX2;
+	}
+#endif
+	return ColumnConductanceBatchScalar;
+}
+
+ColumnConductanceBatchKernel GetColumnConductanceBatchKernel() {
+	static ColumnConductanceBatchKernel kernel = SelectColumnConductanceBatchKernel();
+	return kernel;
+}
@@ -0,0 +1,55 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#ifndef CONDUCTANCEKERNEL_H_
+#define CONDUCTANCEKERNEL_H_
+
+#include <stdint.h>
+
+// 批量列电导求和（G^T X）：columnG[v*numCol+j] = sum_i mask_v(i) ? conductance[j*numRow+i] : 0
+// conductance为subArray每个单元的等效电导（已计入行/列导线电阻和access电阻），按列连续存储
+// mask为numVector个按行打包的输入bit平面，每个占(numRow+63)/64个字，第i行位于第i/64个字的第i%64位
+// 每个输出都按行号从小到大累加，各实现的结果逐位一致
+typedef void (*ColumnConductanceBatchKernel)(const double *conductance, int numCol, int numRow, const uint64_t *mask, int numVector, double *columnG);
+
+// 根据运行时检测到的CPU特性（AVX-512F / AVX2）选择实现，否则使用标量版本
+ColumnConductanceBatchKernel GetColumnConductanceBatchKernel();
+
+void ColumnConductanceBatchScalar(const double *conductance, int numCol, int numRow, const uint64_t *mask, int numVector, double *columnG);
+
+#endif /* CONDUCTANCEKERNEL_H_ */
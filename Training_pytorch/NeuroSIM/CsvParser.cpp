@@ -0,0 +1,141 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "CsvParser.h"
+
+using namespace std;
+
+CsvMatrix::CsvMatrix() {
+	rowStart.push_back(0);
+}
+
+// 解析[begin, end)中的各行（end处为行尾或文件尾），值追加到values，每行结束时把values的长度追加到rowEnd
+static void ParseLines(const char *begin, const char *end, vector<double> &values, vector<long> &rowEnd) {
+	const char *line = begin;
+	while (line < end) {
+		const char *lineEnd = (const char *) memchr(line, '\n', end - line);
+		if (lineEnd == NULL) {
+			lineEnd = end;
+		}
+		const char *field = line;
+		while (field < lineEnd) {
+			const char *comma = (const char *) memchr(field, ',', lineEnd - field);
+			const char *fieldEnd = comma? comma : lineEnd;
+			char *parsed;
+			double f = strtod(field, &parsed);
+			if (parsed == field || parsed > fieldEnd) {	// 空字段：strtod可能越过行尾去解析下一行
+				f = 0;
+			}
+			values.push_back(f);
+			if (comma == NULL) {
+				break;
+			}
+			field = comma + 1;
+		}
+		rowEnd.push_back(values.size());
+		line = lineEnd + 1;
+	}
+}
+
+bool LoadCsvMatrix(const string &filename, CsvMatrix *matrix) {
+	FILE *file = fopen(filename.c_str(), "rb");
+	if (file == NULL) {
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	vector<char> buffer(length + 1);
+	if (length > 0 && fread(&buffer[0], 1, length, file) != (size_t) length) {
+		fclose(file);
+		return false;
+	}
+	fclose(file);
+	buffer[length] = '\0';		// strtod需要结尾的'\0'
+	
+	const char *begin = &buffer[0];
+	const char *end = begin + length;
+	matrix->values.clear();
+	matrix->rowStart.assign(1, 0);
+	
+	int numChunk = (length > CSV_PARALLEL_THRESHOLD && !omp_in_parallel())? omp_get_max_threads() : 1;
+	if (numChunk <= 1) {
+		matrix->values.reserve(length / 4);
+		ParseLines(begin, end, matrix->values, matrix->rowStart);
+		return true;
+	}
+	
+	// 每块从某一行的开头开始，到下一块的开头结束
+	vector<const char *> chunkBegin(numChunk + 1, end);
+	chunkBegin[0] = begin;
+	for (int k=1; k<numChunk; k++) {
+		const char *p = begin + length / numChunk * k;
+		if (p < chunkBegin[k-1]) {
+			p = chunkBegin[k-1];
+		}
+		const char *lineEnd = (const char *) memchr(p, '\n', end - p);
+		chunkBegin[k] = lineEnd? lineEnd + 1 : end;
+	}
+	vector<vector<double> > chunkValues(numChunk);
+	vector<vector<long> > chunkRowEnd(numChunk);
+	#pragma omp parallel for num_threads(numChunk)
+	for (int k=0; k<numChunk; k++) {
+		chunkValues[k].reserve((chunkBegin[k+1] - chunkBegin[k]) / 4);
+		ParseLines(chunkBegin[k], chunkBegin[k+1], chunkValues[k], chunkRowEnd[k]);
+	}
+	
+	long numValue = 0, numRow = 0;
+	for (int k=0; k<numChunk; k++) {
+		numValue += chunkValues[k].size();
+		numRow += chunkRowEnd[k].size();
+	}
+	matrix->values.reserve(numValue);
+	matrix->rowStart.reserve(numRow + 1);
+	for (int k=0; k<numChunk; k++) {
+		long offset = matrix->values.size();
+		matrix->values.insert(matrix->values.end(), chunkValues[k].begin(), chunkValues[k].end());
+		for (size_t r=0; r<chunkRowEnd[k].size(); r++) {
+			matrix->rowStart.push_back(offset + chunkRowEnd[k][r]);
+		}
+	}
+	return true;
+}
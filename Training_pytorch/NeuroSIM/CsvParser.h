@@ -0,0 +1,67 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#ifndef CSVPARSER_H_
+#define CSVPARSER_H_
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 单遍解析的CSV数值矩阵：整个文件一次读入，按行切分后直接把各字段转换为double，按行主序连续存储
+// 行、字段的划分与原先getline('\n') + getline(',')的结果一致：行尾多余的一个逗号不计为字段，
+// 空字段或无法解析的字段为0；各行的字段数可以不同
+class CsvMatrix {
+public:
+	CsvMatrix();
+
+	int size() const { return rowStart.size() - 1; }
+	int NumField(int row) const { return rowStart[row+1] - rowStart[row]; }
+	const double *operator[](int row) const { return values.empty()? NULL : &values[0] + rowStart[row]; }
+
+	vector<double> values;
+	vector<long> rowStart;		// 第row行的值为values[rowStart[row], rowStart[row+1])
+};
+
+// 文件大于该值时按行切分成多块，由OpenMP线程并行解析
+#define CSV_PARALLEL_THRESHOLD	(4 << 20)
+
+bool LoadCsvMatrix(const string &filename, CsvMatrix *matrix);	// 文件无法打开时返回false
+
+#endif /* CSVPARSER_H_ */
@@ -45,7 +45,7 @@
 #include "CurrentSenseAmp.h"
 
 using namespace std;
-extern Param *param;
+extern thread_local Param *param;
 
 CurrentSenseAmp::CurrentSenseAmp(const InputParameter& _inputParameter, const Technology& _tech, const MemCell& _cell): inputParameter(_inputParameter), tech(_tech), cell(_cell), FunctionUnit() {
 	// TODO Auto-generated constructor stub
@@ -112,6 +112,9 @@ void CurrentSenseAmp::CalculateLatency(const vector<double> &columnResistance, d
 	if (!initialized) {
 		cout << "[CurrentSenseAmp] Error: Require initialization first!" << endl;
 	} else {
+		lastCall.latencyCalculated = true;
+		lastCall.numColMuxed = numColMuxed;
+		lastCall.numReadLatency = numRead;
 		double Group = numCol/numColMuxed;
 		double LatencyCol = 0;
 		readLatency = 0;
@@ -135,6 +138,8 @@ void CurrentSenseAmp::CalculatePower(const vector<double> &columnResistance, dou
 	if (!initialized) {
 		cout << "[CurrentSenseAmp] Error: Require initialization first!" << endl;
 	} else {
+		lastCall.powerCalculated = true;
+		lastCall.numReadPower = numRead;
 		leakage = 0;
 		readDynamicEnergy = 0;
 		for (double i=0; i<columnResistance.size(); i++) {
@@ -147,6 +152,20 @@ void CurrentSenseAmp::CalculatePower(const vector<double> &columnResistance, dou
 	}
 }
 
+void CurrentSenseAmp::RecalculateBatch(const double *columnResistance, int numVector, int numColumn, double *latency, double *energy) {
+	for (int v=0; v<numVector; v++) {
+		vector<double> res(columnResistance + (long)v*numColumn, columnResistance + (long)(v+1)*numColumn);
+		if (lastCall.latencyCalculated) {
+			CalculateLatency(res, lastCall.numColMuxed, lastCall.numReadLatency);
+		}
+		if (lastCall.powerCalculated) {
+			CalculatePower(res, lastCall.numReadPower);
+		}
+		latency[v] = readLatency;
+		energy[v] = readDynamicEnergy;
+	}
+}
+
 
 double CurrentSenseAmp::GetColumnLatency(double columnRes) {
 	double Column_Latency = 0;
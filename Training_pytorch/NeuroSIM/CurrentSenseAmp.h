@@ -63,6 +63,7 @@ public:
 	void CalculateArea(double _widthCurrentSenseAmp);
 	void CalculateLatency(const vector<double> &columnResistance, double numColMuxed, double numRead);
 	void CalculatePower(const vector<double> &columnResistance, double numRead);
+	void RecalculateBatch(const double *columnResistance, int numVector, int numColumn, double *latency, double *energy);	// 按lastCall的参数逐个输入向量重新计算，未调用过的部分输出当前结果
 	void CalculateUnitArea();
 	double GetColumnLatency(double columnRes);
 	double GetColumnPower(double columnRes);
@@ -80,6 +81,7 @@ public:
 	bool rowbyrow;
 	double clkFreq, Rref;
 	int numReadCellPerOperationNeuro;
+	ReadoutCall lastCall;
 };
 
 #endif /* CURRENTSENSEAMP_H_ */
\ No newline at end of file
@@ -46,7 +46,7 @@
 
 using namespace std;
 
-extern Param *param;
+extern thread_local Param *param;
 
 DRAM::DRAM(const InputParameter& _inputParameter, const Technology& _tech, const MemCell& _cell): inputParameter(_inputParameter), tech(_tech), cell(_cell), FunctionUnit() {
 	initialized = false;
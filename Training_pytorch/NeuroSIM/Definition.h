@@ -39,12 +39,8 @@
 // This file cannot be compiled alone. Only include this file in main.cpp.
 
 /* Global variables */
-Param *param = new Param(); // Parameter set
-
-/* Random number generator engine */
-std::mt19937 gen;
-
-InputParameter inputParameter;
-Technology tech;
-MemCell cell;
+SimulationContext context; // Parameter set, technology, memory cell and circuit modules of this run
+InputParameter& inputParameter = *context.inputParameter;
+Technology& tech = *context.tech;
+MemCell& cell = *context.cell;
 
@@ -64,4 +64,11 @@ public:
 	double readPower, writePower;
 };
 
+// 读出电路（SA/ADC）上一次CalculateLatency/CalculatePower的参数，只有columnResistance改变时据此重新计算
+struct ReadoutCall {
+	ReadoutCall(): latencyCalculated(false), powerCalculated(false), numColMuxed(0), numReadLatency(0), numReadPower(0) {}
+	bool latencyCalculated, powerCalculated;	// 由调用者清零
+	double numColMuxed, numReadLatency, numReadPower;
+};
+
 #endif /* FUNCTIONUNIT_H_ */
@@ -46,7 +46,7 @@
 
 using namespace std;
 
-extern Param *param;
+extern thread_local Param *param;
 
 HTree::HTree(const InputParameter& _inputParameter, const Technology& _tech, const MemCell& _cell): inputParameter(_inputParameter), tech(_tech), cell(_cell), FunctionUnit() {
 	initialized = false;
@@ -113,6 +113,7 @@ void HTree::Initialize(int _numRow, int _numCol, double _delaytolerance, double
 	find_stage = 0;   // assume the top stage as find_stage = 0
 	hit = 0;
 	skipVer = 0;
+	readCost.clear();
 	
 	initialized = true;
 }
@@ -166,6 +167,7 @@ void HTree::CalculateArea(double unitHeight, double unitWidth, double foldedrati
 		// Capacitance
 		// INV
 		CalculateGateCapacitance(INV, 1, widthInvN, widthInvP, hInv, tech, &capInvInput, &capInvOutput);
+		readCost.clear();
 		
 	}
 }
@@ -182,33 +184,44 @@ void HTree::CalculateLatency(int x_init, int y_init, int x_end, int y_end, doubl
 		double resOnRep = CalculateOnResistance(widthInvN, NMOS, inputParameter.temperature, tech) + CalculateOnResistance(widthInvP, PMOS, inputParameter.temperature, tech);
 		
 		if (((!x_init) && (!y_init)) || ((!x_end) && (!y_end))) {      // root-leaf communicate (fixed addr)
-			for (int i=0; i<(numStage-1)/2; i++) {                     // ignore main bus here, but need to count until last stage (diff from area calculation)
-				double wireWidth, unitLengthWireResistance;
-				unitLatencyRep = 0.7*(resOnRep*(capInvInput+capInvOutput+unitLengthWireCap*minDist)+0.5*unitLengthWireResistance*minDist*unitLengthWireCap*minDist+unitLengthWireResistance*minDist*capInvInput)/minDist;
-				unitLatencyWire = 0.7*unitLengthWireResistance*minDist*unitLengthWireCap*minDist/minDist;
+			HTreeReadCost &cost = readCost[make_pair(unitHeight, unitWidth)];
+			if (cost.latencyCalculated) {   // 同一尺寸的单次读出延迟不变，直接复用
+				readLatency = cost.latencyPerRead;
+				unitLatencyRep = cost.unitLatencyRep;
+				unitLatencyWire = cost.unitLatencyWire;
+			} else {
+				double wireWidth, unitLengthWireResistance = 0;	// 原先为未初始化的局部变量（第一级按0处理），缓存后须显式给出
+				for (int i=0; i<(numStage-1)/2; i++) {                     // ignore main bus here, but need to count until last stage (diff from area calculation)
+					unitLatencyRep = 0.7*(resOnRep*(capInvInput+capInvOutput+unitLengthWireCap*minDist)+0.5*unitLengthWireResistance*minDist*unitLengthWireCap*minDist+unitLengthWireResistance*minDist*capInvInput)/minDist;
+					unitLatencyWire = 0.7*unitLengthWireResistance*minDist*unitLengthWireCap*minDist/minDist;
 			
-				/*** vertical stage ***/
-				wireLengthV /= 2;   // wire length /2 
-				wireWidth, unitLengthWireResistance = GetUnitLengthRes(wireLengthV);
-				numRepeater = ceil(wireLengthV/minDist);
-				if (numRepeater > 0) {
-					readLatency += wireLengthV*unitLatencyRep;
-				} else {
-					readLatency += wireLengthV*unitLatencyWire;
-				}
+					/*** vertical stage ***/
+					wireLengthV /= 2;   // wire length /2 
+					wireWidth, unitLengthWireResistance = GetUnitLengthRes(wireLengthV);
+					numRepeater = ceil(wireLengthV/minDist);
+					if (numRepeater > 0) {
+						readLatency += wireLengthV*unitLatencyRep;
+					} else {
+						readLatency += wireLengthV*unitLatencyWire;
+					}
 				
-				/*** horizontal stage ***/
-				wireLengthH /= 2;   // wire length /2 
-				wireWidth, unitLengthWireResistance = GetUnitLengthRes(wireLengthH);
-				numRepeater = ceil(wireLengthH/minDist);
-				if (numRepeater > 0) {
-					readLatency += wireLengthH*unitLatencyRep;
-				} else {
-					readLatency += wireLengthH*unitLatencyWire;
+					/*** horizontal stage ***/
+					wireLengthH /= 2;   // wire length /2 
+					wireWidth, unitLengthWireResistance = GetUnitLengthRes(wireLengthH);
+					numRepeater = ceil(wireLengthH/minDist);
+					if (numRepeater > 0) {
+						readLatency += wireLengthH*unitLatencyRep;
+					} else {
+						readLatency += wireLengthH*unitLatencyWire;
+					}
 				}
+				/*** main bus ***/
+				readLatency += min(numCol-x_center, x_center)*unitWidth*unitLatencyRep;
+				cost.latencyCalculated = true;
+				cost.latencyPerRead = readLatency;
+				cost.unitLatencyRep = unitLatencyRep;
+				cost.unitLatencyWire = unitLatencyWire;
 			}
-			/*** main bus ***/
-			readLatency += min(numCol-x_center, x_center)*unitWidth*unitLatencyRep;
 		} else {       // leaf-leaf communicate
 			/*** firstly need to find the zone of two units ***/
 			/*** in each level, the units are defined as 4 zones, which used to decide the travel distance
@@ -301,26 +314,33 @@ void HTree::CalculatePower(int x_init, int y_init, int x_end, int y_end, double
 		double wireLengthH = unitWidth*pow(2, (numStage-1)/2)/2;    // first horizontal stage (despite of main bus)
 		
 		if (((!x_init) && (!y_init)) || ((!x_end) && (!y_end))) {      // root-leaf communicate (fixed addr)
-			for (int i=0; i<(numStage-1)/2; i++) {                     // ignore main bus here, but need to count until last stage (diff from area calculation)
-				/*** vertical stage ***/
-				wireLengthV /= 2;   // wire length /2 
-				numRepeater = ceil(wireLengthV/minDist);
-				if (numRepeater > 0) {
-					readDynamicEnergy += wireLengthV*unitLengthEnergyRep;
-				} else {
-					readDynamicEnergy += wireLengthV*unitLengthEnergyWire;
-				}
-				/*** horizontal stage ***/
-				wireLengthH /= 2;   // wire length /2 
-				numRepeater = ceil(wireLengthH/minDist);
-				if (numRepeater > 0) {
-					readDynamicEnergy += wireLengthH*unitLengthEnergyRep;
-				} else {
-					readDynamicEnergy += wireLengthH*unitLengthEnergyWire;
+			HTreeReadCost &cost = readCost[make_pair(unitHeight, unitWidth)];
+			if (cost.powerCalculated) {
+				readDynamicEnergy = cost.energyPerBit;
+			} else {
+				for (int i=0; i<(numStage-1)/2; i++) {                     // ignore main bus here, but need to count until last stage (diff from area calculation)
+					/*** vertical stage ***/
+					wireLengthV /= 2;   // wire length /2 
+					numRepeater = ceil(wireLengthV/minDist);
+					if (numRepeater > 0) {
+						readDynamicEnergy += wireLengthV*unitLengthEnergyRep;
+					} else {
+						readDynamicEnergy += wireLengthV*unitLengthEnergyWire;
+					}
+					/*** horizontal stage ***/
+					wireLengthH /= 2;   // wire length /2 
+					numRepeater = ceil(wireLengthH/minDist);
+					if (numRepeater > 0) {
+						readDynamicEnergy += wireLengthH*unitLengthEnergyRep;
+					} else {
+						readDynamicEnergy += wireLengthH*unitLengthEnergyWire;
+					}
 				}
+				/*** main bus ***/
+				readDynamicEnergy += min(numCol-x_center, x_center)*unitWidth*unitLengthEnergyRep;
+				cost.powerCalculated = true;
+				cost.energyPerBit = readDynamicEnergy;
 			}
-			/*** main bus ***/
-			readDynamicEnergy += min(numCol-x_center, x_center)*unitWidth*unitLengthEnergyRep;
 			readDynamicEnergy *= numBitAccess;  
 		} else {       // leaf-leaf communicate
 			/*** count the top find_stage, whether pass the vertical bus or not) ***/
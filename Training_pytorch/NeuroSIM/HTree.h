@@ -39,12 +39,21 @@
 #ifndef HTREE_H_
 #define HTREE_H_
 
+#include <map>
 #include "typedef.h"
 #include "InputParameter.h"
 #include "Technology.h"
 #include "MemCell.h"
 #include "FunctionUnit.h"
 
+// root-leaf通信的单次读出代价只与单元尺寸有关，按(unitHeight, unitWidth)缓存
+struct HTreeReadCost {
+	HTreeReadCost(): latencyCalculated(false), powerCalculated(false), latencyPerRead(0), unitLatencyRep(0), unitLatencyWire(0), energyPerBit(0) {}
+	bool latencyCalculated, powerCalculated;
+	double latencyPerRead, unitLatencyRep, unitLatencyWire;
+	double energyPerBit;
+};
+
 class HTree: public FunctionUnit {
 public:
 	HTree(const InputParameter& _inputParameter, const Technology& _tech, const MemCell& _cell);
@@ -73,6 +82,7 @@ public:
 	double unitLatencyRep, unitLatencyWire, unitLengthLeakage, unitLengthEnergyRep, unitLengthEnergyWire;
 	double find_stage;
 	int x_center, y_center, hit, skipVer;
+	std::map<std::pair<double, double>, HTreeReadCost> readCost;	// Initialize/CalculateArea时清空
 
 };
 
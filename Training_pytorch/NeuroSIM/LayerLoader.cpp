@@ -0,0 +1,197 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include "Param.h"
+#include "Chip.h"
+#include "SimulationContext.h"
+#include "LayerLoader.h"
+
+using namespace std;
+
+long LayerData::Bytes() const {
+	long bytes = inputVector.data.size() * sizeof(uint64_t) + newMemory.data.size() + oldMemory.data.size();
+	if (inputTrace.IsOpen()) {
+		bytes += (long) inputView.numCol * inputView.wordsPerColumn * sizeof(uint64_t);
+	}
+	return bytes;
+}
+
+bool GetLayerFileShape(const string &filename, int *numRow, int *numCol, string *error) {
+	TraceHeader header;
+	int status = TraceFile::ReadHeader(filename, &header, error);
+	if (status < 0) {
+		return false;
+	} else if (status > 0) {
+		*numRow = header.numRow;
+		*numCol = header.numCol;
+		return true;
+	}
+	
+	FILE *file = fopen(filename.c_str(), "rb");
+	if (file == NULL) {
+		*error = "the trace file " + filename + " cannot be opened";
+		return false;
+	}
+	// 行和字段的划分与LoadCsvMatrix相同：行尾多余的一个逗号不计为字段
+	vector<char> buffer(1 << 20);
+	int row = 0, col = -1;
+	long numComma = 0, lineLength = 0;
+	char last = '\0';
+	bool consistent = true;
+	size_t length;
+	do {
+		length = fread(&buffer[0], 1, buffer.size(), file);
+		for (size_t k=0; k<=length && consistent; k++) {
+			if (k < length && buffer[k] != '\n') {
+				numComma += (buffer[k] == ',');
+				last = buffer[k];
+				lineLength++;
+				continue;
+			}
+			if (k == length && (length == buffer.size() || lineLength == 0)) {
+				break;		// 行在下一块中继续，或文件以换行结尾
+			}
+			int numField = lineLength? numComma + (last != ',') : 0;
+			if (col < 0) {
+				col = numField;
+			} else if (numField != col) {
+				ostringstream message;
+				message << "row " << row << " of the trace file " << filename << " has " << numField << " elements, expected " << col;
+				*error = message.str();
+				consistent = false;
+			}
+			row++;
+			numComma = 0;
+			lineLength = 0;
+		}
+	} while (length == buffer.size() && consistent);
+	fclose(file);
+	*numRow = row;
+	*numCol = col < 0? 0 : col;
+	return consistent;
+}
+
+void LoadLayerData(const LayerFiles &files, LayerData *data) {
+	if (data->inputTrace.Open(files.input) && !(param->XNORparallelMode || param->XNORsequentialMode)) {
+		data->inputView = data->inputTrace.GetBitMatrix();
+	} else {
+		data->inputTrace.Close();
+		data->inputVector = LoadInInputData(files.input);
+		data->inputView = data->inputVector;
+	}
+	data->newMemory = LoadInWeightData(files.newWeight, param->numRowPerSynapse, param->numColPerSynapse, param->maxConductance, param->minConductance);
+	data->oldMemory = LoadInWeightData(files.oldWeight, param->numRowPerSynapse, param->numColPerSynapse, param->maxConductance, param->minConductance);
+}
+
+void SetLayerData(const float *newWeight, const float *oldWeight, int weightRow, int weightCol, const BitMatrixView &input, LayerData *data) {
+	data->inputTrace.Close();
+	if (param->XNORparallelMode || param->XNORsequentialMode) {
+		data->inputVector = ConvertInputData(input);
+		data->inputView = data->inputVector;
+	} else {
+		data->inputVector = BitMatrix();
+		data->inputView = input;
+	}
+	data->newMemory = ConvertWeightData(newWeight, weightRow, weightCol, param->numRowPerSynapse, param->numColPerSynapse, param->maxConductance, param->minConductance);
+	data->oldMemory = ConvertWeightData(oldWeight, weightRow, weightCol, param->numRowPerSynapse, param->numColPerSynapse, param->maxConductance, param->minConductance);
+}
+
+LayerPrefetcher::LayerPrefetcher(SimulationContext &context, const vector<LayerFiles> &_files, int _numLayerAhead, double _memoryBudget)
+	: files(_files), layers(_files.size(), (LayerData *) NULL), loaded(_files.size(), false), numLayerAhead(_numLayerAhead), memoryBudget(_memoryBudget),
+	  current(0), bytesInMemory(0), stop(false) {
+	worker = thread(&LayerPrefetcher::Run, this, &context);
+}
+
+LayerPrefetcher::~LayerPrefetcher() {
+	{
+		unique_lock<mutex> guard(lock);
+		stop = true;
+	}
+	changed.notify_all();
+	worker.join();
+	for (int i=0; i<layers.size(); i++) {
+		delete layers[i];
+	}
+}
+
+const LayerData *LayerPrefetcher::Get(int layer) {
+	unique_lock<mutex> guard(lock);
+	current = layer;
+	for (int i=0; i<layer; i++) {	// 前面的层已经评估完，释放其数据
+		if (layers[i]) {
+			bytesInMemory -= layers[i]->Bytes();
+			delete layers[i];
+			layers[i] = NULL;
+		}
+	}
+	changed.notify_all();
+	changed.wait(guard, [&]{ return loaded[layer]; });
+	return layers[layer];
+}
+
+void LayerPrefetcher::Run(SimulationContext *context) {
+	param = context->param;		// 只读取文件格式相关的参数
+	for (int next=0; next<files.size(); next++) {
+		{
+			unique_lock<mutex> guard(lock);
+			changed.wait(guard, [&]{ return stop || next == current || (next <= current + numLayerAhead && bytesInMemory < memoryBudget); });
+			if (stop) {
+				return;
+			}
+		}
+		LayerData *data = new LayerData;
+		LoadLayerData(files[next], data);
+		if (data->inputTrace.IsOpen()) {	// 提前把映射的输入读入内存
+			const volatile char *page = (const volatile char *) data->inputView.data;
+			long bytes = (long) data->inputView.numCol * data->inputView.wordsPerColumn * sizeof(uint64_t);
+			for (long offset=0; offset<bytes; offset+=4096) {
+				page[offset];
+			}
+		}
+		{
+			unique_lock<mutex> guard(lock);
+			layers[next] = data;
+			loaded[next] = true;
+			bytesInMemory += data->Bytes();
+		}
+		changed.notify_all();
+	}
+}
@@ -0,0 +1,106 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#ifndef LAYERLOADER_H_
+#define LAYERLOADER_H_
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Matrix.h"
+#include "BitMatrix.h"
+#include "TraceFile.h"
+
+using namespace std;
+
+class SimulationContext;
+
+// 一层的权重、旧权重和输入（二进制trace时输入视图直接指向映射的内存）
+struct LayerData {
+	TraceFile inputTrace;
+	BitMatrix inputVector;
+	BitMatrixView inputView;
+	Matrix newMemory;
+	Matrix oldMemory;
+
+	long Bytes() const;	// 占用的内存（含映射的trace）
+};
+
+struct LayerFiles {
+	string newWeight, oldWeight, input;
+};
+
+// 只读取二进制trace的文件头或逐行扫描CSV得到文件中矩阵的尺寸（权重为展开前的尺寸），不解析数据也不退出；
+// 文件无法读取、格式损坏或CSV各行字段数不同时返回false并给出原因
+bool GetLayerFileShape(const string &filename, int *numRow, int *numCol, string *error);
+// 按当前线程的param读入一层的三个文件（CSV或二进制trace）
+void LoadLayerData(const LayerFiles &files, LayerData *data);
+// 权重为行主序的weightRow x weightCol矩阵，input直接指向调用者的内存（例如numpy数组），XNOR模式以外不做复制
+void SetLayerData(const float *newWeight, const float *oldWeight, int weightRow, int weightCol, const BitMatrixView &input, LayerData *data);
+
+// 逐层评估时在后台线程中按顺序预读后面numLayerAhead层的文件，使文件读取和解析与当前层的仿真重叠
+// 已读入但尚未取走的数据超过memoryBudget字节时暂停预读，但当前需要的层总是会被读入
+class LayerPrefetcher {
+public:
+	LayerPrefetcher(SimulationContext &context, const vector<LayerFiles> &files, int numLayerAhead, double memoryBudget);
+	~LayerPrefetcher();
+
+	const LayerData *Get(int layer);	// 等待第layer层读入完成，之前各层的数据被释放
+
+private:
+	LayerPrefetcher(const LayerPrefetcher &);
+	LayerPrefetcher &operator=(const LayerPrefetcher &);
+
+	void Run(SimulationContext *context);
+
+	vector<LayerFiles> files;
+	vector<LayerData *> layers;
+	vector<bool> loaded;
+	int numLayerAhead;
+	double memoryBudget;
+	int current;		// 主线程正在使用的层
+	long bytesInMemory;
+	bool stop;
+	mutex lock;
+	condition_variable changed;
+	thread worker;
+};
+
+#endif /* LAYERLOADER_H_ */
@@ -0,0 +1,134 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#include <iostream>
+#include <stdlib.h>
+#include "Matrix.h"
+
+using namespace std;
+
+MatrixView::MatrixView() {
+	data = NULL;
+	conductance = NULL;
+	resistance = NULL;
+	numLevel = 0;
+	numRow = 0;
+	numCol = 0;
+	stride = 0;
+}
+
+MatrixView::MatrixView(const uint8_t *_data, const double *_conductance, const double *_resistance, int _numLevel, int _numRow, int _numCol, int _stride) {
+	data = _data;
+	conductance = _conductance;
+	resistance = _resistance;
+	numLevel = _numLevel;
+	numRow = _numRow;
+	numCol = _numCol;
+	stride = _stride;
+}
+
+MatrixView MatrixView::SubView(int positionRow, int positionCol, int numRowView, int numColView) const {
+	if (positionRow < 0 || positionCol < 0 || positionRow+numRowView > numRow || positionCol+numColView > numCol) {
+		cerr << "Error: matrix view [" << positionRow << "+" << numRowView << ", " << positionCol << "+" << numColView << "] is out of range "
+			 << numRow << "x" << numCol << endl;
+		exit(1);
+	}
+	return MatrixView(data + (long)positionRow*stride + positionCol, conductance, resistance, numLevel, numRowView, numColView, stride);
+}
+
+// 转置后的连续副本，原矩阵的每一列成为新矩阵中连续存储的一行
+Matrix MatrixView::Transpose() const {
+	Matrix transposed(numCol, numRow);
+	transposed.CopyLevels(*this);
+	for (int i=0; i<numRow; i++) {
+		const uint8_t *row = (*this)[i];
+		for (int j=0; j<numCol; j++) {
+			transposed[j][i] = row[j];
+		}
+	}
+	return transposed;
+}
+
+Matrix::Matrix() {
+	numRow = 0;
+	numCol = 0;
+}
+
+Matrix::Matrix(int _numRow, int _numCol, double value) {
+	numRow = _numRow;
+	numCol = _numCol;
+	data.assign((long)numRow*numCol, GetLevel(value));
+}
+
+MatrixView Matrix::SubView(int positionRow, int positionCol, int numRowView, int numColView) const {
+	return MatrixView(*this).SubView(positionRow, positionCol, numRowView, numColView);
+}
+
+uint8_t Matrix::GetLevel(double value) {
+	// 等级数很少，且相邻单元往往取相同的等级，因此线性查找即可
+	for (int l=conductance.size()-1; l>=0; l--) {
+		if (conductance[l] == value) {
+			return l;
+		}
+	}
+	if (conductance.size() >= MAX_NUM_LEVEL) {
+		cerr << "Error: the weight matrix has more than " << MAX_NUM_LEVEL << " distinct conductance levels" << endl;
+		exit(1);
+	}
+	conductance.push_back(value);
+	resistance.push_back((double) 1.0/value);
+	return conductance.size()-1;
+}
+
+void Matrix::CopyLevels(const MatrixView &other) {
+	conductance.assign(other.conductance, other.conductance + other.numLevel);
+	resistance.assign(other.resistance, other.resistance + other.numLevel);
+}
+
+void Matrix::AppendRow(const vector<double> &row) {
+	if (numRow == 0) {
+		numCol = row.size();
+	} else if (row.size() != numCol) {
+		cerr << "Error: row " << numRow << " has " << row.size() << " elements, expected " << numCol << endl;
+		exit(1);
+	}
+	for (int j=0; j<row.size(); j++) {
+		data.push_back(GetLevel(row[j]));
+	}
+	numRow++;
+}
@@ -0,0 +1,98 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#ifndef MATRIX_H_
+#define MATRIX_H_
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+class Matrix;
+
+// 权重（电导）矩阵：每个单元只可能取有限个电导等级，因此只存储1字节的等级编号，
+// 各等级的电导和电阻（1/电导）保存在查找表中，由同一矩阵的所有视图共享
+#define MAX_NUM_LEVEL	256
+
+// 只读的矩阵视图，指向某个Matrix中的一块区域（行主序，行间距为stride），不拥有数据
+// Chip、Tile、PE、subArray逐级划分权重和输入时只传递视图，不再复制数据
+class MatrixView {
+public:
+	MatrixView();
+	MatrixView(const uint8_t *_data, const double *_conductance, const double *_resistance, int _numLevel, int _numRow, int _numCol, int _stride);
+
+	const uint8_t *operator[](int row) const { return data + (long)row*stride; }	// 第row行各单元的等级编号
+	double Conductance(int row, int col) const { return conductance[data[(long)row*stride + col]]; }
+	double Resistance(int row, int col) const { return resistance[data[(long)row*stride + col]]; }
+	MatrixView SubView(int positionRow, int positionCol, int numRowView, int numColView) const;
+	Matrix Transpose() const;
+	int size() const { return numRow; }
+	bool empty() const { return numRow == 0 || numCol == 0; }
+
+	const uint8_t *data;
+	const double *conductance, *resistance;	// 按等级编号索引的查找表
+	int numLevel;
+	int numRow, numCol, stride;
+};
+
+// 连续存储的行主序矩阵
+class Matrix {
+public:
+	Matrix();
+	Matrix(int _numRow, int _numCol, double value = 0);
+
+	uint8_t *operator[](int row) { return &data[(long)row*numCol]; }
+	const uint8_t *operator[](int row) const { return &data[(long)row*numCol]; }
+	operator MatrixView() const { return MatrixView(data.empty()? NULL : &data[0], conductance.empty()? NULL : &conductance[0], 
+												resistance.empty()? NULL : &resistance[0], conductance.size(), numRow, numCol, numCol); }
+	MatrixView SubView(int positionRow, int positionCol, int numRowView, int numColView) const;
+	uint8_t GetLevel(double value);	// value对应的等级编号，不存在时新增一个等级
+	void CopyLevels(const MatrixView &other);
+	void Set(int row, int col, double value) { data[(long)row*numCol + col] = GetLevel(value); }
+	void AppendRow(const vector<double> &row);
+	int size() const { return numRow; }
+	bool empty() const { return numRow == 0 || numCol == 0; }
+
+	vector<uint8_t> data;
+	vector<double> conductance, resistance;
+	int numRow, numCol;
+};
+
+#endif /* MATRIX_H_ */
@@ -46,7 +46,7 @@
 
 using namespace std;
 
-extern Param *param;
+extern thread_local Param *param;
 
 MultilevelSenseAmp::MultilevelSenseAmp(const InputParameter& _inputParameter, const Technology& _tech, const MemCell& _cell): inputParameter(_inputParameter), tech(_tech), cell(_cell), currentSenseAmp(_inputParameter, _tech, _cell), FunctionUnit() {
 	initialized = false;
@@ -140,30 +140,10 @@ void MultilevelSenseAmp::CalculateLatency(const vector<double> &columnResistance
 	if (!initialized) {
 		cout << "[MultilevelSenseAmp] Error: Require initialization first!" << endl;
 	} else {
-		readLatency = 0;
-		double LatencyCol = 0;
-		for (double j=0; j<columnResistance.size(); j++){
-			double T_Col = 0;
-			T_Col = GetColumnLatency(columnResistance[j]);
-			if (columnResistance[j] == columnResistance[j]) {
-				LatencyCol = max(LatencyCol, T_Col);
-			} else {
-				LatencyCol = LatencyCol;
-			}
-			if (LatencyCol < 1e-9) {
-				LatencyCol = 1e-9;
-			} else if (LatencyCol > 10e-9) {
-				LatencyCol = 10e-9;
-			}
-		}
-		if (currentMode) {
-			readLatency = LatencyCol*numColMuxed;
-			readLatency *= numRead;
-		} else {
-			readLatency = (1e-9)*numColMuxed;
-			readLatency *= numRead;
-		}
-		
+		lastCall.latencyCalculated = true;
+		lastCall.numColMuxed = numColMuxed;
+		lastCall.numReadLatency = numRead;
+		CalculateBatch(columnResistance.empty()? NULL : &columnResistance[0], 1, columnResistance.size(), numColMuxed, numRead, 0, &readLatency, NULL);
 	}
 }
 
@@ -171,289 +151,343 @@ void MultilevelSenseAmp::CalculatePower(const vector<double> &columnResistance,
 	if (!initialized) {
 		cout << "[MultilevelSenseAmp] Error: Require initialization first!" << endl;
 	} else {
+		lastCall.powerCalculated = true;
+		lastCall.numReadPower = numRead;
 		leakage = 0;
-		readDynamicEnergy = 0;
-		
-		double LatencyCol = 0;
-		for (double j=0; j<columnResistance.size(); j++){
-			double T_Col = 0;
-			T_Col = GetColumnLatency(columnResistance[j]);
-			if (columnResistance[j] == columnResistance[j]) {
-				LatencyCol = max(LatencyCol, T_Col);
-			} else {
-				LatencyCol = LatencyCol;
+		CalculateBatch(columnResistance.empty()? NULL : &columnResistance[0], 1, columnResistance.size(), 0, 0, numRead, NULL, &readDynamicEnergy);
+	}
+}
+
+void MultilevelSenseAmp::CalculateLatencyBatch(const double *columnResistance, int numVector, int numColumn, double numColMuxed, double numRead, double *latency) {
+	if (!initialized) {
+		cout << "[MultilevelSenseAmp] Error: Require initialization first!" << endl;
+	} else {
+		CalculateBatch(columnResistance, numVector, numColumn, numColMuxed, numRead, 0, latency, NULL);
+	}
+}
+
+void MultilevelSenseAmp::CalculatePowerBatch(const double *columnResistance, int numVector, int numColumn, double numRead, double *energy) {
+	if (!initialized) {
+		cout << "[MultilevelSenseAmp] Error: Require initialization first!" << endl;
+	} else {
+		CalculateBatch(columnResistance, numVector, numColumn, 0, 0, numRead, NULL, energy);
+	}
+}
+
+void MultilevelSenseAmp::RecalculateBatch(const double *columnResistance, int numVector, int numColumn, double *latency, double *energy) {
+	CalculateBatch(columnResistance, numVector, numColumn, lastCall.numColMuxed, lastCall.numReadLatency, lastCall.numReadPower, 
+					lastCall.latencyCalculated? latency : NULL, lastCall.powerCalculated? energy : NULL);
+	for (int v=0; v<numVector; v++) {
+		if (!lastCall.latencyCalculated) {
+			latency[v] = readLatency;
+		}
+		if (!lastCall.powerCalculated) {
+			energy[v] = readDynamicEnergy;
+		}
+	}
+}
+
+// 先对所有向量的所有列逐元素求出列延迟和列功耗，再逐个向量求最大延迟（过滤NaN并限制在[1ns, 10ns]）和总能耗
+// 列延迟只计算一次，同时用于延迟和能耗（currentMode下能耗按最大列延迟积分）
+void MultilevelSenseAmp::CalculateBatch(const double *columnResistance, int numVector, int numColumn, double numColMuxed, double numReadLatency, double numReadPower, double *latency, double *energy) {
+	long numElement = (long)numVector*numColumn;
+	vector<double> columnLatency, columnPower;
+	if (currentMode && numElement > 0) {
+		columnLatency.resize(numElement);
+		GetColumnLatencyBatch(columnResistance, numElement, &columnLatency[0]);
+	}
+	if (energy && numElement > 0) {
+		columnPower.resize(numElement);
+		GetColumnPowerBatch(columnResistance, numElement, &columnPower[0]);
+	}
+	for (int v=0; v<numVector; v++) {
+		const double *res = columnResistance + (long)v*numColumn;
+		double LatencyCol = 1e-9;
+		if (currentMode) {
+			const double *T_Col = numElement > 0? &columnLatency[(long)v*numColumn] : NULL;
+			LatencyCol = 0;
+			for (int j=0; j<numColumn; j++) {
+				double T = (res[j] == res[j])? T_Col[j] : 0;	// NaN的列不参与
+				LatencyCol = (LatencyCol < T)? T : LatencyCol;
 			}
-			if (LatencyCol < 1e-9) {
-				LatencyCol = 1e-9;
-			} else if (LatencyCol > 10e-9) {
-				LatencyCol = 10e-9;
+			if (numColumn > 0) {
+				LatencyCol = MIN(MAX(LatencyCol, 1e-9), 10e-9);
 			}
 		}
-
-		for (double i=0; i<columnResistance.size(); i++) {
-			double P_Col = 0;
-			P_Col = GetColumnPower(columnResistance[i]);
-			if (currentMode) {
-				readDynamicEnergy += MAX(P_Col*LatencyCol, 0);
-			} else {
-				readDynamicEnergy += MAX(P_Col*1e-9, 0);
+		if (latency) {
+			latency[v] = LatencyCol*numColMuxed;
+			latency[v] *= numReadLatency;
+		}
+		if (energy) {
+			const double *P_Col = numElement > 0? &columnPower[(long)v*numColumn] : NULL;
+			double readEnergy = 0;
+			for (int j=0; j<numColumn; j++) {
+				readEnergy += MAX(P_Col[j]*LatencyCol, 0);
 			}
+			energy[v] = readEnergy*numReadPower;
 		}
-		readDynamicEnergy *= numRead;
 	}
-} 
+}
 
 void MultilevelSenseAmp::PrintProperty(const char* str) {
 	FunctionUnit::PrintProperty(str);
 }
 
 
+// LP下130~45(32)nm的列延迟拟合：T_max = (tMax[0]*log(R/1000)+tMax[1])*1e-9，
+// ratio = Rref/R <= 0.9时 T = T_max*(low[0]*ratio^3+low[1]*ratio^2+low[2]*ratio+low[3])，否则 T = T_max*(high[0]*ratio^4+...+high[4])
+struct ColumnLatencyFit {
+	double tMax[2];
+	double low[4];
+	double high[5];
+};
+
+static const ColumnLatencyFit columnLatencyFit130 = {{0.2679, 0.0478}, {3.915, -5.3996, 2.4653, 0.3856}, {0.0004, -0.0087, 0.0742, -0.2725, 1.2211}};
+static const ColumnLatencyFit columnLatencyFit90 = {{0.0586, 1.41}, {3.726, -5.651, 2.8249, 0.3574}, {0.0000008, -0.00007, 0.0017, -0.0188, 0.9835}};
+static const ColumnLatencyFit columnLatencyFit65 = {{0.1239, 0.6642}, {1.3899, -2.6913, 2.0483, 0.3202}, {0.0036, -0.0363, 0.1043, -0.0346, 1.0512}};
+static const ColumnLatencyFit columnLatencyFit45 = {{0.0714, 0.7651}, {3.7949, -5.6685, 2.6492, 0.4807}, {0.000001, -0.00006, 0.0001, -0.0171, 1.0057}};
+
 double MultilevelSenseAmp::GetColumnLatency(double columnRes) {
 	double Column_Latency = 0;
-	double up_bound = 3, mid_bound = 1.1, low_bound = 0.9;
-	double T_max = 0;
+	GetColumnLatencyBatch(&columnRes, 1, &Column_Latency);
+	return Column_Latency;
+}
+
+void MultilevelSenseAmp::GetColumnLatencyBatch(const double *columnRes, long numColumn, double *columnLatency) {
+	double low_bound = 0.9;
+	const ColumnLatencyFit *fit = NULL;
+	if (param->deviceroadmap != 1) {  // LP
+		if (param->technode == 130) {
+			fit = &columnLatencyFit130;
+		} else if (param->technode == 90) {
+			fit = &columnLatencyFit90;
+		} else if (param->technode == 65) {
+			fit = &columnLatencyFit65;
+		} else if (param->technode == 45 || param->technode == 32) {
+			fit = &columnLatencyFit45;
+		}
+	}
 	// in Cadence simulation, we fix Vread to 0.5V, with user-defined Vread (different from 0.5V)
 	// we should modify the equivalent columnRes
-	columnRes *= 0.5/param->readVoltage;
-	if (((double) 1/columnRes == 0) || (columnRes == 0)) {
-		Column_Latency = 0;
+	double scale = 0.5/param->readVoltage;
+	vector<double> res(numColumn), T_max(numColumn);
+	for (long j=0; j<numColumn; j++) {
+		res[j] = columnRes[j]*scale;
+		columnLatency[j] = fit? 0 : 1e-9;	// HP, 或LP下22nm及以下
+	}
+	if (fit) {
+		for (long j=0; j<numColumn; j++) {
+			T_max[j] = (fit->tMax[0]*log(res[j]/1000)+fit->tMax[1])*1e-9;
+		}
+		for (int i=1; i<levelOutput-1; i++) {
+			for (long j=0; j<numColumn; j++) {
+				double ratio = Rref[i]/res[j];
+				double ratio2 = ratio*ratio;
+				double T;
+				if (ratio >= 20 || ratio <= 0.05) {
+					T = 1e-9;
+				} else if (ratio <= low_bound) {
+					T = T_max[j] * (fit->low[0]*(ratio2*ratio)+fit->low[1]*ratio2+fit->low[2]*ratio+fit->low[3]);
+				} else {
+					T = T_max[j] * (fit->high[0]*(ratio2*ratio2)+fit->high[1]*(ratio2*ratio)+fit->high[2]*ratio2+fit->high[3]*ratio+fit->high[4]);
+				}
+				columnLatency[j] = (columnLatency[j] < T)? T : columnLatency[j];
+			}
+		}
+	}
+	for (long j=0; j<numColumn; j++) {
+		if (((double) 1/res[j] == 0) || (res[j] == 0)) {
+			columnLatency[j] = 0;
+		}
+	}
+}
+
+
+
+// 列功耗拟合：P = staticPower + coefficient*exp(exponent*log10(R))，各系数只与工艺和levelOutput有关
+void MultilevelSenseAmp::GetColumnPowerFit(double *staticPower, double *coefficient, double *exponent) {
+	if (currentMode) {
+		if (param->deviceroadmap == 1) {  // HP
+			if (param->technode == 130) {
+				*staticPower = 19.898*(levelOutput-1)*1e-6;
+				*coefficient = 0.17452;
+				*exponent = -2.367;
+			} else if (param->technode == 90) {
+				*staticPower = 13.09*(levelOutput-1)*1e-6;
+				*coefficient = 0.14900;
+				*exponent = -2.345;
+			} else if (param->technode == 65) {
+				*staticPower = 9.9579*(levelOutput-1)*1e-6;
+				*coefficient = 0.1083;
+				*exponent = -2.321;
+			} else if (param->technode == 45) {
+				*staticPower = 7.7017*(levelOutput-1)*1e-6;
+				*coefficient = 0.0754;
+				*exponent = -2.296;
+			} else if (param->technode == 32){  
+				*staticPower = 3.9648*(levelOutput-1)*1e-6;
+				*coefficient = 0.079;
+				*exponent = -2.313;
+			} else if (param->technode == 22){   
+				*staticPower = 1.8939*(levelOutput-1)*1e-6;
+				*coefficient = 0.073;
+				*exponent = -2.311;
+			} else if (param->technode == 14){  
+				*staticPower = 1.2*(levelOutput-1)*1e-6;
+				*coefficient = 0.0584;
+				*exponent = -2.311;
+			} else if (param->technode == 10){  
+				*staticPower = 0.8*(levelOutput-1)*1e-6;
+				*coefficient = 0.0318;
+				*exponent = -2.311;
+			} else {   // 7nm
+				*staticPower = 0.5*(levelOutput-1)*1e-6;
+				*coefficient = 0.0210;
+				*exponent = -2.311;
+			}
+		} else {                         // LP
+			if (param->technode == 130) {
+				*staticPower = 18.09*(levelOutput-1)*1e-6;
+				*coefficient = 0.1380;
+				*exponent = -2.303;
+			} else if (param->technode == 90) {
+				*staticPower = 12.612*(levelOutput-1)*1e-6;
+				*coefficient = 0.1023;
+				*exponent = -2.303;
+			} else if (param->technode == 65) {
+				*staticPower = 8.4147*(levelOutput-1)*1e-6;
+				*coefficient = 0.0972;
+				*exponent = -2.303;
+			} else if (param->technode == 45) {
+				*staticPower = 6.3162*(levelOutput-1)*1e-6;
+				*coefficient = 0.075;
+				*exponent = -2.303;
+			} else if (param->technode == 32){  
+				*staticPower = 3.0875*(levelOutput-1)*1e-6;
+				*coefficient = 0.0649;
+				*exponent = -2.297;
+			} else if (param->technode == 22){   
+				*staticPower = 1.7*(levelOutput-1)*1e-6;
+				*coefficient = 0.0631;
+				*exponent = -2.303;
+			} else if (param->technode == 14){   
+				*staticPower = 1.0*(levelOutput-1)*1e-6;
+				*coefficient = 0.0508;
+				*exponent = -2.303;
+			} else if (param->technode == 10){   
+				*staticPower = 0.55*(levelOutput-1)*1e-6;
+				*coefficient = 0.0315;
+				*exponent = -2.303;
+			} else {   // 7nm
+				*staticPower = 0.35*(levelOutput-1)*1e-6;
+				*coefficient = 0.0235;
+				*exponent = -2.303;
+			}
+		}
 	} else {
 		if (param->deviceroadmap == 1) {  // HP
-			Column_Latency = 1e-9;
+			if (param->technode == 130) {
+				*staticPower = 27.84*(levelOutput-1)*1e-6;
+				*coefficient = 0.207452;
+				*exponent = -2.367;
+			} else if (param->technode == 90) {
+				*staticPower = 22.2*(levelOutput-1)*1e-6;
+				*coefficient = 0.164900;
+				*exponent = -2.345;
+			} else if (param->technode == 65) {
+				*staticPower = 13.058*(levelOutput-1)*1e-6;
+				*coefficient = 0.128483;
+				*exponent = -2.321;
+			} else if (param->technode == 45) {
+				*staticPower = 8.162*(levelOutput-1)*1e-6;
+				*coefficient = 0.097754;
+				*exponent = -2.296;
+			} else if (param->technode == 32){  
+				*staticPower = 4.76*(levelOutput-1)*1e-6;
+				*coefficient = 0.083709;
+				*exponent = -2.313;
+			} else if (param->technode == 22){   
+				*staticPower = 2.373*(levelOutput-1)*1e-6;
+				*coefficient = 0.084273;
+				*exponent = -2.311;
+			} else if (param->technode == 14){  
+				*staticPower = 1.467*(levelOutput-1)*1e-6;
+				*coefficient = 0.060584;
+				*exponent = -2.311;
+			} else if (param->technode == 10){  
+				*staticPower = 0.9077*(levelOutput-1)*1e-6;
+				*coefficient = 0.049418;
+				*exponent = -2.311;
+			} else {   // 7nm
+				*staticPower = 0.5614*(levelOutput-1)*1e-6;
+				*coefficient = 0.040310;
+				*exponent = -2.311;
+			}
 		} else {                         // LP
 			if (param->technode == 130) {
-				T_max = (0.2679*log(columnRes/1000)+0.0478)*1e-9;   // T_max = (0.2679*log(R_BL/1000)+0.0478)*10^-9;
-
-				for (int i=1; i<levelOutput-1; i++){
-					double ratio = Rref[i]/columnRes;
-					double T = 0;
-					if (ratio >= 20 || ratio <= 0.05) {
-						T = 1e-9;
-					} else {
-						if (ratio <= low_bound){
-							T = T_max * (3.915*pow(ratio,3)-5.3996*pow(ratio,2)+2.4653*ratio+0.3856);  // y = 3.915*x^3-5.3996*x^2+2.4653*x+0.3856;
-						} else if (mid_bound <= ratio <= up_bound){
-							T = T_max * (0.0004*pow(ratio,4)-0.0087*pow(ratio,3)+0.0742*pow(ratio,2)-0.2725*ratio+1.2211);  // y = 0.0004*x^4-0.0087*x^3+0.0742*x^2-0.2725*x+1.2211;
-						} else if (ratio>up_bound){
-							T = T_max * (0.0004*pow(ratio,4)-0.0087*pow(ratio,3)+0.0742*pow(ratio,2)-0.2725*ratio+1.2211);
-						} else {
-							T = T_max;
-						}
-					}
-					Column_Latency = max(Column_Latency, T);
-				}
+				*staticPower = 23.4*(levelOutput-1)*1e-6;
+				*coefficient = 0.169380;
+				*exponent = -2.303;
 			} else if (param->technode == 90) {
-				T_max = (0.0586*log(columnRes/1000)+1.41)*1e-9;   // T_max = (0.0586*log(R_BL/1000)+1.41)*10^-9;
-
-				for (int i=1; i<levelOutput-1; i++){
-					double ratio = Rref[i]/columnRes;
-					double T = 0;
-					if (ratio >= 20 || ratio <= 0.05) {
-						T = 1e-9;
-					} else {
-						if (ratio <= low_bound){
-							T = T_max * (3.726*pow(ratio,3)-5.651*pow(ratio,2)+2.8249*ratio+0.3574);    // y = 3.726*x^3-5.651*x^2+2.8249*x+0.3574;
-						} else if (mid_bound <= ratio <= up_bound){
-							T = T_max * (0.0000008*pow(ratio,4)-0.00007*pow(ratio,3)+0.0017*pow(ratio,2)-0.0188*ratio+0.9835);  // y = 0.0000008*x^4-0.00007*x^3+0.0017*x^2-0.0188*x+0.9835;
-						} else if (ratio>up_bound){
-							T = T_max * (0.0000008*pow(ratio,4)-0.00007*pow(ratio,3)+0.0017*pow(ratio,2)-0.0188*ratio+0.9835);
-						} else {
-							T = T_max;
-						}
-					}
-					Column_Latency = max(Column_Latency, T);
-				}
+				*staticPower = 14.42*(levelOutput-1)*1e-6;
+				*coefficient = 0.144323;
+				*exponent = -2.303;
 			} else if (param->technode == 65) {
-				T_max = (0.1239*log(columnRes/1000)+0.6642)*1e-9;   // T_max = (0.1239*log(R_BL/1000)+0.6642)*10^-9;
-
-				for (int i=1; i<levelOutput-1; i++){
-					double ratio = Rref[i]/columnRes;
-					double T = 0;
-					if (ratio >= 20 || ratio <= 0.05) {
-						T = 1e-9;
-					} else {
-						if (ratio <= low_bound){
-							T = T_max * (1.3899*pow(ratio,3)-2.6913*pow(ratio,2)+2.0483*ratio+0.3202);    // y = 1.3899*x^3-2.6913*x^2+2.0483*x+0.3202;
-						} else if (mid_bound <= ratio <= up_bound){
-							T = T_max * (0.0036*pow(ratio,4)-0.0363*pow(ratio,3)+0.1043*pow(ratio,2)-0.0346*ratio+1.0512);   // y = 0.0036*x^4-0.0363*x^3+0.1043*x^2-0.0346*x+1.0512;
-						} else if (ratio>up_bound){
-							T = T_max * (0.0036*pow(ratio,4)-0.0363*pow(ratio,3)+0.1043*pow(ratio,2)-0.0346*ratio+1.0512);
-						} else {
-							T = T_max;
-						}
-					}
-					Column_Latency = max(Column_Latency, T);
-				}
-			} else if (param->technode == 45 || param->technode == 32) {
-				T_max = (0.0714*log(columnRes/1000)+0.7651)*1e-9;    // T_max = (0.0714*log(R_BL/1000)+0.7651)*10^-9;
-
-				for (int i=1; i<levelOutput-1; i++){
-					double ratio = Rref[i]/columnRes;
-					double T = 0;
-					if (ratio >= 20 || ratio <= 0.05) {
-						T = 1e-9;
-					} else {
-						if (ratio <= low_bound){
-							T = T_max * (3.7949*pow(ratio,3)-5.6685*pow(ratio,2)+2.6492*ratio+0.4807);    // y = 3.7949*x^3-5.6685*x^2+2.6492*x+0.4807
-						} else if (mid_bound <= ratio <= up_bound){
-							T = T_max * (0.000001*pow(ratio,4)-0.00006*pow(ratio,3)+0.0001*pow(ratio,2)-0.0171*ratio+1.0057);   // 0.000001*x^4-0.00006*x^3+0.0001*x^2-0.0171*x+1.0057;
-						} else if (ratio>up_bound){
-							T = T_max * (0.000001*pow(ratio,4)-0.00006*pow(ratio,3)+0.0001*pow(ratio,2)-0.0171*ratio+1.0057);
-						} else {
-							T = T_max;
-						}
-					}
-					Column_Latency = max(Column_Latency, T);
-				}
-			} else {   // technode below and equal to 22nm
-				Column_Latency = 1e-9;
+				*staticPower = 10.18*(levelOutput-1)*1e-6;
+				*coefficient = 0.121272;
+				*exponent = -2.303;
+			} else if (param->technode == 45) {
+				*staticPower = 7.062*(levelOutput-1)*1e-6;
+				*coefficient = 0.100225;
+				*exponent = -2.303;
+			} else if (param->technode == 32){  
+				*staticPower = 3.692*(levelOutput-1)*1e-6;
+				*coefficient = 0.079449;
+				*exponent = -2.297;
+			} else if (param->technode == 22){   
+				*staticPower = 1.866*(levelOutput-1)*1e-6;
+				*coefficient = 0.072341;
+				*exponent = -2.303;
+			} else if (param->technode == 14){   
+				*staticPower = 1.126*(levelOutput-1)*1e-6;
+				*coefficient = 0.061085;
+				*exponent = -2.303;
+			} else if (param->technode == 10){   
+				*staticPower = 0.6917*(levelOutput-1)*1e-6;
+				*coefficient = 0.051580;
+				*exponent = -2.303;
+			} else {   // 7nm
+				*staticPower = 0.4211*(levelOutput-1)*1e-6;
+				*coefficient = 0.043555;
+				*exponent = -2.303;
 			}
 		}
 	}
-	return Column_Latency;
 }
 
-
-
 double MultilevelSenseAmp::GetColumnPower(double columnRes) {
 	double Column_Power = 0;
+	GetColumnPowerBatch(&columnRes, 1, &Column_Power);
+	return Column_Power;
+}
+
+void MultilevelSenseAmp::GetColumnPowerBatch(const double *columnRes, long numColumn, double *columnPower) {
+	double staticPower, coefficient, exponent;
+	GetColumnPowerFit(&staticPower, &coefficient, &exponent);
 	// in Cadence simulation, we fix Vread to 0.5V, with user-defined Vread (different from 0.5V)
 	// we should modify the equivalent columnRes
-	columnRes *= 0.5/param->readVoltage;
-	if (currentMode) {
-		if ((double) 1/columnRes == 0) { 
+	double scale = 0.5/param->readVoltage;
+	double temperatureFactor = 1+1.3e-3*(param->temp-300);
+	for (long j=0; j<numColumn; j++) {
+		double res = columnRes[j]*scale;
+		double Column_Power;
+		if ((double) 1/res == 0) { 
 			Column_Power = 1e-6;
-		} else if (columnRes == 0) {
+		} else if (res == 0) {
 			Column_Power = 0;
 		} else {
-			if (param->deviceroadmap == 1) {  // HP
-				if (param->technode == 130) {
-					Column_Power = 19.898*(levelOutput-1)*1e-6;
-					Column_Power += 0.17452*exp(-2.367*log10(columnRes));
-				} else if (param->technode == 90) {
-					Column_Power = 13.09*(levelOutput-1)*1e-6;
-					Column_Power += 0.14900*exp(-2.345*log10(columnRes));
-				} else if (param->technode == 65) {
-					Column_Power = 9.9579*(levelOutput-1)*1e-6;
-					Column_Power += 0.1083*exp(-2.321*log10(columnRes));
-				} else if (param->technode == 45) {
-					Column_Power = 7.7017*(levelOutput-1)*1e-6;
-					Column_Power += 0.0754*exp(-2.296*log10(columnRes));
-				} else if (param->technode == 32){  
-					Column_Power = 3.9648*(levelOutput-1)*1e-6;
-					Column_Power += 0.079*exp(-2.313*log10(columnRes));
-				} else if (param->technode == 22){   
-					Column_Power = 1.8939*(levelOutput-1)*1e-6;
-					Column_Power += 0.073*exp(-2.311*log10(columnRes));
-				} else if (param->technode == 14){  
-					Column_Power = 1.2*(levelOutput-1)*1e-6;
-					Column_Power += 0.0584*exp(-2.311*log10(columnRes));
-				} else if (param->technode == 10){  
-					Column_Power = 0.8*(levelOutput-1)*1e-6;
-					Column_Power += 0.0318*exp(-2.311*log10(columnRes));
-				} else {   // 7nm
-					Column_Power = 0.5*(levelOutput-1)*1e-6;
-					Column_Power += 0.0210*exp(-2.311*log10(columnRes));
-				}
-			} else {                         // LP
-				if (param->technode == 130) {
-					Column_Power = 18.09*(levelOutput-1)*1e-6;
-					Column_Power += 0.1380*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 90) {
-					Column_Power = 12.612*(levelOutput-1)*1e-6;
-					Column_Power += 0.1023*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 65) {
-					Column_Power = 8.4147*(levelOutput-1)*1e-6;
-					Column_Power += 0.0972*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 45) {
-					Column_Power = 6.3162*(levelOutput-1)*1e-6;
-					Column_Power += 0.075*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 32){  
-					Column_Power = 3.0875*(levelOutput-1)*1e-6;
-					Column_Power += 0.0649*exp(-2.297*log10(columnRes));
-				} else if (param->technode == 22){   
-					Column_Power = 1.7*(levelOutput-1)*1e-6;
-					Column_Power += 0.0631*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 14){   
-					Column_Power = 1.0*(levelOutput-1)*1e-6;
-					Column_Power += 0.0508*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 10){   
-					Column_Power = 0.55*(levelOutput-1)*1e-6;
-					Column_Power += 0.0315*exp(-2.303*log10(columnRes));
-				} else {   // 7nm
-					Column_Power = 0.35*(levelOutput-1)*1e-6;
-					Column_Power += 0.0235*exp(-2.303*log10(columnRes));
-				}
-			}
-		}
-		
-	} else {
-		if ((double) 1/columnRes == 0) { 
-			Column_Power = 1e-6;
-		} else if (columnRes == 0) {
-			Column_Power = 0;
-		} else {
-			if (param->deviceroadmap == 1) {  // HP
-				if (param->technode == 130) {
-					Column_Power = 27.84*(levelOutput-1)*1e-6;
-					Column_Power += 0.207452*exp(-2.367*log10(columnRes));
-				} else if (param->technode == 90) {
-					Column_Power = 22.2*(levelOutput-1)*1e-6;
-					Column_Power += 0.164900*exp(-2.345*log10(columnRes));
-				} else if (param->technode == 65) {
-					Column_Power = 13.058*(levelOutput-1)*1e-6;
-					Column_Power += 0.128483*exp(-2.321*log10(columnRes));
-				} else if (param->technode == 45) {
-					Column_Power = 8.162*(levelOutput-1)*1e-6;
-					Column_Power += 0.097754*exp(-2.296*log10(columnRes));
-				} else if (param->technode == 32){  
-					Column_Power = 4.76*(levelOutput-1)*1e-6;
-					Column_Power += 0.083709*exp(-2.313*log10(columnRes));
-				} else if (param->technode == 22){   
-					Column_Power = 2.373*(levelOutput-1)*1e-6;
-					Column_Power += 0.084273*exp(-2.311*log10(columnRes));
-				} else if (param->technode == 14){  
-					Column_Power = 1.467*(levelOutput-1)*1e-6;
-					Column_Power += 0.060584*exp(-2.311*log10(columnRes));
-				} else if (param->technode == 10){  
-					Column_Power = 0.9077*(levelOutput-1)*1e-6;
-					Column_Power += 0.049418*exp(-2.311*log10(columnRes));
-				} else {   // 7nm
-					Column_Power = 0.5614*(levelOutput-1)*1e-6;
-					Column_Power += 0.040310*exp(-2.311*log10(columnRes));
-				}
-			} else {                         // LP
-				if (param->technode == 130) {
-					Column_Power = 23.4*(levelOutput-1)*1e-6;
-					Column_Power += 0.169380*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 90) {
-					Column_Power = 14.42*(levelOutput-1)*1e-6;
-					Column_Power += 0.144323*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 65) {
-					Column_Power = 10.18*(levelOutput-1)*1e-6;
-					Column_Power += 0.121272*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 45) {
-					Column_Power = 7.062*(levelOutput-1)*1e-6;
-					Column_Power += 0.100225*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 32){  
-					Column_Power = 3.692*(levelOutput-1)*1e-6;
-					Column_Power += 0.079449*exp(-2.297*log10(columnRes));
-				} else if (param->technode == 22){   
-					Column_Power = 1.866*(levelOutput-1)*1e-6;
-					Column_Power += 0.072341*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 14){   
-					Column_Power = 1.126*(levelOutput-1)*1e-6;
-					Column_Power += 0.061085*exp(-2.303*log10(columnRes));
-				} else if (param->technode == 10){   
-					Column_Power = 0.6917*(levelOutput-1)*1e-6;
-					Column_Power += 0.051580*exp(-2.303*log10(columnRes));
-				} else {   // 7nm
-					Column_Power = 0.4211*(levelOutput-1)*1e-6;
-					Column_Power += 0.043555*exp(-2.303*log10(columnRes));
-				}
-			}
+			Column_Power = staticPower + coefficient*exp(exponent*log10(res));
 		}
+		columnPower[j] = Column_Power*temperatureFactor;
 	}
-	Column_Power *= (1+1.3e-3*(param->temp-300));
-	return Column_Power;
 }
@@ -63,8 +63,16 @@ public:
 	void CalculateArea(double heightArray, double widthArray, AreaModify _option);
 	void CalculateLatency(const vector<double> &columnResistance, double numColMuxed, double numRead);
 	void CalculatePower(const vector<double> &columnResistance, double numRead);
+	// 批量版本：columnResistance为numVector个输入向量的列电阻，按向量连续存储（每个向量numColumn列），结果按向量输出
+	void CalculateLatencyBatch(const double *columnResistance, int numVector, int numColumn, double numColMuxed, double numRead, double *latency);
+	void CalculatePowerBatch(const double *columnResistance, int numVector, int numColumn, double numRead, double *energy);
+	void RecalculateBatch(const double *columnResistance, int numVector, int numColumn, double *latency, double *energy);	// 按lastCall的参数重新计算，未调用过的部分输出当前结果
+	void CalculateBatch(const double *columnResistance, int numVector, int numColumn, double numColMuxed, double numReadLatency, double numReadPower, double *latency, double *energy);
 	double GetColumnLatency(double columnRes);
 	double GetColumnPower(double columnRes);
+	void GetColumnLatencyBatch(const double *columnRes, long numColumn, double *columnLatency);
+	void GetColumnPowerBatch(const double *columnRes, long numColumn, double *columnPower);
+	void GetColumnPowerFit(double *staticPower, double *coefficient, double *exponent);
 
 	/* Properties */
 	bool initialized;		/* Initialization flag */
@@ -80,6 +88,7 @@ public:
 	double clkFreq;
 	int numReadCellPerOperationNeuro;
 	vector<double> Rref;
+	ReadoutCall lastCall;
 
 	CurrentSenseAmp currentSenseAmp;
 };
@@ -0,0 +1,448 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <sstream>
+#include "constant.h"
+#include "formula.h"
+#include "Param.h"
+#include "Chip.h"
+#include "CsvParser.h"
+#include "LayerLoader.h"
+#include "SimulationContext.h"
+#include "TokenSweep.h"
+#include "NeuroSim.h"
+
+using namespace std;
+
+// 一次初始化后保持不变的芯片设计，main中对应的局部变量在这里作为成员保存
+struct NeuroSim {
+	SimulationContext context;
+	vector<vector<double> > netStructure;
+	vector<int> markNM, pipelineSpeedUp;
+	double maxPESizeNM, maxTileSizeCM, numPENM;
+	double desiredNumTileNM, desiredPESizeNM, desiredNumTileCM, desiredTileSizeCM, desiredPESizeCM;
+	int numTileRow, numTileCol, numArrayWriteParallel;
+	vector<vector<double> > numTileEachLayer, utilizationEachLayer, speedUpEachLayer, tileLocaEachLayer;
+	double CMTileheight, CMTilewidth, NMTileheight, NMTilewidth;
+	NeuroSimChipInfo info;
+	vector<SimulationContext *> threadContexts;	// 数字计算模式下并行评估token的其他线程使用的模块实例，在query之间保留
+};
+
+static thread_local string lastError;
+
+static int Fail(const string &message) {
+	lastError = message;
+	return -1;
+}
+
+static double NumTile(const NeuroSim *sim, int layer) {
+	return sim->numTileEachLayer[0][layer] * sim->numTileEachLayer[1][layer];
+}
+
+int neurosim_api_version(void) {
+	return NEUROSIM_API_VERSION;
+}
+
+const char *neurosim_last_error(void) {
+	return lastError.c_str();
+}
+
+NeuroSim *neurosim_create(const char *networkFile, int synapseBit, int numBitInput) {
+	NeuroSim *sim = new NeuroSim;
+	sim->context.Bind();
+	
+	CsvMatrix csv;
+	if (!param->digital && (networkFile == NULL || !LoadCsvMatrix(networkFile, &csv) || csv.size() == 0)) {
+		Fail(string("the network file ") + (networkFile? networkFile : "(null)") + " cannot be opened or is empty");
+		delete sim;
+		return NULL;
+	}
+	for (int row=0; row<csv.size(); row++) {
+		if (csv.NumField(row) < 8) {
+			ostringstream message;
+			message << "row " << row << " of the network file has " << csv.NumField(row) << " elements, expected 8";
+			Fail(message.str());
+			delete sim;
+			return NULL;
+		}
+		sim->netStructure.push_back(vector<double>(csv[row], csv[row] + csv.NumField(row)));
+	}
+	
+	// 与main相同的初始化流程
+	sim->context.Initialize(synapseBit, numBitInput);
+	sim->markNM = ChipDesignInitialize(sim->context, false, sim->netStructure, &sim->maxPESizeNM, &sim->maxTileSizeCM, &sim->numPENM);
+	sim->pipelineSpeedUp = ChipDesignInitialize(sim->context, true, sim->netStructure, &sim->maxPESizeNM, &sim->maxTileSizeCM, &sim->numPENM);
+	
+	if (!param->digital) {
+		vector<vector<double> > *floorPlan[4] = {&sim->numTileEachLayer, &sim->utilizationEachLayer, &sim->speedUpEachLayer, &sim->tileLocaEachLayer};
+		for (int i=0; i<4; i++) {
+			*floorPlan[i] = ChipFloorPlan(sim->context, i == 0, i == 1, i == 2, sim->netStructure, sim->markNM,
+						sim->maxPESizeNM, sim->maxTileSizeCM, sim->numPENM, sim->pipelineSpeedUp,
+						&sim->desiredNumTileNM, &sim->desiredPESizeNM, &sim->desiredNumTileCM, &sim->desiredTileSizeCM, &sim->desiredPESizeCM, &sim->numTileRow, &sim->numTileCol);
+		}
+	} else {
+		// 与main相同，手动设置数字计算模式下的参数
+		sim->desiredNumTileNM = sim->desiredPESizeNM = 0;
+		sim->desiredPESizeCM = 11008*param->synapseBit;
+		sim->desiredTileSizeCM = 3*sim->desiredPESizeCM;
+		sim->desiredNumTileCM = param->numDecoderBlock;
+		sim->numTileRow = ceil(sqrt(param->numDecoderBlock));
+		sim->numTileCol = sim->numTileRow;
+	}
+	
+	ChipInitialize(sim->context, sim->netStructure, sim->markNM, sim->numTileEachLayer,
+					sim->numPENM, sim->desiredNumTileNM, sim->desiredPESizeNM, sim->desiredNumTileCM, sim->desiredTileSizeCM, sim->desiredPESizeCM, sim->numTileRow, sim->numTileCol, &sim->numArrayWriteParallel);
+	
+	NeuroSimChipInfo &info = sim->info;
+	sim->CMTileheight = sim->CMTilewidth = sim->NMTileheight = sim->NMTilewidth = 0;
+	vector<double> chipAreaResults = ChipCalculateArea(sim->context, sim->desiredNumTileNM, sim->numPENM, sim->desiredPESizeNM, sim->desiredNumTileCM, sim->desiredTileSizeCM, sim->desiredPESizeCM, sim->numTileRow, 
+		&info.height, &info.width, &sim->CMTileheight, &sim->CMTilewidth, &sim->NMTileheight, &sim->NMTilewidth);
+	info.area = chipAreaResults[0];
+	info.areaIC = chipAreaResults[1];
+	info.areaADC = chipAreaResults[2];
+	info.areaAccum = chipAreaResults[3];
+	info.areaOther = chipAreaResults[4];
+	info.areaWG = chipAreaResults[5];
+	info.areaArray = chipAreaResults[6];
+	
+	const vector<vector<double> > &netStructure = sim->netStructure;
+	info.numComputation = 0;
+	for (int i=0; i<netStructure.size(); i++) {
+		info.numComputation += 2*(netStructure[i][0] * netStructure[i][1] * netStructure[i][2] * netStructure[i][3] * netStructure[i][4] * netStructure[i][5]);
+	}
+	if (param->trainingEstimation && !param->digital) {
+		info.numComputation *= 3;  // forward, computation of activation gradient, weight gradient
+		info.numComputation -= 2*(netStructure[0][0] * netStructure[0][1] * netStructure[0][2] * netStructure[0][3] * netStructure[0][4] * netStructure[0][5]);  //L-1 does not need AG
+		info.numComputation *= param->batchSize * param->numIteration;  // count for one epoch
+	}
+	info.numLayer = netStructure.size();
+	info.pipeline = param->pipeline;
+	info.digital = param->digital;
+	info.numRowPerSynapse = param->numRowPerSynapse;
+	info.numColPerSynapse = param->numColPerSynapse;
+	
+	return sim;
+}
+
+void neurosim_destroy(NeuroSim *sim) {
+	if (sim == NULL) {
+		return;
+	}
+	for (int i=0; i<sim->threadContexts.size(); i++) {
+		delete sim->threadContexts[i];	// 复制出的context需要先于原来的context释放
+	}
+	delete sim;
+}
+
+void neurosim_get_chip_info(const NeuroSim *sim, NeuroSimChipInfo *info) {
+	*info = sim->info;
+}
+
+// 评估已读入的一层，漏电能耗按逐层评估计算（该层运行期间其他层的tile漏电），pipeline时由neurosim_summarize重新计算
+static void EvaluateLayer(NeuroSim *sim, int layer, double activity, const LayerData *data, NeuroSimPerformance *result) {
+	param->activityRowReadWG = activity;
+	param->activityRowWriteWG = activity;
+	param->activityColWriteWG = activity;
+	
+	double tileLeakage = 0;
+	NeuroSimPerformance &r = *result;
+	ChipCalculatePerformance(sim->context, layer, "", "", "", sim->netStructure[layer][6],
+				sim->netStructure, sim->markNM, 0, 0, 0, sim->numTileEachLayer, sim->utilizationEachLayer, sim->speedUpEachLayer, sim->tileLocaEachLayer,
+				sim->numPENM, sim->desiredPESizeNM, sim->desiredTileSizeCM, sim->desiredPESizeCM, sim->CMTileheight, sim->CMTilewidth, sim->NMTileheight, sim->NMTilewidth, sim->numArrayWriteParallel,
+				&r.readLatency, &r.readDynamicEnergy, &tileLeakage, &r.readLatencyAG, &r.readDynamicEnergyAG, &r.readLatencyWG, &r.readDynamicEnergyWG, 
+				&r.writeLatencyWU, &r.writeDynamicEnergyWU, &r.bufferLatency, &r.bufferDynamicEnergy, &r.icLatency, &r.icDynamicEnergy,
+				&r.coreLatencyADC, &r.coreLatencyAccum, &r.coreLatencyOther, &r.coreEnergyADC, &r.coreEnergyAccum, &r.coreEnergyOther, &r.dramLatency, &r.dramDynamicEnergy,
+				&r.readLatencyPeakFW, &r.readDynamicEnergyPeakFW, &r.readLatencyPeakAG, &r.readDynamicEnergyPeakAG,
+				&r.readLatencyPeakWG, &r.readDynamicEnergyPeakWG, &r.writeLatencyPeakWU, &r.writeDynamicEnergyPeakWU, data);
+	
+	double numTileOtherLayer = 0;
+	for (int j=0; j<sim->netStructure.size(); j++) {
+		if (j != layer) {
+			numTileOtherLayer += NumTile(sim, j);
+		}
+	}
+	r.leakagePower = NumTile(sim, layer)*tileLeakage;
+	r.leakageEnergy = numTileOtherLayer*tileLeakage*(r.readLatency+r.readLatencyAG);
+}
+
+static int CheckLayer(const NeuroSim *sim, int layer, NeuroSimPerformance *result) {
+	if (sim->info.digital) {
+		return Fail("layers cannot be evaluated in digital mode (Param::digital != 0), use neurosim_evaluate_tokens");
+	}
+	if (layer < 0 || layer >= sim->netStructure.size()) {
+		ostringstream message;
+		message << "layer " << layer << " is out of range, the network has " << sim->netStructure.size() << " layers";
+		return Fail(message.str());
+	}
+	if (result == NULL) {
+		return Fail("result is NULL");
+	}
+	return 0;
+}
+
+// 权重必须与netStructure[layer]一致，输入的列数（bit平面数）可以多于该层需要的数量；name为报错时矩阵的名字
+static bool CheckShape(const NeuroSim *sim, int layer, const string &name, bool input, int row, int col, ostringstream &message) {
+	const vector<double> &net = sim->netStructure[layer];
+	int numRow = net[2]*net[3]*net[4];
+	int numCol = input? (net[0]-net[3]+1)/net[7]*(net[1]-net[4]+1)/net[7]*param->numBitInput : net[5];
+	if (row == numRow && (input? col >= numCol : col == numCol)) {
+		return true;
+	}
+	message << "the " << name << " of layer " << layer << " is " << row << "x" << col << ", expected " << numRow << "x" << numCol;
+	return false;
+}
+
+int neurosim_evaluate_layer(NeuroSim *sim, int layer, const float *newWeight, const float *oldWeight, int weightRow, int weightCol,
+							const uint64_t *input, int inputRow, int inputCol, double activity, NeuroSimPerformance *result) {
+	sim->context.Bind();
+	if (CheckLayer(sim, layer, result) != 0) {
+		return -1;
+	}
+	ostringstream message;
+	if (newWeight == NULL || oldWeight == NULL || input == NULL) {
+		message << "the weight or input buffer of layer " << layer << " is NULL";
+	} else if (CheckShape(sim, layer, "weight", false, weightRow, weightCol, message)) {
+		CheckShape(sim, layer, "input", true, inputRow, inputCol, message);
+	}
+	if (!message.str().empty()) {
+		return Fail(message.str());
+	}
+	
+	LayerData data;
+	SetLayerData(newWeight, oldWeight, weightRow, weightCol, BitMatrixView(input, inputRow, inputCol, 0, (inputRow+63)/64), &data);
+	EvaluateLayer(sim, layer, activity, &data, result);
+	return 0;
+}
+
+int neurosim_evaluate_layer_files(NeuroSim *sim, int layer, const char *newWeightFile, const char *oldWeightFile, const char *inputFile,
+							double activity, NeuroSimPerformance *result) {
+	sim->context.Bind();
+	if (CheckLayer(sim, layer, result) != 0) {
+		return -1;
+	}
+	if (newWeightFile == NULL || oldWeightFile == NULL || inputFile == NULL) {
+		return Fail("the trace file name is NULL");
+	}
+	// 读入之前先检查各文件的尺寸，避免不匹配的trace在评估中途报错退出
+	const char *fileName[3] = {newWeightFile, oldWeightFile, inputFile};
+	for (int k=0; k<3; k++) {
+		int row, col;
+		string error;
+		if (!GetLayerFileShape(fileName[k], &row, &col, &error)) {
+			return Fail(error);
+		}
+		ostringstream message;
+		if (!CheckShape(sim, layer, string(k == 2? "input" : "weight") + " file " + fileName[k], k == 2, row, col, message)) {
+			return Fail(message.str());
+		}
+	}
+	
+	LayerFiles files;
+	files.newWeight = newWeightFile;
+	files.oldWeight = oldWeightFile;
+	files.input = inputFile;
+	LayerData data;
+	LoadLayerData(files, &data);
+	EvaluateLayer(sim, layer, activity, &data, result);
+	return 0;
+}
+
+void neurosim_summarize(const NeuroSim *sim, const NeuroSimPerformance *layers, NeuroSimChipPerformance *chip) {
+	NeuroSimPerformance &t = chip->total;
+	t = NeuroSimPerformance();
+	int numLayer = sim->netStructure.size();
+	for (int i=0; i<numLayer; i++) {
+		const NeuroSimPerformance &l = layers[i];
+		t.readDynamicEnergy += l.readDynamicEnergy;
+		t.readDynamicEnergyAG += l.readDynamicEnergyAG;
+		t.readDynamicEnergyWG += l.readDynamicEnergyWG;
+		t.writeDynamicEnergyWU += l.writeDynamicEnergyWU;
+		// since Weight Gradient and Weight Update have limitation on hardware resource, do not implement pipeline
+		t.readLatencyWG += l.readLatencyWG;
+		t.writeLatencyWU += l.writeLatencyWU;
+		t.dramLatency += l.dramLatency;
+		t.dramDynamicEnergy += l.dramDynamicEnergy;
+		
+		t.readDynamicEnergyPeakFW += l.readDynamicEnergyPeakFW;
+		t.readDynamicEnergyPeakAG += l.readDynamicEnergyPeakAG;
+		t.readLatencyPeakWG += l.readLatencyPeakWG;
+		t.readDynamicEnergyPeakWG += l.readDynamicEnergyPeakWG;
+		t.writeLatencyPeakWU += l.writeLatencyPeakWU;
+		t.writeDynamicEnergyPeakWU += l.writeDynamicEnergyPeakWU;
+		
+		t.leakagePower += l.leakagePower;
+		t.bufferDynamicEnergy += l.bufferDynamicEnergy;
+		t.icDynamicEnergy += l.icDynamicEnergy;
+		t.coreEnergyADC += l.coreEnergyADC;
+		t.coreEnergyAccum += l.coreEnergyAccum;
+		t.coreEnergyOther += l.coreEnergyOther;
+		
+		if (! sim->info.pipeline) {
+			t.readLatency += l.readLatency;
+			t.readLatencyAG += l.readLatencyAG;
+			t.readLatencyPeakFW += l.readLatencyPeakFW;
+			t.readLatencyPeakAG += l.readLatencyPeakAG;
+			t.leakageEnergy += l.leakageEnergy;
+			t.bufferLatency += l.bufferLatency;
+			t.icLatency += l.icLatency;
+			t.coreLatencyADC += l.coreLatencyADC;
+			t.coreLatencyAccum += l.coreLatencyAccum;
+			t.coreLatencyOther += l.coreLatencyOther;
+		} else {
+			// pipeline: 前向和activation gradient由最慢的一层决定系统时钟
+			t.readLatency = MAX(t.readLatency, l.readLatency);
+			t.readLatencyAG = MAX(t.readLatencyAG, l.readLatencyAG);
+			t.readLatencyPeakFW = MAX(t.readLatencyPeakFW, l.readLatencyPeakFW);
+			t.readLatencyPeakAG = MAX(t.readLatencyPeakAG, l.readLatencyPeakAG);
+			t.bufferLatency = MAX(t.bufferLatency, l.bufferLatency);
+			t.icLatency = MAX(t.icLatency, l.icLatency);
+			t.coreLatencyADC = MAX(t.coreLatencyADC, l.coreLatencyADC);
+			t.coreLatencyAccum = MAX(t.coreLatencyAccum, l.coreLatencyAccum);
+			t.coreLatencyOther = MAX(t.coreLatencyOther, l.coreLatencyOther);
+		}
+	}
+	if (sim->info.pipeline) {
+		// 每层在等待系统时钟的时间内漏电
+		for (int i=0; i<numLayer; i++) {
+			t.leakageEnergy += layers[i].leakagePower * ((t.readLatency-layers[i].readLatency) + (t.readLatencyAG-layers[i].readLatencyAG));
+		}
+	}
+	
+	chip->numComputation = sim->info.numComputation;
+	neurosim_update_efficiency(chip);
+}
+
+void neurosim_update_efficiency(NeuroSimChipPerformance *chip) {
+	const NeuroSimPerformance &t = chip->total;
+	double numComputation = chip->numComputation;
+	double latency = t.readLatency+t.readLatencyAG+t.readLatencyWG+t.writeLatencyWU;
+	double peakLatency = t.readLatencyPeakFW+t.readLatencyPeakAG+t.readLatencyPeakWG+t.writeLatencyPeakWU;
+	chip->energyEfficiency = numComputation/((t.readDynamicEnergy+t.leakageEnergy+t.readDynamicEnergyAG+t.readDynamicEnergyWG+t.writeDynamicEnergyWU)*1e12);
+	chip->throughputTOPS = numComputation/latency*1e-12;
+	chip->throughputFPS = 1/latency;
+	chip->peakEnergyEfficiency = numComputation/((t.readDynamicEnergyPeakFW+t.readDynamicEnergyPeakAG+t.readDynamicEnergyPeakWG+t.writeDynamicEnergyPeakWU)*1e12);
+	chip->peakThroughputTOPS = numComputation/peakLatency*1e-12;
+	chip->peakThroughputFPS = 1/peakLatency;
+}
+
+// 与main中的评估相同的一次推理（prefill或者生成一个token）
+static TokenPerformance EvaluateToken(NeuroSim *sim, SimulationContext &tokenContext, int seq_len, int seq_len_total) {
+	TokenPerformance token;
+	ChipCalculatePerformance(tokenContext, 0, "", "", "", 0,
+		sim->netStructure, sim->markNM, 1, seq_len, seq_len_total, sim->numTileEachLayer, sim->utilizationEachLayer, sim->speedUpEachLayer, sim->tileLocaEachLayer,
+		sim->numPENM, sim->desiredPESizeNM, sim->desiredTileSizeCM, sim->desiredPESizeCM, sim->CMTileheight, sim->CMTilewidth, sim->NMTileheight, sim->NMTilewidth, sim->numArrayWriteParallel,
+		&token.readLatency, &token.readDynamicEnergy, &token.leakage, &token.readLatencyAG, &token.readDynamicEnergyAG, &token.readLatencyWG, &token.readDynamicEnergyWG, 
+		&token.writeLatencyWU, &token.writeDynamicEnergyWU, &token.bufferLatency, &token.bufferDynamicEnergy, &token.icLatency, &token.icDynamicEnergy,
+		&token.coreLatencyADC, &token.coreLatencyAccum, &token.coreLatencyOther, &token.coreEnergyADC, &token.coreEnergyAccum, &token.coreEnergyOther, &token.DRAMLatency, &token.DRAMDynamicEnergy,
+		&token.readLatencyPeakFW, &token.readDynamicEnergyPeakFW, &token.readLatencyPeakAG, &token.readDynamicEnergyPeakAG,
+		&token.readLatencyPeakWG, &token.readDynamicEnergyPeakWG, &token.writeLatencyPeakWU, &token.writeDynamicEnergyPeakWU);
+	return token;
+}
+
+// 与main相同，各token的结果直接累加（数字计算模式下不计漏电能耗）
+static void AccumulateToken(const TokenPerformance &token, NeuroSimPerformance *total) {
+	NeuroSimPerformance &t = *total;
+	t.readLatency += token.readLatency;
+	t.readDynamicEnergy += token.readDynamicEnergy;
+	t.readLatencyAG += token.readLatencyAG;
+	t.readDynamicEnergyAG += token.readDynamicEnergyAG;
+	t.readLatencyWG += token.readLatencyWG;
+	t.readDynamicEnergyWG += token.readDynamicEnergyWG;
+	t.writeLatencyWU += token.writeLatencyWU;
+	t.writeDynamicEnergyWU += token.writeDynamicEnergyWU;
+	t.dramLatency += token.DRAMLatency;
+	t.dramDynamicEnergy += token.DRAMDynamicEnergy;
+	
+	t.readLatencyPeakFW += token.readLatencyPeakFW;
+	t.readDynamicEnergyPeakFW += token.readDynamicEnergyPeakFW;
+	t.readLatencyPeakAG += token.readLatencyPeakAG;
+	t.readDynamicEnergyPeakAG += token.readDynamicEnergyPeakAG;
+	t.readLatencyPeakWG += token.readLatencyPeakWG;
+	t.readDynamicEnergyPeakWG += token.readDynamicEnergyPeakWG;
+	t.writeLatencyPeakWU += token.writeLatencyPeakWU;
+	t.writeDynamicEnergyPeakWU += token.writeDynamicEnergyPeakWU;
+	
+	t.bufferLatency += token.bufferLatency;
+	t.bufferDynamicEnergy += token.bufferDynamicEnergy;
+	t.icLatency += token.icLatency;
+	t.icDynamicEnergy += token.icDynamicEnergy;
+	
+	t.coreLatencyADC += token.coreLatencyADC;
+	t.coreLatencyAccum += token.coreLatencyAccum;
+	t.coreLatencyOther += token.coreLatencyOther;
+	t.coreEnergyADC += token.coreEnergyADC;
+	t.coreEnergyAccum += token.coreEnergyAccum;
+	t.coreEnergyOther += token.coreEnergyOther;
+}
+
+int neurosim_evaluate_tokens(NeuroSim *sim, int inputLen, int outputLen, NeuroSimChipPerformance *chip) {
+	sim->context.Bind();
+	ostringstream message;
+	if (!param->digital) {
+		message << "tokens can only be evaluated in digital mode (Param::digital != 0), use neurosim_evaluate_layer";
+	} else if (chip == NULL) {
+		message << "chip is NULL";
+	} else if (inputLen < 1 || outputLen < inputLen || (param->digital != 1 && outputLen == inputLen)) {
+		message << "input_len " << inputLen << " and output_len " << outputLen << " do not describe any inference";
+	}
+	if (!message.str().empty()) {
+		return Fail(message.str());
+	}
+	
+	TokenEvaluator evaluate = [sim](SimulationContext &tokenContext, int seq_len, int seq_len_total) {
+		return EvaluateToken(sim, tokenContext, seq_len, seq_len_total);
+	};
+	NeuroSimPerformance &t = chip->total;
+	t = NeuroSimPerformance();
+	chip->numComputation = 0;
+	if (param->digital == 1) {
+		// prefill
+		AccumulateToken(EvaluateToken(sim, sim->context, inputLen, inputLen), &t);
+		chip->numComputation += GetTokenComputation(inputLen, inputLen);
+	}
+	vector<TokenPerformance> decodeTokens = CalculateDecodePerformance(sim->context, &sim->threadContexts, inputLen+1, outputLen, evaluate);
+	for (int i=0; i<decodeTokens.size(); i++) {
+		AccumulateToken(decodeTokens[i], &t);
+		chip->numComputation += GetTokenComputation(1, inputLen+1+i);
+	}
+	neurosim_update_efficiency(chip);
+	return 0;
+}
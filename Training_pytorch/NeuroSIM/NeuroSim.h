@@ -0,0 +1,119 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#ifndef NEUROSIM_H_
+#define NEUROSIM_H_
+
+#include <stdint.h>
+
+// libneurosim.so的C接口：在同一进程中只初始化一次芯片（工艺、floorplan、各模块以及面积），之后可以反复评估各层，
+// 权重和输入直接从调用者的内存（例如numpy数组）中读取，结果以结构体返回，不再经过trace文件和CSV
+// 数字计算模式（Param::digital非0）下没有逐层的trace，用neurosim_evaluate_tokens按query的输入、输出长度评估
+// Param.cpp中的设计参数在编译时确定；每个NeuroSim有自己的参数和模块实例，不同的实例可以在不同线程中同时使用
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NEUROSIM_API_VERSION	2
+
+typedef struct NeuroSim NeuroSim;
+
+typedef struct {
+	int numLayer;
+	int pipeline;						// 1: pipeline评估，0: 逐层评估
+	int digital;						// Param::digital，非0时numLayer为0，只能调用neurosim_evaluate_tokens
+	int numRowPerSynapse, numColPerSynapse;
+	double numComputation;				// 整个网络一次推理（trainingEstimation时为一个epoch）的运算次数，数字计算模式下为0（与query的长度有关）
+	double height, width;				// m
+	double area, areaArray, areaIC, areaADC, areaAccum, areaOther, areaWG;	// m^2
+} NeuroSimChipInfo;
+
+// 单层或整个芯片的延迟(s)、能耗(J)以及漏电功耗(W)
+typedef struct {
+	double readLatency, readDynamicEnergy, readLatencyAG, readDynamicEnergyAG;
+	double readLatencyWG, readDynamicEnergyWG, writeLatencyWU, writeDynamicEnergyWU;
+	double readLatencyPeakFW, readDynamicEnergyPeakFW, readLatencyPeakAG, readDynamicEnergyPeakAG;
+	double readLatencyPeakWG, readDynamicEnergyPeakWG, writeLatencyPeakWU, writeDynamicEnergyPeakWU;
+	double leakagePower, leakageEnergy;
+	double bufferLatency, bufferDynamicEnergy, icLatency, icDynamicEnergy;
+	double coreLatencyADC, coreLatencyAccum, coreLatencyOther, coreEnergyADC, coreEnergyAccum, coreEnergyOther;
+	double dramLatency, dramDynamicEnergy;
+} NeuroSimPerformance;
+
+typedef struct {
+	NeuroSimPerformance total;
+	double numComputation;												// 计算能效和吞吐量所用的运算次数
+	double energyEfficiency, throughputTOPS, throughputFPS;				// TOPS/W, TOPS, FPS
+	double peakEnergyEfficiency, peakThroughputTOPS, peakThroughputFPS;
+} NeuroSimChipPerformance;
+
+int neurosim_api_version(void);
+const char *neurosim_last_error(void);	// 当前线程最近一次失败的原因
+
+// networkFile为NetWork.csv格式的网络结构（数字计算模式下不读取，可以为NULL），失败时返回NULL
+NeuroSim *neurosim_create(const char *networkFile, int synapseBit, int numBitInput);
+void neurosim_destroy(NeuroSim *sim);
+void neurosim_get_chip_info(const NeuroSim *sim, NeuroSimChipInfo *info);
+
+// 评估第layer层（从0开始），成功时返回0，参数错误时返回-1
+// newWeight、oldWeight: 行主序float32矩阵，weightRow = 输入通道数 x 卷积核尺寸，weightCol = 输出通道数（与utee/hook.py写出的权重trace相同）
+// input: inputRow x inputCol的输入bit平面，按列打包为64位字（与TRACE_BIT的数据区相同），评估期间不做复制
+// activity: 该层输入的平均激活率，用于weight gradient的估计
+int neurosim_evaluate_layer(NeuroSim *sim, int layer, const float *newWeight, const float *oldWeight, int weightRow, int weightCol,
+							const uint64_t *input, int inputRow, int inputCol, double activity, NeuroSimPerformance *result);
+// 同上，从trace文件（二进制或CSV）读入权重和输入；读入之前检查文件的尺寸，文件无法读取、损坏或尺寸不匹配时返回-1
+int neurosim_evaluate_layer_files(NeuroSim *sim, int layer, const char *newWeightFile, const char *oldWeightFile, const char *inputFile,
+							double activity, NeuroSimPerformance *result);
+
+// 按main的规则（逐层或pipeline）把各层的结果合并为整个芯片的结果，layers依次为第0..numLayer-1层
+void neurosim_summarize(const NeuroSim *sim, const NeuroSimPerformance *layers, NeuroSimChipPerformance *chip);
+
+// 数字计算模式：评估一个输入长度为inputLen、需求输出长度为outputLen的query，与main使用Param::input_len和output_len时相同
+// （Param::digital为1时包括prefill，为2时只有自回归阶段），chip为所有token的总和以及按该query的运算次数计算的能效和吞吐量
+// 权重固定的PE的结果在不同的query之间保留（Param::incrementalDecode），成功时返回0，参数错误时返回-1
+int neurosim_evaluate_tokens(NeuroSim *sim, int inputLen, int outputLen, NeuroSimChipPerformance *chip);
+
+// 按chip->numComputation和chip->total重新计算能效和吞吐量，用于合并多次评估的结果
+void neurosim_update_efficiency(NeuroSimChipPerformance *chip);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEUROSIM_H_ */
@@ -70,6 +70,12 @@ Param::Param() {
 	input_len = 10; 			// 这里该如何设置？workLoad该如何选取
 	output_len = 50;
 	numDecoderBlock = 32;
+	fastSweep = false;			// 自回归阶段只完整评估K、V缓存矩阵subArray划分改变处的token，区间内的token线性插值
+	fastSweepSpotCheck = 8;		// fastSweep模式下抽样与完整评估比较的插值token个数，输出最大相对误差，0表示不检查
+	prefetchLayers = 2;			// 逐层评估模拟计算时在后台线程中预读后面几层的权重和输入文件，0表示不预读
+	prefetchMemoryBudget = 4e9;	// 已预读但尚未评估的层占用的内存超过该值(Byte)时暂停预读
+	incrementalDecode = true;	// 权重固定的PE对相同的seq_len只评估一次，自回归阶段每个token只重新评估K、V缓存矩阵
+	cacheSubArray = true;		// 同一权重矩阵中形状和激活率相同的subArray只评估一次，设为false时每个subArray都单独评估
 
 	v_on = 1.5;	 //参考magic参数设置
 	v_off = 0.3;
@@ -145,6 +151,7 @@ Param::Param() {
 	technode = 32;                      // Technology
 	featuresize = 40e-9;                // Wire width for subArray simulation
 	wireWidth = 40;                     // wireWidth of the cell for Accuracy calculation
+	wireResistanceTolerance = 0;        // ignore the wire resistance in the column resistance when the largest wire resistance of a subArray is below this fraction of the smallest cell resistance (0: only when wireWidth == -1)
 	globalBusDelayTolerance = 0.1;      // to relax bus delay for global H-Tree (chip level: communication among tiles), if tolerance is 0.1, the latency will be relax to (1+0.1)*optimalLatency (trade-off with energy)
 	localBusDelayTolerance = 0.1;       // to relax bus delay for global H-Tree (tile level: communication among PEs), if tolerance is 0.1, the latency will be relax to (1+0.1)*optimalLatency (trade-off with energy)
 	treeFoldedRatio = 4;                // the H-Tree is assumed to be able to folding in layout (save area)
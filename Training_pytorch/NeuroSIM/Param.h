@@ -78,11 +78,18 @@ public:
 	int XNORparallelMode, XNORsequentialMode, BNNparallelMode, BNNsequentialMode, conventionalParallel, conventionalSequential; 
 	int numRowPerSynapse, numColPerSynapse;
 	double AR, Rho, wireLengthRow, wireLengthCol, unitLengthWireResistance, wireResistanceRow, wireResistanceCol;
+	double wireResistanceTolerance;
 
 	int d_model, d_k, d_v, n_heads, batch_size, max_length, d_hidden;
 	int input_len, output_len; //暂时只考虑一个query的情况，假设该query的输入长度和需求输出长度
 	int numDecoderBlock; // decoder block的个数
 	int digital; 
+	bool cacheSubArray; // DCpe模式下是否缓存subArray的评估结果
+	bool incrementalDecode; // 自回归阶段只重新评估K、V缓存对应的PE
+	bool fastSweep; // 自回归阶段只评估subArray划分改变处的token，其余token插值得到
+	int fastSweepSpotCheck; // fastSweep模式下抽样完整评估的插值token个数
+	int prefetchLayers; // 逐层评估时后台预读的层数
+	double prefetchMemoryBudget; // 预读数据占用内存的上限(Byte)
 };
 
 #endif
\ No newline at end of file
@@ -43,11 +43,16 @@
 #include <stdlib.h>
 #include <vector>
 #include <sstream>
+#include <map>
+#include <algorithm>
+#include <stdint.h>
 #include "Bus.h"
 #include "SubArray.h"
 #include "constant.h"
 #include "formula.h"
 #include "ProcessingUnit.h"
+#include "SimulationContext.h"
+#include "ConductanceKernel.h"
 #include "Param.h"
 #include "AdderTree.h"
 #include "Bus.h"
@@ -55,19 +60,38 @@
 
 using namespace std;
 
-extern Param *param;
+extern thread_local Param *param;
 
-AdderTree *adderTreeNM;
-Bus *busInputNM;
-Bus *busOutputNM;
-DFF *bufferInputNM;
-DFF *bufferOutputNM;
+// 模块实例为线程私有，由SimulationContext::Bind通过ProcessingUnitSetComponents绑定到当前线程
+thread_local AdderTree *adderTreeNM;
+thread_local Bus *busInputNM;
+thread_local Bus *busOutputNM;
+thread_local DFF *bufferInputNM;
+thread_local DFF *bufferOutputNM;
 
-AdderTree *adderTreeCM;
-Bus *busInputCM;
-Bus *busOutputCM;
-DFF *bufferInputCM;
-DFF *bufferOutputCM;
+thread_local AdderTree *adderTreeCM;
+thread_local Bus *busInputCM;
+thread_local Bus *busOutputCM;
+thread_local DFF *bufferInputCM;
+thread_local DFF *bufferOutputCM;
+
+static thread_local map<SubArrayEstimationKey, SubArrayEstimation> *subArrayEstimationCache;
+
+// 按存储单元类型、access类型和读模式特化的subArray核函数，由ProcessingUnitInitialize根据Param选定一次
+static thread_local ColumnResistanceFunction getColumnResistance;
+static thread_local RowResistanceFunction getRowResistance;
+static thread_local WriteUpdateEstimationFunction getWriteUpdateEstimation;
+
+// 一个cell从旧电导等级写到新电导等级（state: 1 = set, -1 = reset, 0 = 不更新）
+struct WriteTransition {
+	bool evaluated;
+	int state, numPulse;
+	double energy, energyPolarization;
+};
+
+// 模拟读循环中实际评估的输入向量数，以及由InputVectorBatch复用结果的输入向量数
+static thread_local long numInputVectorEvaluated;
+static thread_local long numInputVectorReused;
 
 
 
@@ -174,6 +198,7 @@ void ProcessingUnitInitialize(SubArray *& subArray, InputParameter& inputParamet
 	subArray->SARADC = param->SARADC;
 	subArray->currentMode = param->currentMode;
 	subArray->spikingMode = NONSPIKING;
+	subArray->FPGA = false;	// mux使用模拟传输门（之前没有初始化）
 	
 	
 	int numRow = param->numRowSubArray;
@@ -203,6 +228,12 @@ void ProcessingUnitInitialize(SubArray *& subArray, InputParameter& inputParamet
 	/*** initialize modules ***/
 	subArray->parallelWrite = DCpe; //在subArray内部使用parallelWrite来区分是否为数字计算
 	subArray->Initialize(numRow, numCol, param->unitLengthWireResistance);        // initialize subArray
+	// subArray重新初始化后之前缓存的结果失效
+	if (subArrayEstimationCache) {
+		subArrayEstimationCache->clear();
+	} else {
+		subArrayEstimationCache = new map<SubArrayEstimationKey, SubArrayEstimation>;
+	}
 	subArray->CalculateArea();
 	
 	if (param->novelMapping) {
@@ -237,6 +268,10 @@ void ProcessingUnitInitialize(SubArray *& subArray, InputParameter& inputParamet
 	
 	busInputCM->Initialize(HORIZONTAL, numSubArrayRowCM, numSubArrayColCM, 0, numRow, subArray->height, subArray->width);
 	busOutputCM->Initialize(VERTICAL, numSubArrayRowCM, numSubArrayColCM, 0, numCol, subArray->height, subArray->width);
+	
+	getColumnResistance = SelectColumnResistance(cell, param->parallelRead);
+	getRowResistance = SelectRowResistance(cell, param->parallelBP);
+	getWriteUpdateEstimation = SelectWriteUpdateEstimation(cell);
 }
 
 
@@ -288,9 +323,9 @@ vector<double> ProcessingUnitCalculateArea(SubArray *subArray, int numSubArrayRo
 }
 
 
-double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech, MemCell& cell, int layerNumber, bool NMpe, bool DCpe, int DCpeMode, 
-											const vector<vector<double> > &newMemory, const vector<vector<double> > &oldMemory, const vector<vector<double> > &inputVector,
-											int arrayDupRow, int arrayDupCol, int numSubArrayRow, int numSubArrayCol, int weightMatrixRow,
+double ProcessingUnitCalculatePerformance(SubArray *subArray, SimulationContext& context, int layerNumber, bool NMpe, bool DCpe, int DCpeMode, 
+											const MatrixView &newMemory, const MatrixView &oldMemory, const BitMatrixView &inputVector,
+											const WeightOperand *weightOperand, int arrayDupRow, int arrayDupCol, int numSubArrayRow, int numSubArrayCol, int weightMatrixRow,
 											int weightMatrixCol, int numInVector, double *readLatency, double *readDynamicEnergy, double *leakage, 
 											double *readLatencyAG, double *readDynamicEnergyAG, double *writeLatencyWU, double *writeDynamicEnergyWU,
 											double *bufferLatency, double *bufferDynamicEnergy, double *icLatency, double *icDynamicEnergy,
@@ -298,6 +333,9 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 											double *coreEnergyAccum, double *coreEnergyOther, double *readLatencyPeakFW, double *readDynamicEnergyPeakFW,
 											double *readLatencyPeakAG, double *readDynamicEnergyPeakAG, double *writeLatencyPeakWU, double *writeDynamicEnergyPeakWU) {
 	
+	Technology& tech = *context.tech;
+	MemCell& cell = *context.cell;
+	
 	/*** define how many subArray are used to map the whole layer ***/
 	*readLatency = 0;
 	*readDynamicEnergy = 0;
@@ -354,16 +392,20 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 					int numRowMatrix = min(param->numRowSubArray, weightMatrixRow-i*param->numRowSubArray);
 					int numColMatrix = min(param->numColSubArray, weightMatrixCol-j*param->numColSubArray);
 					// assign weight and input to specific subArray
-					// vector<vector<double> > subArrayMemoryOld; //不考虑写入，所以只有新权重矩阵
+					// MatrixView subArrayMemoryOld; //不考虑写入，所以只有新权重矩阵
 					// subArrayMemoryOld = CopySubArray(oldMemory, i*param->numRowSubArray, j*param->numColSubArray, numRowMatrix, numColMatrix);
 
 					// 理论上这里需要
-					vector<vector<double> > subArrayMemory; //至于subArrayMemory，使用一个随机生成的矩阵来代替原本的权重矩阵 TODO这里会影响到columnResistance的计算，但是对整体精度影响应该不大
-					subArrayMemory = CopySubArray(newMemory, i*param->numRowSubArray, j*param->numColSubArray, numRowMatrix, numColMatrix);
+					MatrixView subArrayMemory; //至于subArrayMemory，使用一个随机生成的矩阵来代替原本的权重矩阵 TODO这里会影响到columnResistance的计算，但是对整体精度影响应该不大
+					Matrix operandTile;	//由WeightOperand生成的subArray权重，subArrayMemory指向它
+					Matrix subArrayMemoryColumn;
+					if (!weightOperand) {	//WeightOperand只在缓存未命中时生成当前subArray对应的部分，避免实例化整个权重矩阵
+						subArrayMemory = CopySubArray(newMemory, i*param->numRowSubArray, j*param->numColSubArray, numRowMatrix, numColMatrix);
+					}
 					//输入向量理论上应该为一个token，如果为多个token
 
 					//input的划分方式不在基于行，而基于列
-					vector<vector<double> > fakeSubArrayInput; //由于这里获取输入的作用是计算columnResistance，因此获取一个全1的输入来表征Input的大小，同时让行全激活。 TODO这里修改input的含义，input的列数代表input数量（原本为input的列数/param-numBitInput)
+					BitMatrixView fakeSubArrayInput; //由于这里获取输入的作用是计算columnResistance，因此获取一个全1的输入来表征Input的大小，同时让行全激活。 TODO这里修改input的含义，input的列数代表input数量（原本为input的列数/param-numBitInput)
 					fakeSubArrayInput = CopySubInput(inputVector, i*param->numRowSubArray, numInVector, numRowMatrix);
 					
 					subArrayReadLatency = 0;
@@ -391,56 +433,82 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 					// 	subArray->layerNumber = layerNumber;
 					// }
 
-					double writeDynamicEnergyArray = 0;
-					int addNor = 0;
-					int mulNor = 0;
-					GetArrayEstimation(subArray,tech,cell,numRowMatrix,numColMatrix,&mulNor,&addNor,&writeDynamicEnergyArray);
-					subArray->addNor = addNor;
-					subArray->mulNor = mulNor;
-					subArray->writeDynamicEnergyArray = writeDynamicEnergyArray;
+					bool arrayEstimated = false;
+					SubArrayEstimation estimation = {0};
 					// cout<<"subarray digital is "<<subArray->parallelWrite<<endl;
+					vector<uint64_t> input;
 					for (int k=0; k<numInVector; k++) {                 // calculate single subArray through the total input vectors
 						double activityRowRead = 0;
-						vector<double> input;
-						input = GetInputVector(fakeSubArrayInput, k, &activityRowRead);
-						subArray->activityRowRead = activityRowRead;
+						GetInputVector(fakeSubArrayInput, k, input, &activityRowRead);
 						
-						int cellRange = pow(2, param->cellBit);
-						if (param->parallelRead) {
-							subArray->levelOutput = param->levelOutput;               // # of levels of the multilevelSenseAmp output
+						SubArrayEstimationKey key = {numRowMatrix, numColMatrix, activityRowRead, weightOperand? weightOperand->seed : 0, weightMatrixRow, weightMatrixCol};
+						map<SubArrayEstimationKey, SubArrayEstimation>::iterator it = subArrayEstimationCache->find(key);
+						if (param->cacheSubArray && it != subArrayEstimationCache->end()) {
+							estimation = it->second;
 						} else {
-							subArray->levelOutput = cellRange;
+							if (!arrayEstimated) {
+								double writeDynamicEnergyArray = 0;
+								int addNor = 0;
+								int mulNor = 0;
+								GetArrayEstimation(subArray,tech,cell,numRowMatrix,numColMatrix,&mulNor,&addNor,&writeDynamicEnergyArray);
+								subArray->addNor = addNor;
+								subArray->mulNor = mulNor;
+								subArray->writeDynamicEnergyArray = writeDynamicEnergyArray;
+								arrayEstimated = true;
+							}
+							if (subArrayMemory.empty()) {
+								operandTile = CopySubArray(*weightOperand, i*param->numRowSubArray, j*param->numColSubArray, numRowMatrix, numColMatrix);
+								subArrayMemory = operandTile;
+							}
+							if (subArrayMemoryColumn.empty()) {	//列主序副本只在第一次需要时生成，之后同一subArray的输入向量都复用
+								subArrayMemoryColumn = subArrayMemory.Transpose();
+							}
+							subArray->activityRowRead = activityRowRead;
+							
+							int cellRange = pow(2, param->cellBit);
+							if (param->parallelRead) {
+								subArray->levelOutput = param->levelOutput;               // # of levels of the multilevelSenseAmp output
+							} else {
+								subArray->levelOutput = cellRange;
+							}
+							
+							vector<double> columnResistance;
+							columnResistance = getColumnResistance(vector<vector<uint64_t> >(1, input), subArrayMemoryColumn, cell, subArray->resCellAccess)[0];
+							
+							vector<double> rowResistance;
+							if (param->trainingEstimation) {	// rowResistance只用于BP（转置）读路径
+								rowResistance = getRowResistance(subArrayMemory, cell, subArray->resCellAccess);
+							}
+							
+							subArray->CalculateLatency(1e20, columnResistance, rowResistance);
+							subArray->CalculatePower(columnResistance, rowResistance);
+							
+							estimation = GetSubArrayEstimation(subArray);
+							if (param->cacheSubArray) {
+								(*subArrayEstimationCache)[key] = estimation;
+							}
 						}
 						
-						vector<double> columnResistance;
-						columnResistance = GetColumnResistance(input, subArrayMemory, cell, param->parallelRead, subArray->resCellAccess);
-						
-						vector<double> rowResistance;
-						rowResistance = GetRowResistance(input, subArrayMemory, cell, param->parallelBP, subArray->resCellAccess);
-						
-						subArray->CalculateLatency(1e20, columnResistance, rowResistance);
-						subArray->CalculatePower(columnResistance, rowResistance);
-						
-						subArrayReadLatency += subArray->readLatency;
-						*readDynamicEnergy += subArray->readDynamicEnergy;
+						subArrayReadLatency += estimation.readLatency;
+						*readDynamicEnergy += estimation.readDynamicEnergy;
 						// cout<<"Subarray readLatency is "<<subArray->readLatency<<" Subarray arrayLatency is "<<subArray->writeLatencyArray <<endl;
-						subArrayLeakage = subArray->leakage;
-						subArrayReadLatencyAG += subArray->readLatencyAG*((param->trainingEstimation)==true? 1:0);
-						*readDynamicEnergyAG += subArray->readDynamicEnergyAG*((param->trainingEstimation)==true? 1:0);
+						subArrayLeakage = estimation.leakage;
+						subArrayReadLatencyAG += estimation.readLatencyAG*((param->trainingEstimation)==true? 1:0);
+						*readDynamicEnergyAG += estimation.readDynamicEnergyAG*((param->trainingEstimation)==true? 1:0);
 						
-						subArrayLatencyADC += subArray->readLatencyADC;
-						subArrayLatencyAccum += subArray->readLatencyAccum;
-						subArrayLatencyOther += subArray->readLatencyOther;
+						subArrayLatencyADC += estimation.readLatencyADC;
+						subArrayLatencyAccum += estimation.readLatencyAccum;
+						subArrayLatencyOther += estimation.readLatencyOther;
 						
-						*coreEnergyADC += subArray->readDynamicEnergyADC;
-						*coreEnergyAccum += subArray->readDynamicEnergyAccum;
-						*coreEnergyOther += subArray->readDynamicEnergyOther;
+						*coreEnergyADC += estimation.readDynamicEnergyADC;
+						*coreEnergyAccum += estimation.readDynamicEnergyAccum;
+						*coreEnergyOther += estimation.readDynamicEnergyOther;
 						
 					}
 					// accumulate write latency as array need to be write sequentially (worst case)
 					// limitation by on-chip buffer, write latency will be divided by numArrayWriteParallel (real case)
-					*writeLatencyWU += subArray->writeLatency*((param->trainingEstimation)==true? 1:0);
-					*writeDynamicEnergyWU += subArray->writeDynamicEnergy*((param->trainingEstimation)==true? 1:0);
+					*writeLatencyWU += estimation.writeLatency*((param->trainingEstimation)==true? 1:0);
+					*writeDynamicEnergyWU += estimation.writeDynamicEnergy*((param->trainingEstimation)==true? 1:0);
 					*readLatency = MAX(subArrayReadLatency, (*readLatency));
 					*readLatencyAG = MAX(subArrayReadLatencyAG, (*readLatencyAG));
 					*coreLatencyADC = MAX(subArrayLatencyADC, (*coreLatencyADC));
@@ -482,11 +550,12 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 					// sweep different sub-array
 					if ((i*param->numRowSubArray < weightMatrixRow) && (j*param->numColSubArray < weightMatrixCol) && (i*param->numRowSubArray < weightMatrixRow) ) {
 						// assign weight and input to specific subArray
-						vector<vector<double> > subArrayMemoryOld;
+						MatrixView subArrayMemoryOld;
 						subArrayMemoryOld = CopySubArray(oldMemory, i*param->numRowSubArray, j*param->numColSubArray, numRowMatrix, numColMatrix);
-						vector<vector<double> > subArrayMemory;
+						MatrixView subArrayMemory;
 						subArrayMemory = CopySubArray(newMemory, i*param->numRowSubArray, j*param->numColSubArray, numRowMatrix, numColMatrix);
-						vector<vector<double> > subArrayInput;
+						Matrix subArrayMemoryColumn = subArrayMemory.Transpose();	// 按列存放的副本，每个subArray只构建一次
+						BitMatrixView subArrayInput;
 						subArrayInput = CopySubInput(inputVector, i*param->numRowSubArray, numInVector, numRowMatrix);
 						
 						subArrayReadLatency = 0;
@@ -503,7 +572,7 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 							int totalNumWritePulse = 0;
 							double writeDynamicEnergyArray = 0;
 							
-							GetWriteUpdateEstimation(subArray, tech, cell, subArrayMemory, subArrayMemoryOld, 
+							getWriteUpdateEstimation(subArray, tech, cell, subArrayMemory, subArrayMemoryOld, 
 								&activityColWrite, &activityRowWrite, &numWritePulseAVG, &totalNumWritePulse, &writeDynamicEnergyArray);
 							
 							subArray->activityColWrite = activityColWrite;
@@ -514,41 +583,24 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 							subArray->layerNumber = layerNumber;
 						}
 
+						InputVectorBatch batch;	// 该subArray中相同的输入向量只评估一次
+						GetInputVectorBatch(subArray, cell, subArrayInput, numInVector, subArrayMemoryColumn, batch);
 						for (int k=0; k<numInVector; k++) {                 // calculate single subArray through the total input vectors
-							double activityRowRead = 0;
-							vector<double> input; 
-							input = GetInputVector(subArrayInput, k, &activityRowRead);
-							subArray->activityRowRead = activityRowRead;
-							
-							int cellRange = pow(2, param->cellBit);
-							if (param->parallelRead) {
-								subArray->levelOutput = param->levelOutput;               // # of levels of the multilevelSenseAmp output
-							} else {
-								subArray->levelOutput = cellRange;
-							}
-							
-							vector<double> columnResistance;
-							columnResistance = GetColumnResistance(input, subArrayMemory, cell, param->parallelRead, subArray->resCellAccess);
+							const SubArrayEstimation &estimation = EvaluateInputVector(subArray, cell, subArrayMemory, batch, k);
 							
-							vector<double> rowResistance;
-							rowResistance = GetRowResistance(input, subArrayMemory, cell, param->parallelBP, subArray->resCellAccess);
-							
-							subArray->CalculateLatency(1e20, columnResistance, rowResistance);
-							subArray->CalculatePower(columnResistance, rowResistance);
-							
-							subArrayReadLatency += subArray->readLatency;
-							*readDynamicEnergy += subArray->readDynamicEnergy;
-							subArrayLeakage = subArray->leakage;
-							subArrayReadLatencyAG += subArray->readLatencyAG*((param->trainingEstimation)==true? 1:0);
-							*readDynamicEnergyAG += subArray->readDynamicEnergyAG*((param->trainingEstimation)==true? 1:0);
-
-							subArrayLatencyADC += subArray->readLatencyADC;
-							subArrayLatencyAccum += subArray->readLatencyAccum;
-							subArrayLatencyOther += subArray->readLatencyOther;
+							subArrayReadLatency += estimation.readLatency;
+							*readDynamicEnergy += estimation.readDynamicEnergy;
+							subArrayLeakage = estimation.leakage;
+							subArrayReadLatencyAG += estimation.readLatencyAG*((param->trainingEstimation)==true? 1:0);
+							*readDynamicEnergyAG += estimation.readDynamicEnergyAG*((param->trainingEstimation)==true? 1:0);
+
+							subArrayLatencyADC += estimation.readLatencyADC;
+							subArrayLatencyAccum += estimation.readLatencyAccum;
+							subArrayLatencyOther += estimation.readLatencyOther;
 							
-							*coreEnergyADC += subArray->readDynamicEnergyADC;
-							*coreEnergyAccum += subArray->readDynamicEnergyAccum;
-							*coreEnergyOther += subArray->readDynamicEnergyOther;
+							*coreEnergyADC += estimation.readDynamicEnergyADC;
+							*coreEnergyAccum += estimation.readDynamicEnergyAccum;
+							*coreEnergyOther += estimation.readDynamicEnergyOther;
 						}
 						// accumulate write latency as array need to be write sequentially (worst case)
 						// limitation by on-chip buffer, write latency will be divided by numArrayWriteParallel (real case)
@@ -594,11 +646,12 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 			*coreLatencyOther = (*coreLatencyOther)/(arrayDupRow*arrayDupCol);
 		} else {
 			// assign weight and input to specific subArray
-			vector<vector<double> > subArrayMemoryOld;
+			MatrixView subArrayMemoryOld;
 			subArrayMemoryOld = CopySubArray(oldMemory, 0, 0, weightMatrixRow, weightMatrixCol);
-			vector<vector<double> > subArrayMemory;
+			MatrixView subArrayMemory;
 			subArrayMemory = CopySubArray(newMemory, 0, 0, weightMatrixRow, weightMatrixCol);
-			vector<vector<double> > subArrayInput;
+			Matrix subArrayMemoryColumn = subArrayMemory.Transpose();
+			BitMatrixView subArrayInput;
 			subArrayInput = CopySubInput(inputVector, 0, numInVector, weightMatrixRow);
 
 			subArrayReadLatency = 0;
@@ -615,7 +668,7 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 				int totalNumWritePulse = 0;
 				double writeDynamicEnergyArray = 0;
 				
-				GetWriteUpdateEstimation(subArray, tech, cell, subArrayMemory, subArrayMemoryOld, 
+				getWriteUpdateEstimation(subArray, tech, cell, subArrayMemory, subArrayMemoryOld, 
 					&activityColWrite, &activityRowWrite, &numWritePulseAVG, &totalNumWritePulse, &writeDynamicEnergyArray);
 				
 				subArray->activityColWrite = activityColWrite;
@@ -626,41 +679,24 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 				subArray->layerNumber = layerNumber;
 			}
 
+			InputVectorBatch batch;
+			GetInputVectorBatch(subArray, cell, subArrayInput, numInVector, subArrayMemoryColumn, batch);
 			for (int k=0; k<numInVector; k++) {                 // calculate single subArray through the total input vectors
-				double activityRowRead = 0;
-				vector<double> input;
-				input = GetInputVector(subArrayInput, k, &activityRowRead);
-				subArray->activityRowRead = activityRowRead;
-				int cellRange = pow(2, param->cellBit);
+				const SubArrayEstimation &estimation = EvaluateInputVector(subArray, cell, subArrayMemory, batch, k);
 				
-				if (param->parallelRead) {
-					subArray->levelOutput = param->levelOutput;               // # of levels of the multilevelSenseAmp output
-				} else {
-					subArray->levelOutput = cellRange;
-				}
-				
-				vector<double> columnResistance;
-				columnResistance = GetColumnResistance(input, subArrayMemory, cell, param->parallelRead, subArray->resCellAccess);
-				
-				vector<double> rowResistance;
-				rowResistance = GetRowResistance(input, subArrayMemory, cell, param->parallelBP, subArray->resCellAccess);
+				subArrayReadLatency += estimation.readLatency;
+				*readDynamicEnergy += estimation.readDynamicEnergy;
+				subArrayLeakage = estimation.leakage;
+				subArrayReadLatencyAG += estimation.readLatencyAG*((param->trainingEstimation)==true? 1:0);
+				*readDynamicEnergyAG += estimation.readDynamicEnergyAG*((param->trainingEstimation)==true? 1:0);
 				
-				subArray->CalculateLatency(1e20, columnResistance, rowResistance);
-				subArray->CalculatePower(columnResistance, rowResistance);
+				subArrayLatencyADC += estimation.readLatencyADC;
+				subArrayLatencyAccum += estimation.readLatencyAccum;
+				subArrayLatencyOther += estimation.readLatencyOther;
 				
-				subArrayReadLatency += subArray->readLatency;
-				*readDynamicEnergy += subArray->readDynamicEnergy;
-				subArrayLeakage = subArray->leakage;
-				subArrayReadLatencyAG += subArray->readLatencyAG*((param->trainingEstimation)==true? 1:0);
-				*readDynamicEnergyAG += subArray->readDynamicEnergyAG*((param->trainingEstimation)==true? 1:0);
-				
-				subArrayLatencyADC += subArray->readLatencyADC;
-				subArrayLatencyAccum += subArray->readLatencyAccum;
-				subArrayLatencyOther += subArray->readLatencyOther;
-				
-				*coreEnergyADC += subArray->readDynamicEnergyADC;
-				*coreEnergyAccum += subArray->readDynamicEnergyAccum;
-				*coreEnergyOther += subArray->readDynamicEnergyOther;
+				*coreEnergyADC += estimation.readDynamicEnergyADC;
+				*coreEnergyAccum += estimation.readDynamicEnergyAccum;
+				*coreEnergyOther += estimation.readDynamicEnergyOther;
 			}
 			*writeLatencyWU += subArray->writeLatency*((param->trainingEstimation)==true? 1:0);
 			*writeDynamicEnergyWU += subArray->writeDynamicEnergy*(arrayDupRow*arrayDupCol)*((param->trainingEstimation)==true? 1:0);
@@ -679,11 +715,12 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 					int numRowMatrix = min(param->numRowSubArray, weightMatrixRow-i*param->numRowSubArray);
 					int numColMatrix = min(param->numColSubArray, weightMatrixCol-j*param->numColSubArray);
 					// assign weight and input to specific subArray
-					vector<vector<double> > subArrayMemoryOld;
+					MatrixView subArrayMemoryOld;
 					subArrayMemoryOld = CopySubArray(oldMemory, i*param->numRowSubArray, j*param->numColSubArray, numRowMatrix, numColMatrix);
-					vector<vector<double> > subArrayMemory;
+					MatrixView subArrayMemory;
 					subArrayMemory = CopySubArray(newMemory, i*param->numRowSubArray, j*param->numColSubArray, numRowMatrix, numColMatrix);
-					vector<vector<double> > subArrayInput;
+					Matrix subArrayMemoryColumn = subArrayMemory.Transpose();
+					BitMatrixView subArrayInput;
 					subArrayInput = CopySubInput(inputVector, i*param->numRowSubArray, numInVector, numRowMatrix);
 					
 					subArrayReadLatency = 0;
@@ -700,7 +737,7 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 						int totalNumWritePulse = 0;
 						double writeDynamicEnergyArray = 0;
 						
-						GetWriteUpdateEstimation(subArray, tech, cell, subArrayMemory, subArrayMemoryOld, 
+						getWriteUpdateEstimation(subArray, tech, cell, subArrayMemory, subArrayMemoryOld, 
 							&activityColWrite, &activityRowWrite, &numWritePulseAVG, &totalNumWritePulse, &writeDynamicEnergyArray);
 						
 						subArray->activityColWrite = activityColWrite;
@@ -711,41 +748,24 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 						subArray->layerNumber = layerNumber;
 					}
 
+					InputVectorBatch batch;
+					GetInputVectorBatch(subArray, cell, subArrayInput, numInVector, subArrayMemoryColumn, batch);
 					for (int k=0; k<numInVector; k++) {                 // calculate single subArray through the total input vectors
-						double activityRowRead = 0;
-						vector<double> input;
-						input = GetInputVector(subArrayInput, k, &activityRowRead);
-						subArray->activityRowRead = activityRowRead;
+						const SubArrayEstimation &estimation = EvaluateInputVector(subArray, cell, subArrayMemory, batch, k);
 						
-						int cellRange = pow(2, param->cellBit);
-						if (param->parallelRead) {
-							subArray->levelOutput = param->levelOutput;               // # of levels of the multilevelSenseAmp output
-						} else {
-							subArray->levelOutput = cellRange;
-						}
-						
-						vector<double> columnResistance;
-						columnResistance = GetColumnResistance(input, subArrayMemory, cell, param->parallelRead, subArray->resCellAccess);
-						
-						vector<double> rowResistance;
-						rowResistance = GetRowResistance(input, subArrayMemory, cell, param->parallelBP, subArray->resCellAccess);
-						
-						subArray->CalculateLatency(1e20, columnResistance, rowResistance);
-						subArray->CalculatePower(columnResistance, rowResistance);
-						
-						subArrayReadLatency += subArray->readLatency;
-						*readDynamicEnergy += subArray->readDynamicEnergy;
-						subArrayLeakage = subArray->leakage;
-						subArrayReadLatencyAG += subArray->readLatencyAG*((param->trainingEstimation)==true? 1:0);
-						*readDynamicEnergyAG += subArray->readDynamicEnergyAG*((param->trainingEstimation)==true? 1:0);
+						subArrayReadLatency += estimation.readLatency;
+						*readDynamicEnergy += estimation.readDynamicEnergy;
+						subArrayLeakage = estimation.leakage;
+						subArrayReadLatencyAG += estimation.readLatencyAG*((param->trainingEstimation)==true? 1:0);
+						*readDynamicEnergyAG += estimation.readDynamicEnergyAG*((param->trainingEstimation)==true? 1:0);
 						
-						subArrayLatencyADC += subArray->readLatencyADC;
-						subArrayLatencyAccum += subArray->readLatencyAccum;
-						subArrayLatencyOther += subArray->readLatencyOther;
+						subArrayLatencyADC += estimation.readLatencyADC;
+						subArrayLatencyAccum += estimation.readLatencyAccum;
+						subArrayLatencyOther += estimation.readLatencyOther;
 						
-						*coreEnergyADC += subArray->readDynamicEnergyADC;
-						*coreEnergyAccum += subArray->readDynamicEnergyAccum;
-						*coreEnergyOther += subArray->readDynamicEnergyOther;
+						*coreEnergyADC += estimation.readDynamicEnergyADC;
+						*coreEnergyAccum += estimation.readDynamicEnergyAccum;
+						*coreEnergyOther += estimation.readDynamicEnergyOther;
 						
 					}
 					// accumulate write latency as array need to be write sequentially (worst case)
@@ -855,147 +875,380 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 }
 
 
-vector<vector<double> > CopySubArray(const vector<vector<double> > &orginal, int positionRow, int positionCol, int numRow, int numCol) {
-	vector<vector<double> > copy;
-	for (int i=0; i<numRow; i++) {
-		vector<double> copyRow;
-		for (int j=0; j<numCol; j++) {
-			copyRow.push_back(orginal[positionRow+i][positionCol+j]);
-		}
-		copy.push_back(copyRow);
-		copyRow.clear();
+SubArrayEstimation GetSubArrayEstimation(const SubArray *subArray) {
+	SubArrayEstimation estimation;
+	estimation.readLatency = subArray->readLatency;
+	estimation.readDynamicEnergy = subArray->readDynamicEnergy;
+	estimation.leakage = subArray->leakage;
+	estimation.readLatencyAG = subArray->readLatencyAG;
+	estimation.readDynamicEnergyAG = subArray->readDynamicEnergyAG;
+	estimation.readLatencyADC = subArray->readLatencyADC;
+	estimation.readLatencyAccum = subArray->readLatencyAccum;
+	estimation.readLatencyOther = subArray->readLatencyOther;
+	estimation.readDynamicEnergyADC = subArray->readDynamicEnergyADC;
+	estimation.readDynamicEnergyAccum = subArray->readDynamicEnergyAccum;
+	estimation.readDynamicEnergyOther = subArray->readDynamicEnergyOther;
+	estimation.writeLatency = subArray->writeLatency;
+	estimation.writeDynamicEnergy = subArray->writeDynamicEnergy;
+	return estimation;
+}
+
+
+size_t InputVectorHash::operator()(const vector<uint64_t> &input) const {
+	uint64_t hash = 14695981039346656037ULL;	// 对打包的输入位做FNV-1a哈希
+	for (int i=0; i<input.size(); i++) {
+		hash = (hash ^ input[i]) * 1099511628211ULL;
 	}
-	return copy;
-	copy.clear();
-} 
+	return (size_t) hash;
+}
 
 
-vector<vector<double> > CopySubInput(const vector<vector<double> > &orginal, int positionRow, int numInputVector, int numRow) {
-	vector<vector<double> > copy;
-	for (int i=0; i<numRow; i++) {
-		vector<double> copyRow;
-		for (int j=0; j<numInputVector; j++) {
-			copyRow.push_back(orginal[positionRow+i][j]);
+// 收集一个subArray中互不相同的输入向量，一次批量计算它们的列电阻
+// 这样每个subArray的权重只遍历一次，而不是每个输入向量遍历一次
+void GetInputVectorBatch(SubArray *subArray, MemCell& cell, const BitMatrixView &input, int numInVector, const MatrixView &subArrayMemoryColumn, InputVectorBatch &batch) {
+	InputVectorMemo inputMemo;
+	vector<uint64_t> bits;
+	batch.index.resize(numInVector);
+	for (int k=0; k<numInVector; k++) {
+		double activityRowRead = 0;
+		GetInputVector(input, k, bits, &activityRowRead);
+		InputVectorMemo::iterator it = inputMemo.find(bits);
+		if (it == inputMemo.end()) {
+			it = inputMemo.insert(make_pair(bits, (int) batch.vectors.size())).first;
+			batch.vectors.push_back(bits);
+			batch.activityRowRead.push_back(activityRowRead);
 		}
-		copy.push_back(copyRow);
-		copyRow.clear();
+		batch.index[k] = it->second;
 	}
-	return copy;
-	copy.clear();
+	batch.columnResistance = getColumnResistance(batch.vectors, subArrayMemoryColumn, cell, subArray->resCellAccess);
+	batch.estimation.resize(batch.vectors.size());
+	batch.evaluated.assign(batch.vectors.size(), false);
+	batch.numVisited = 0;
+	subArray->ClearPrepared();	// 上一批之后subArray的写路径状态可能已改变
 }
 
 
-vector<double> GetInputVector(const vector<vector<double> > &input, int numInput, double *activityRowRead) {
-	vector<double> copy;
-	for (int i=0; i<input.size(); i++) {
-		double x = input[i][numInput];
-		copy.push_back(x);   
-	}  
-	double numofreadrow = 0;  // initialize readrowactivity parameters
-	for (int i=0; i<input.size(); i++) {
-		if (copy[i] != 0) {
-			numofreadrow += 1;
-		}else {
-			numofreadrow += 0;
+// 评估输入向量v，以及批中尚未评估、activityRowRead与之相同的所有向量：
+// 第一个向量走完整模型(Prepare)，其余向量只批量重新评估sense amp / ADC部分
+static void EvaluateActivityGroup(SubArray *subArray, MemCell& cell, const MatrixView &subArrayMemory, InputVectorBatch &batch, int v) {
+	subArray->activityRowRead = batch.activityRowRead[v];
+	
+	int cellRange = pow(2, param->cellBit);
+	if (param->parallelRead) {
+		subArray->levelOutput = param->levelOutput;               // # of levels of the multilevelSenseAmp output
+	} else {
+		subArray->levelOutput = cellRange;
+	}
+	
+	if (!subArray->IsPrepared()) {
+		vector<double> rowResistance;
+		if (param->trainingEstimation) {
+			rowResistance = getRowResistance(subArrayMemory, cell, subArray->resCellAccess);
 		}
+		subArray->Prepare(batch.columnResistance[v], rowResistance);
+		batch.estimation[v] = GetSubArrayEstimation(subArray);
+		batch.evaluated[v] = true;
+		numInputVectorEvaluated++;
 	}
+	
+	vector<int> group;
+	for (int u=v; u<batch.vectors.size(); u++) {
+		if (!batch.evaluated[u] && batch.activityRowRead[u] == batch.activityRowRead[v]) {
+			group.push_back(u);
+		}
+	}
+	if (group.empty()) {
+		return;
+	}
+	int numColumn = batch.columnResistance[v].size();
+	vector<double> columnResistance((long)group.size()*numColumn);
+	for (int g=0; g<group.size(); g++) {
+		copy(batch.columnResistance[group[g]].begin(), batch.columnResistance[group[g]].end(), columnResistance.begin() + (long)g*numColumn);
+	}
+	vector<SubArrayEstimation> estimation(group.size());
+	subArray->EvaluateBatch(columnResistance.empty()? NULL : &columnResistance[0], group.size(), numColumn, &estimation[0]);
+	for (int g=0; g<group.size(); g++) {
+		batch.estimation[group[g]] = estimation[g];
+		batch.evaluated[group[g]] = true;
+	}
+	numInputVectorEvaluated += group.size();
+}
+
+// subArray权重固定后，评估结果只取决于输入向量
+// 因此重复的输入向量（例如全0的bit plane）直接复用第一次评估的结果
+const SubArrayEstimation& EvaluateInputVector(SubArray *subArray, MemCell& cell, const MatrixView &subArrayMemory, InputVectorBatch &batch, int k) {
+	int v = batch.index[k];
+	if (v < batch.numVisited) {
+		numInputVectorReused++;
+	} else {
+		batch.numVisited++;
+	}
+	if (!batch.evaluated[v]) {
+		EvaluateActivityGroup(subArray, cell, subArrayMemory, batch, v);
+	}
+	// 使subArray的状态与逐个评估时循环结束后的状态一致
+	subArray->writeLatency = batch.estimation[v].writeLatency;
+	subArray->writeDynamicEnergy = batch.estimation[v].writeDynamicEnergy;
+	return batch.estimation[v];
+}
+
+
+void ProcessingUnitGetInputVectorStats(long *numEvaluated, long *numReused) {
+	*numEvaluated = numInputVectorEvaluated;
+	*numReused = numInputVectorReused;
+}
+
+
+void ProcessingUnitResetInputVectorStats() {
+	numInputVectorEvaluated = 0;
+	numInputVectorReused = 0;
+}
+
+
+ProcessingUnitComponents ProcessingUnitGetComponents() {
+	ProcessingUnitComponents components;
+	components.adderTreeNM = adderTreeNM;
+	components.busInputNM = busInputNM;
+	components.busOutputNM = busOutputNM;
+	components.bufferInputNM = bufferInputNM;
+	components.bufferOutputNM = bufferOutputNM;
+	components.adderTreeCM = adderTreeCM;
+	components.busInputCM = busInputCM;
+	components.busOutputCM = busOutputCM;
+	components.bufferInputCM = bufferInputCM;
+	components.bufferOutputCM = bufferOutputCM;
+	components.subArrayEstimationCache = subArrayEstimationCache;
+	components.getColumnResistance = getColumnResistance;
+	components.getRowResistance = getRowResistance;
+	components.getWriteUpdateEstimation = getWriteUpdateEstimation;
+	return components;
+}
+
+
+ProcessingUnitComponents ProcessingUnitCopyComponents(const ProcessingUnitComponents &original) {
+	ProcessingUnitComponents components;
+	components.adderTreeNM = new AdderTree(*original.adderTreeNM);
+	components.busInputNM = new Bus(*original.busInputNM);
+	components.busOutputNM = new Bus(*original.busOutputNM);
+	components.bufferInputNM = new DFF(*original.bufferInputNM);
+	components.bufferOutputNM = new DFF(*original.bufferOutputNM);
+	components.adderTreeCM = new AdderTree(*original.adderTreeCM);
+	components.busInputCM = new Bus(*original.busInputCM);
+	components.busOutputCM = new Bus(*original.busOutputCM);
+	components.bufferInputCM = new DFF(*original.bufferInputCM);
+	components.bufferOutputCM = new DFF(*original.bufferOutputCM);
+	components.subArrayEstimationCache = new map<SubArrayEstimationKey, SubArrayEstimation>(*original.subArrayEstimationCache);
+	components.getColumnResistance = original.getColumnResistance;
+	components.getRowResistance = original.getRowResistance;
+	components.getWriteUpdateEstimation = original.getWriteUpdateEstimation;
+	return components;
+}
+
+
+void ProcessingUnitSetComponents(const ProcessingUnitComponents &components) {
+	adderTreeNM = components.adderTreeNM;
+	busInputNM = components.busInputNM;
+	busOutputNM = components.busOutputNM;
+	bufferInputNM = components.bufferInputNM;
+	bufferOutputNM = components.bufferOutputNM;
+	adderTreeCM = components.adderTreeCM;
+	busInputCM = components.busInputCM;
+	busOutputCM = components.busOutputCM;
+	bufferInputCM = components.bufferInputCM;
+	bufferOutputCM = components.bufferOutputCM;
+	subArrayEstimationCache = components.subArrayEstimationCache;
+	getColumnResistance = components.getColumnResistance;
+	getRowResistance = components.getRowResistance;
+	getWriteUpdateEstimation = components.getWriteUpdateEstimation;
+}
+
+
+void ProcessingUnitDeleteComponents(ProcessingUnitComponents &components) {
+	delete components.adderTreeNM;
+	delete components.busInputNM;
+	delete components.busOutputNM;
+	delete components.bufferInputNM;
+	delete components.bufferOutputNM;
+	delete components.adderTreeCM;
+	delete components.busInputCM;
+	delete components.busOutputCM;
+	delete components.bufferInputCM;
+	delete components.bufferOutputCM;
+	delete components.subArrayEstimationCache;
+}
+
+
+MatrixView CopySubArray(const MatrixView &orginal, int positionRow, int positionCol, int numRow, int numCol) {
+	return orginal.SubView(positionRow, positionCol, numRow, numCol);
+} 
+
+
+Matrix CopySubArray(const WeightOperand &orginal, int positionRow, int positionCol, int numRow, int numCol) {
+	return orginal.GetTile(positionRow, positionCol, numRow, numCol);
+}
+
+
+BitMatrixView CopySubInput(const BitMatrixView &orginal, int positionRow, int numInputVector, int numRow) {
+	return orginal.SubView(positionRow, 0, numRow, numInputVector);
+}
+
+
+// 输入向量是一个bit plane（每行0/1），激活的行数即打包位的popcount
+void GetInputVector(const BitMatrixView &input, int numInput, vector<uint64_t> &bits, double *activityRowRead) {
+	double numofreadrow = input.GetColumn(numInput, bits);  // initialize readrowactivity parameters
 	double totalnumRow = input.size();
 	*(activityRowRead) = numofreadrow/totalnumRow;
-	return copy;
-	copy.clear();
 } 
 
 
-vector<double> GetColumnResistance(const vector<double> &input, const vector<vector<double> > &weight, MemCell& cell, bool parallelRead, double resCellAccess) {
-	vector<double> resistance;
-	vector<double> conductance;
-	double columnG = 0; 
+// 不考虑导线电阻(wireWidth == -1)，或导线电阻相对所有cell电阻都可忽略时，cell的电导只取决于其等级
+static bool WireResistanceNegligible(const MatrixView &weightColumn, double accessResistance) {
+	if (param->wireResistanceRow == 0 && param->wireResistanceCol == 0) {
+		return true;
+	}
+	double maxWireResistance = weightColumn.size() * param->wireResistanceRow + weightColumn.numCol * param->wireResistanceCol;
+	double minCellResistance = 0;
+	for (int l=0; l<weightColumn.numLevel; l++) {
+		if (l == 0 || weightColumn.resistance[l] < minCellResistance) {
+			minCellResistance = weightColumn.resistance[l];
+		}
+	}
+	return maxWireResistance < param->wireResistanceTolerance * (minCellResistance + accessResistance);
+}
+
+
+// cell电导只取决于等级时的列电导：
+// 每列为每个等级保存一个行掩码，一个输入向量按等级计算popcount(levelMask & input)即可
+static void GetColumnConductanceByLevel(const MatrixView &weightColumn, double accessResistance, const vector<uint64_t> &mask, int numVector, vector<double> &conductance) {
+	int numRow = weightColumn.numCol;
+	int numCol = weightColumn.size();
+	int numLevel = weightColumn.numLevel;
+	int numWord = (numRow + 63)/64;
 	
-	for (int j=0; j<weight[0].size(); j++) {
-		int activatedRow = 0;
-		columnG = 0;
-		for (int i=0; i<weight.size(); i++) {
-			if (cell.memCellType == Type::RRAM) {	// eNVM
-				double totalWireResistance;
-				if (cell.accessType == CMOS_access) {
-					totalWireResistance = (double) 1.0/weight[i][j] + (j + 1) * param->wireResistanceRow + (weight.size() - i) * param->wireResistanceCol + cell.resistanceAccess;
-				} else {
-					totalWireResistance = (double) 1.0/weight[i][j] + (j + 1) * param->wireResistanceRow + (weight.size() - i) * param->wireResistanceCol;
-				}
-				if ((int) input[i] == 1) {
-					columnG += (double) 1.0/totalWireResistance;
-					activatedRow += 1 ;
-				} else {
-					columnG += 0;
+	vector<double> levelConductance(numLevel);
+	for (int l=0; l<numLevel; l++) {
+		levelConductance[l] = (double) 1.0/(weightColumn.resistance[l] + accessResistance);
+	}
+	vector<uint64_t> levelMask((long)numCol*numLevel*numWord, 0);
+	for (int j=0; j<numCol; j++) {
+		const uint8_t *level = weightColumn[j];
+		for (int i=0; i<numRow; i++) {
+			levelMask[((long)j*numLevel + level[i])*numWord + i/64] |= (uint64_t) 1 << (i%64);
+		}
+	}
+	for (int v=0; v<numVector; v++) {
+		const uint64_t *input = &mask[(long)v*numWord];
+		for (int j=0; j<numCol; j++) {
+			double columnG = 0;
+			for (int l=0; l<numLevel; l++) {
+				const uint64_t *rowMask = &levelMask[((long)j*numLevel + l)*numWord];
+				int numActivated = 0;
+				for (int w=0; w<numWord; w++) {
+					numActivated += __builtin_popcountll(rowMask[w] & input[w]);
 				}
-			} else if (cell.memCellType == Type::FeFET) {
-				double totalWireResistance;
-				totalWireResistance = (double) 1.0/weight[i][j] + (j + 1) * param->wireResistanceRow + (weight.size() - i) * param->wireResistanceCol;
-				if ((int) input[i] == 1) {
-					columnG += (double) 1.0/totalWireResistance;
-					activatedRow += 1 ;
-				} else {
-					columnG += 0;
+				columnG += numActivated * levelConductance[l];
+			}
+			conductance[(long)v*numCol + j] = columnG;
+		}
+	}
+}
+
+
+// weightColumn按列存放subArray的权重（weightColumn的第j行即subArray的第j列）
+// 每个cell的等效电导（含其看到的导线电阻和access电阻）与输入无关，只计算一次，所有输入向量的列电导即一次带掩码的G^T*X乘积
+// 存储单元类型、access类型和读模式为模板参数，每个实例只保留自己的分支
+template <Type::MemCellType memCellType, bool cmosAccess, bool parallelRead>
+vector<vector<double> > GetColumnResistance(const vector<vector<uint64_t> > &inputs, const MatrixView &weightColumn, MemCell& cell, double resCellAccess) {
+	int numRow = weightColumn.numCol;
+	int numCol = weightColumn.size();
+	int numVector = inputs.size();
+	int numWord = (numRow + 63)/64;
+	vector<vector<double> > resistance(numVector);
+	vector<double> conductance((long)numVector*numCol, 0);
+	
+	vector<int> activatedRow(numVector, 0);
+	vector<uint64_t> mask((long)numVector*numWord);
+	for (int v=0; v<numVector; v++) {
+		for (int w=0; w<numWord; w++) {
+			mask[(long)v*numWord + w] = inputs[v][w];
+			activatedRow[v] += __builtin_popcountll(inputs[v][w]);
+		}
+	}
+	
+	if (memCellType == Type::RRAM || memCellType == Type::FeFET) {	// eNVM
+		double accessResistance = (memCellType == Type::RRAM && cmosAccess)? cell.resistanceAccess : 0;
+		// 按等级统计每列需要numLevel*numWord次popcount，而不是numRow次加法
+		if (numVector > 0 && weightColumn.numLevel*numWord <= numRow && WireResistanceNegligible(weightColumn, accessResistance)) {
+			GetColumnConductanceByLevel(weightColumn, accessResistance, mask, numVector, conductance);
+		} else {
+			vector<double> cellConductance((long)numCol*numRow);
+			for (int j=0; j<numCol; j++) {
+				const uint8_t *level = weightColumn[j];
+				double *g = &cellConductance[(long)j*numRow];
+				for (int i=0; i<numRow; i++) {	// cell电阻由等级表查得，而不是1/weight
+					g[i] = (double) 1.0/(weightColumn.resistance[level[i]] + (j + 1) * param->wireResistanceRow + (numRow - i) * param->wireResistanceCol + accessResistance);
 				}
-				
-			} else if (cell.memCellType == Type::SRAM) {	
-				// SRAM: weight value do not affect sense energy --> read energy calculated in subArray.cpp (based on wireRes wireCap etc)
-				double totalWireResistance = (double) (resCellAccess + param->wireResistanceCol);
-				if ((int) input[i] == 1) {
-					columnG += (double) 1.0/totalWireResistance;
-					activatedRow += 1 ;
-				} else {
-					columnG += 0;
+			}
+			if (numVector > 0) {
+				GetColumnConductanceBatchKernel()(&cellConductance[0], numCol, numRow, &mask[0], numVector, &conductance[0]);
+			}
+		}
+		if (!parallelRead) {
+			for (int v=0; v<numVector; v++) {
+				for (int j=0; j<numCol; j++) {
+					conductance[(long)v*numCol + j] /= activatedRow[v];
 				}
 			}
 		}
-		
-		if (cell.memCellType == Type::RRAM || cell.memCellType == Type::FeFET) {
-			if (!parallelRead) {  
-				conductance.push_back((double) columnG/activatedRow);
-			} else {
-				conductance.push_back(columnG);
+	} else if (memCellType == Type::SRAM) {
+		// SRAM: weight value do not affect sense energy --> read energy calculated in subArray.cpp (based on wireRes wireCap etc)
+		double totalWireResistance = (double) (resCellAccess + param->wireResistanceCol);
+		for (int v=0; v<numVector; v++) {
+			double columnG = 0;
+			for (int i=0; i<activatedRow[v]; i++) {
+				columnG += (double) 1.0/totalWireResistance;
 			}
-		} else {
-			conductance.push_back(columnG);
+			fill(conductance.begin() + (long)v*numCol, conductance.begin() + (long)(v+1)*numCol, columnG);
 		}
 	}
 	// covert conductance to resistance
-	for (int i=0; i<weight[0].size(); i++) {
-		resistance.push_back((double) 1.0/conductance[i]);
+	for (int v=0; v<numVector; v++) {
+		for (int i=0; i<numCol; i++) {
+			resistance[v].push_back((double) 1.0/conductance[(long)v*numCol + i]);
+		}
 	}
 		
 	return resistance;
-	resistance.clear();
 } 
 
 
-vector<double> GetRowResistance(const vector<double> &input, const vector<vector<double> > &weight, MemCell& cell, bool parallelRead, double resCellAccess) {
+template <Type::MemCellType memCellType, bool cmosAccess, bool parallelRead>
+vector<double> GetRowResistance(const MatrixView &weight, MemCell& cell, double resCellAccess) {
 	vector<double> resistance;
 	vector<double> conductance;
 	double rowG = 0; 
 	double totalWireResistance;
 	
+	// 行电导只取决于该行最后一个cell (j = numCol-1) 看到的导线电阻，直接计算这一项，不再遍历每一列
+	int lastCol = weight.numCol - 1;
+	int activatedCol = ceil(weight.numCol/2);  // assume 50% of the input vector is 1
 	for (int i=0; i<weight.size(); i++) {
-		int activatedCol = ceil(weight[0].size()/2);  // assume 50% of the input vector is 1
 		rowG = 0;
-		for (int j=0; j<weight[0].size(); j++) {
-			if (cell.memCellType == Type::RRAM) {	// eNVM
-				if (cell.accessType == CMOS_access) {
-					totalWireResistance = (double) 1.0/weight[i][j] + (i + 1) * param->wireResistanceRow + (weight[0].size() - j) * param->wireResistanceCol + cell.resistanceAccess;
-				} else {
-					totalWireResistance = (double) 1.0/weight[i][j] + (i + 1) * param->wireResistanceRow + (weight[0].size() - j) * param->wireResistanceCol;
-				}
-			} else if (cell.memCellType == Type::FeFET) {
-				totalWireResistance = (double) 1.0/weight[i][j] + (i + 1) * param->wireResistanceRow + (weight[0].size() - j) * param->wireResistanceCol;
-			} else if (cell.memCellType == Type::SRAM) {	
-				// SRAM: weight value do not affect sense energy --> read energy calculated in subArray.cpp (based on wireRes wireCap etc)
-				totalWireResistance = (double) (resCellAccess + param->wireResistanceCol);
+		if (memCellType == Type::RRAM) {	// eNVM
+			if (cmosAccess) {
+				totalWireResistance = weight.Resistance(i, lastCol) + (i + 1) * param->wireResistanceRow + (weight.numCol - lastCol) * param->wireResistanceCol + cell.resistanceAccess;
+			} else {
+				totalWireResistance = weight.Resistance(i, lastCol) + (i + 1) * param->wireResistanceRow + (weight.numCol - lastCol) * param->wireResistanceCol;
 			}
+		} else if (memCellType == Type::FeFET) {
+			totalWireResistance = weight.Resistance(i, lastCol) + (i + 1) * param->wireResistanceRow + (weight.numCol - lastCol) * param->wireResistanceCol;
+		} else if (memCellType == Type::SRAM) {	
+			// SRAM: weight value do not affect sense energy --> read energy calculated in subArray.cpp (based on wireRes wireCap etc)
+			totalWireResistance = (double) (resCellAccess + param->wireResistanceCol);
 		}
 		rowG = (double) 1.0/totalWireResistance * activatedCol;
 		
-		if (cell.memCellType == Type::RRAM || cell.memCellType == Type::FeFET) {
+		if (memCellType == Type::RRAM || memCellType == Type::FeFET) {
 			if (!parallelRead) {  
 				conductance.push_back((double) rowG/activatedCol);
 			} else {
@@ -1016,7 +1269,36 @@ vector<double> GetRowResistance(const vector<double> &input, const vector<vector
 } 
 
 
-void GetWriteUpdateEstimation(SubArray *subArray, Technology& tech, MemCell& cell, const vector<vector<double> > &newMemory, const vector<vector<double> > &oldMemory, 
+// cell的电导等级只有少数几个，一个cell的写入只取决于(新等级, 旧等级)这一对
+// 每一对的脉冲数和能量只计算一次，其余相同等级对的cell直接查表
+template <Type::MemCellType memCellType>
+static WriteTransition GetWriteTransition(Technology& tech, MemCell& cell, double newWeight, double oldWeight, double minDeltaConductance, int maxNumWritePulse) {
+	WriteTransition transition = {true, 0, 0, 0, 0};
+	if (memCellType != Type::SRAM) { // eNVM
+		if (abs(newWeight-oldWeight) >= minDeltaConductance) {
+			transition.state = (newWeight > oldWeight)? 1 : -1;  // LTP : LTD
+			transition.numPulse = (int)ceil(abs(newWeight-oldWeight)/minDeltaConductance);
+			transition.energy = cell.writeVoltage * cell.writeVoltage / (abs(1/newWeight + 1/oldWeight)/2) * cell.writePulseWidth * transition.numPulse *((memCellType == Type::FeFET)==true? 0:1);
+			if (memCellType == Type::FeFET) { //FeFET
+				double newPr = (newWeight/minDeltaConductance-maxNumWritePulse/2)*(param->polarization*2/maxNumWritePulse);
+				double oldPr = (oldWeight/minDeltaConductance-maxNumWritePulse/2)*(param->polarization*2/maxNumWritePulse);
+				// assume pr and conductance are linear mapped
+				double deltaPr = abs(newPr+(param->polarization))+abs(oldPr+(param->polarization));  // uC/cm^2 (assume erase before program)
+				transition.energyPolarization = deltaPr*0.01*cell.writeVoltage*(2*tech.featureSize*tech.featureSize);
+			}
+		}
+	} else {  // SRAM
+		if (newWeight != oldWeight) {
+			transition.state = (newWeight > oldWeight)? 1 : -1;
+			transition.numPulse = 1;
+		}
+	}
+	return transition;
+}
+
+
+template <Type::MemCellType memCellType>
+void GetWriteUpdateEstimation(SubArray *subArray, Technology& tech, MemCell& cell, const MatrixView &newMemory, const MatrixView &oldMemory, 
 								double *activityColWrite, double *activityRowWrite, int *numWritePulseAVG, int *totalNumWritePulse, double *writeDynamicEnergyArray) {
 									
 	int maxNumWritePulse = MAX(cell.maxNumLevelLTP, cell.maxNumLevelLTD);
@@ -1034,6 +1316,7 @@ void GetWriteUpdateEstimation(SubArray *subArray, Technology& tech, MemCell& cel
 	int numSelectedRowReset = 0;						// used to calculate activityRowWrite
 	int numSelectedColSet = 0;							// used to calculate activityColWrite
 	int numSelectedColReset = 0;						// used to calculate activityColWrite
+	vector<WriteTransition> transition((long)newMemory.numLevel*oldMemory.numLevel);	// 以(新等级, 旧等级)为下标
 	for (int i=0; i<newMemory.size(); i++) {    		// update weight row-by-row
 		int numSet = 0;          						// num of columns need to be set
 		int numReset = 0;        						// num of columns need to be reset
@@ -1041,47 +1324,28 @@ void GetWriteUpdateEstimation(SubArray *subArray, Technology& tech, MemCell& cel
 		int numResetWritePulse = 0;						// num of reset pulse of each row
 		bool rowSelected = false;
 		
-		for (int j=0; j<newMemory[0].size(); j++) {   	// sweep column for a row
-			if (param->memcelltype != 1) { // eNVM
-				if (abs(newMemory[i][j]-oldMemory[i][j]) >= minDeltaConductance) {
-					rowSelected = true;
-					if (newMemory[i][j] > oldMemory[i][j]) {  // LTP
-						numSet += 1;
-						int thisPulse = (int)ceil(abs(newMemory[i][j]-oldMemory[i][j])/minDeltaConductance);
-						numSetWritePulse = MAX( numSetWritePulse, thisPulse );
-						// energy in each cell
-						*writeDynamicEnergyArray += cell.writeVoltage * cell.writeVoltage / (abs(1/newMemory[i][j] + 1/oldMemory[i][j])/2) * cell.writePulseWidth * thisPulse *((cell.memCellType == Type::FeFET)==true? 0:1);
-					} else {   // LTD
-						numReset += 1;
-						int thisPulse = (int)ceil(abs(newMemory[i][j]-oldMemory[i][j])/minDeltaConductance);
-						numResetWritePulse = MAX( numResetWritePulse, thisPulse );
-						// energy in each cell
-						*writeDynamicEnergyArray += cell.writeVoltage * cell.writeVoltage / (abs(1/newMemory[i][j] + 1/oldMemory[i][j])/2) * cell.writePulseWidth * thisPulse *((cell.memCellType == Type::FeFET)==true? 0:1);
-					}
-					if (cell.memCellType == Type::FeFET) { //FeFET
-						double newPr = (newMemory[i][j]/minDeltaConductance-maxNumWritePulse/2)*(param->polarization*2/maxNumWritePulse);
-						double oldPr = (oldMemory[i][j]/minDeltaConductance-maxNumWritePulse/2)*(param->polarization*2/maxNumWritePulse);
-						// assume pr and conductance are linear mapped
-						double deltaPr = abs(newPr+(param->polarization))+abs(oldPr+(param->polarization));  // uC/cm^2 (assume erase before program)
-						*writeDynamicEnergyArray += deltaPr*0.01*cell.writeVoltage*(2*tech.featureSize*tech.featureSize);
-					}
-				} else { // no update
-					numSet += 0;
-					numReset += 0;
-				}
-			} else {  // SRAM
-				if (newMemory[i][j] != oldMemory[i][j]) {
-					rowSelected = true;
-					if (newMemory[i][j] > oldMemory[i][j]) {  // LTP
-						numSet += 1;
-						numSetWritePulse = 1;
-					} else {   // LTD
-						numReset += 1;
-						numResetWritePulse = 1;
-					}
-				} else { // no update
-					numSet += 0;
-					numReset += 0;
+		for (int j=0; j<newMemory.numCol; j++) {   	// sweep column for a row
+			WriteTransition &thisCell = transition[newMemory[i][j]*oldMemory.numLevel + oldMemory[i][j]];
+			if (!thisCell.evaluated) {
+				thisCell = GetWriteTransition<memCellType>(tech, cell, newMemory.conductance[newMemory[i][j]], oldMemory.conductance[oldMemory[i][j]], 
+															minDeltaConductance, maxNumWritePulse);
+			}
+			if (thisCell.state == 0) {	// no update
+				continue;
+			}
+			rowSelected = true;
+			if (thisCell.state > 0) {  // LTP
+				numSet += 1;
+				numSetWritePulse = MAX( numSetWritePulse, thisCell.numPulse );
+			} else {   // LTD
+				numReset += 1;
+				numResetWritePulse = MAX( numResetWritePulse, thisCell.numPulse );
+			}
+			if (memCellType != Type::SRAM) { // eNVM
+				// energy in each cell
+				*writeDynamicEnergyArray += thisCell.energy;
+				if (memCellType == Type::FeFET) { //FeFET
+					*writeDynamicEnergyArray += thisCell.energyPolarization;
 				}
 			}
 		}
@@ -1105,13 +1369,13 @@ void GetWriteUpdateEstimation(SubArray *subArray, Technology& tech, MemCell& cel
 		
 	*totalNumWritePulse = totalNumResetWritePulse + totalNumSetWritePulse;
 	*numWritePulseAVG = (*totalNumWritePulse)/(MAX(1, (numSelectedRowSet+numSelectedRowReset)/2.0));
-	*activityColWrite = ((numSelectedColSet+numSelectedColReset)/2.0)/newMemory[0].size();
+	*activityColWrite = ((numSelectedColSet+numSelectedColReset)/2.0)/newMemory.numCol;
 	*activityRowWrite = ((numSelectedRowSet+numSelectedRowReset)/2.0)/newMemory.size();	
 	
 	// calculate WL BL and SL energy
-	if (cell.memCellType == Type::RRAM || cell.memCellType == Type::FeFET) {
+	if (memCellType == Type::RRAM || memCellType == Type::FeFET) {
 		if (cell.accessType == CMOS_access) {
-			if (cell.memCellType == Type::FeFET) {
+			if (memCellType == Type::FeFET) {
 				// SET
 				*writeDynamicEnergyArray += subArray->capRow2 * tech.vdd * tech.vdd * totalNumSetWritePulse;	
 				*writeDynamicEnergyArray += (subArray->capCol + param->gateCapFeFET * numSelectedRowSet) * cell.writeVoltage * cell.writeVoltage * numSelectedColSet * totalNumSetWritePulse;
@@ -1121,28 +1385,28 @@ void GetWriteUpdateEstimation(SubArray *subArray, Technology& tech, MemCell& cel
 			} else {
 				// SET
 				*writeDynamicEnergyArray += subArray->capRow2 * tech.vdd * tech.vdd * totalNumSetWritePulse;																                // Selected WL
-				*writeDynamicEnergyArray += subArray->capCol * cell.writeVoltage * cell.writeVoltage * (newMemory[0].size()>=numSelectedColSet? (newMemory[0].size()-numSelectedColSet):(newMemory[0].size())) * totalNumSetWritePulse;	                    // Unselected SLs
+				*writeDynamicEnergyArray += subArray->capCol * cell.writeVoltage * cell.writeVoltage * (newMemory.numCol>=numSelectedColSet? (newMemory.numCol-numSelectedColSet):(newMemory.numCol)) * totalNumSetWritePulse;	                    // Unselected SLs
 				*writeDynamicEnergyArray += subArray->capRow1 * cell.writeVoltage * cell.writeVoltage * numSelectedColSet * totalNumSetWritePulse;											// Selected BL
 				// RESET
 				*writeDynamicEnergyArray += subArray->capRow2 * tech.vdd * tech.vdd * totalNumResetWritePulse;																				// Selected WL
 				*writeDynamicEnergyArray += subArray->capCol * cell.writeVoltage * cell.writeVoltage * numSelectedColReset * totalNumResetWritePulse;										// Selected SLs
-				*writeDynamicEnergyArray += subArray->capRow1 * cell.writeVoltage * cell.writeVoltage * (newMemory[0].size()>=numSelectedColReset? (newMemory[0].size()-numSelectedColReset):(newMemory[0].size())) * totalNumResetWritePulse;				// Unselected BL
+				*writeDynamicEnergyArray += subArray->capRow1 * cell.writeVoltage * cell.writeVoltage * (newMemory.numCol>=numSelectedColReset? (newMemory.numCol-numSelectedColReset):(newMemory.numCol)) * totalNumResetWritePulse;				// Unselected BL
 			}
 		} else {
 			// SET
 			*writeDynamicEnergyArray += subArray->capRow1 * cell.writeVoltage * cell.writeVoltage * totalNumSetWritePulse;   																// Selected WL
 			*writeDynamicEnergyArray += subArray->capRow1 * cell.writeVoltage/2 * cell.writeVoltage/2 * (newMemory.size()>=numSelectedRowSet? (newMemory.size()-numSelectedRowSet):(newMemory.size())) * (*numWritePulseAVG);  						// Unselected WLs
-			*writeDynamicEnergyArray += subArray->capCol * cell.writeVoltage/2 * cell.writeVoltage/2 * (newMemory[0].size()>=numSelectedColSet? (newMemory[0].size()-numSelectedColSet):(newMemory[0].size())) * totalNumSetWritePulse; 					// Unselected BLs
+			*writeDynamicEnergyArray += subArray->capCol * cell.writeVoltage/2 * cell.writeVoltage/2 * (newMemory.numCol>=numSelectedColSet? (newMemory.numCol-numSelectedColSet):(newMemory.numCol)) * totalNumSetWritePulse; 					// Unselected BLs
 			*writeDynamicEnergyArray += cell.writeVoltage/2 * cell.writeVoltage/2 * (1/cell.resMemCellOnAtHalfVw + 1/cell.resMemCellOffAtHalfVw) / 2 
-										* cell.writePulseWidth * (newMemory[0].size()>=numSelectedColSet? (newMemory[0].size()-numSelectedColSet):(newMemory[0].size())) * totalNumSetWritePulse;    										                // Half-selected (unselected) cells on the selected row
+										* cell.writePulseWidth * (newMemory.numCol>=numSelectedColSet? (newMemory.numCol-numSelectedColSet):(newMemory.numCol)) * totalNumSetWritePulse;    										                // Half-selected (unselected) cells on the selected row
 			*writeDynamicEnergyArray += cell.writeVoltage/2 * cell.writeVoltage/2 * (1/cell.resMemCellOnAtHalfVw + 1/cell.resMemCellOffAtHalfVw) / 2 
 										* cell.writePulseWidth * (newMemory.size()>=numSelectedRowSet? (newMemory.size()-numSelectedRowSet):(newMemory.size())) * totalNumSetWritePulse;  											                // Half-selected (unselected) cells on the selected columns
 			// RESET
 			*writeDynamicEnergyArray += subArray->capRow1 * cell.writeVoltage/2 * cell.writeVoltage/2 * (newMemory.size()>=numSelectedRowReset? (newMemory.size()-numSelectedRowReset):(newMemory.size())) * (*numWritePulseAVG);  					    // Unselected WLs
 			*writeDynamicEnergyArray += subArray->capCol * cell.writeVoltage * cell.writeVoltage * totalNumResetWritePulse; 																	// Selected BLs
-			*writeDynamicEnergyArray += subArray->capCol * cell.writeVoltage/2 * cell.writeVoltage/2 * (newMemory[0].size()>=numSelectedColReset? (newMemory[0].size()-numSelectedColReset):(newMemory[0].size())) * totalNumResetWritePulse; 					// Unselected BLs
+			*writeDynamicEnergyArray += subArray->capCol * cell.writeVoltage/2 * cell.writeVoltage/2 * (newMemory.numCol>=numSelectedColReset? (newMemory.numCol-numSelectedColReset):(newMemory.numCol)) * totalNumResetWritePulse; 					// Unselected BLs
 			*writeDynamicEnergyArray += cell.writeVoltage/2 * cell.writeVoltage/2 * (1/cell.resMemCellOnAtHalfVw + 1/cell.resMemCellOffAtHalfVw) / 2 
-										* cell.writePulseWidth * (newMemory[0].size()>=numSelectedColReset? (newMemory[0].size()-numSelectedColReset):(newMemory[0].size())) * totalNumResetWritePulse;    									                    // Half-selected (unselected) cells on the selected row
+										* cell.writePulseWidth * (newMemory.numCol>=numSelectedColReset? (newMemory.numCol-numSelectedColReset):(newMemory.numCol)) * totalNumResetWritePulse;    									                    // Half-selected (unselected) cells on the selected row
 			*writeDynamicEnergyArray += cell.writeVoltage/2 * cell.writeVoltage/2 * (1/cell.resMemCellOnAtHalfVw + 1/cell.resMemCellOffAtHalfVw) / 2 
 										* cell.writePulseWidth * (newMemory.size()>=numSelectedRowReset? (newMemory.size()-numSelectedRowReset):(newMemory.size())) * totalNumResetWritePulse;   										                // Half-selected (unselected) cells on the selected columns			
 		}
@@ -1151,6 +1415,46 @@ void GetWriteUpdateEstimation(SubArray *subArray, Technology& tech, MemCell& cel
 	}
 }
 
+ColumnResistanceFunction SelectColumnResistance(MemCell& cell, bool parallelRead) {
+	bool cmosAccess = (cell.accessType == CMOS_access);
+	switch (cell.memCellType) {
+		case Type::RRAM:
+			if (cmosAccess) {
+				return parallelRead? GetColumnResistance<Type::RRAM, true, true> : GetColumnResistance<Type::RRAM, true, false>;
+			}
+			return parallelRead? GetColumnResistance<Type::RRAM, false, true> : GetColumnResistance<Type::RRAM, false, false>;
+		case Type::FeFET:
+			return parallelRead? GetColumnResistance<Type::FeFET, false, true> : GetColumnResistance<Type::FeFET, false, false>;
+		default:
+			return GetColumnResistance<Type::SRAM, false, false>;
+	}
+}
+
+
+RowResistanceFunction SelectRowResistance(MemCell& cell, bool parallelRead) {
+	bool cmosAccess = (cell.accessType == CMOS_access);
+	switch (cell.memCellType) {
+		case Type::RRAM:
+			if (cmosAccess) {
+				return parallelRead? GetRowResistance<Type::RRAM, true, true> : GetRowResistance<Type::RRAM, true, false>;
+			}
+			return parallelRead? GetRowResistance<Type::RRAM, false, true> : GetRowResistance<Type::RRAM, false, false>;
+		case Type::FeFET:
+			return parallelRead? GetRowResistance<Type::FeFET, false, true> : GetRowResistance<Type::FeFET, false, false>;
+		default:
+			return GetRowResistance<Type::SRAM, false, false>;
+	}
+}
+
+
+WriteUpdateEstimationFunction SelectWriteUpdateEstimation(MemCell& cell) {
+	switch (cell.memCellType) {
+		case Type::RRAM:	return GetWriteUpdateEstimation<Type::RRAM>;
+		case Type::FeFET:	return GetWriteUpdateEstimation<Type::FeFET>;
+		default:			return GetWriteUpdateEstimation<Type::SRAM>;
+	}
+}
+
 void GetArrayEstimation(SubArray *subArray, Technology &tech, MemCell &cell, const int weightMatrixRow, const int weightMatrixCol,int *mulNor, int *addNor, double *writeDynamicEnergyArray)  //需要根据矩阵的大小以及对应的subarray计算所需的mulNor次数、addNor次数以及阵列写能耗
 {
 
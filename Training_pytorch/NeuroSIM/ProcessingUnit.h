@@ -38,16 +38,78 @@
 
 #ifndef PROCESSINGUNIT_H_
 #define PROCESSINGUNIT_H_
+#include <map>
+#include <unordered_map>
 #include "InputParameter.h"
 #include "Technology.h"
 #include "MemCell.h"
 #include "SubArray.h"
+#include "Matrix.h"
+#include "BitMatrix.h"
+#include "WeightOperand.h"
+#include "AdderTree.h"
+#include "Bus.h"
+#include "DFF.h"
+
+class SimulationContext;
+
+// DCpe模式下subArray评估结果的缓存，同一权重矩阵中相同形状、相同输入激活率的subArray只评估一次
+// （WeightOperand的权重是随机生成的，各subArray的权重统计特征相同，因此不作为key）
+struct SubArrayEstimationKey {
+	int numRow, numCol;
+	double activityRowRead;
+	unsigned int weightSeed;				// 所属的权重矩阵（种子和尺寸），缓存的结果来自该矩阵中按(i, j)顺序第一个具有该key的subArray，
+	int weightMatrixRow, weightMatrixCol;	// 因此与token的评估顺序（以及线程）无关
+	bool operator<(const SubArrayEstimationKey &other) const {
+		if (numRow != other.numRow) return numRow < other.numRow;
+		if (numCol != other.numCol) return numCol < other.numCol;
+		if (activityRowRead != other.activityRowRead) return activityRowRead < other.activityRowRead;
+		if (weightSeed != other.weightSeed) return weightSeed < other.weightSeed;
+		if (weightMatrixRow != other.weightMatrixRow) return weightMatrixRow < other.weightMatrixRow;
+		return weightMatrixCol < other.weightMatrixCol;
+	}
+};
+
+// 同一subArray内按输入向量去重的评估结果
+struct InputVectorHash {
+	size_t operator()(const vector<uint64_t> &input) const;
+};
+typedef unordered_map<vector<uint64_t>, int, InputVectorHash> InputVectorMemo;	// 输入向量 -> 在InputVectorBatch::vectors中的位置
+
+// 一个subArray的全部输入向量：去重后一次性批量计算所有不同输入向量的列电阻
+struct InputVectorBatch {
+	vector<vector<uint64_t> > vectors;			// 不同的输入向量（按位打包）
+	vector<double> activityRowRead;				// 与vectors一一对应
+	vector<int> index;							// 第k个输入向量在vectors中的位置
+	vector<vector<double> > columnResistance;	// 与vectors一一对应
+	vector<SubArrayEstimation> estimation;
+	vector<bool> evaluated;
+	int numVisited;								// 已经遇到过的不同输入向量个数（vectors按首次出现的顺序排列）
+};
+
+// subArray核函数按(存储单元类型, access类型, 读模式)特化，整个运行期间只选择一次
+typedef vector<vector<double> > (*ColumnResistanceFunction)(const vector<vector<uint64_t> > &inputs, const MatrixView &weightColumn, MemCell& cell, double resCellAccess);
+typedef vector<double> (*RowResistanceFunction)(const MatrixView &weight, MemCell& cell, double resCellAccess);
+typedef void (*WriteUpdateEstimationFunction)(SubArray *subArray, Technology& tech, MemCell& cell, const MatrixView &newMemory, const MatrixView &oldMemory,
+								double *activityColWrite, double *activityRowWrite, int *numWritePulseAVG, int *totalNumWritePulse, double *writeDynamicEnergyArray);
+
+// PE中除subArray以外的模块实例，由SimulationContext持有
+struct ProcessingUnitComponents {
+	AdderTree *adderTreeNM, *adderTreeCM;
+	Bus *busInputNM, *busOutputNM, *busInputCM, *busOutputCM;
+	DFF *bufferInputNM, *bufferOutputNM, *bufferInputCM, *bufferOutputCM;
+	map<SubArrayEstimationKey, SubArrayEstimation> *subArrayEstimationCache;
+	ColumnResistanceFunction getColumnResistance;
+	RowResistanceFunction getRowResistance;
+	WriteUpdateEstimationFunction getWriteUpdateEstimation;
+};
  
 /*** Functions ***/
 void ProcessingUnitInitialize(SubArray *& subArray, InputParameter& inputParameter, Technology& tech, MemCell& cell, int _numSubArrayRowNM, int _numSubArrayColNM, int _numSubArrayRowCM, int _numSubArrayColCM, bool DCpe);
 vector<double> ProcessingUnitCalculateArea(SubArray *subArray, int numSubArrayRow, int numSubArrayCol, bool NMpe, double *height, double *width, double *bufferArea);	//面积暂时不计算
-double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech, MemCell& cell, int layerNumber, bool NMpe, bool DCpe,int DCpeMode, //DCpeMode 分为写入模式、缓存模式以及半写入模式
-										const vector<vector<double> > &newMemory, const vector<vector<double> > &oldMemory, const vector<vector<double> > &inputVector, 
+double ProcessingUnitCalculatePerformance(SubArray *subArray, SimulationContext& context, int layerNumber, bool NMpe, bool DCpe,int DCpeMode, //DCpeMode 分为写入模式、缓存模式以及半写入模式
+										const MatrixView &newMemory, const MatrixView &oldMemory, const BitMatrixView &inputVector, 
+										const WeightOperand *weightOperand, //数字计算模式下按需生成权重，此时newMemory为空
 										int arrayDupRow, int arrayDupCol, int numSubArrayRow, int numSubArrayCol, int weightMatrixRow, int weightMatrixCol, 
 										int numInVector, double *readLatency, double *readDynamicEnergy, double *leakage, 
 										double *readLatencyAG, double *readDynamicEnergyAG, double *writeLatencyWU, double *writeDynamicEnergyWU,
@@ -56,13 +118,24 @@ double ProcessingUnitCalculatePerformance(SubArray *subArray, Technology& tech,
 										double *coreEnergyAccum, double *coreEnergyOther, double *readLatencyPeakFW, double *readDynamicEnergyPeakFW,
 										double *readLatencyPeakAG, double *readDynamicEnergyPeakAG, double *readLatencyPeakWU, double *readDynamicEnergyPeakWU);
 
-vector<vector<double> > CopySubArray(const vector<vector<double> > &orginal, int positionRow, int positionCol, int numRow, int numCol);
-vector<vector<double> > CopySubInput(const vector<vector<double> > &orginal, int positionRow, int numInputVector, int numRow);
-vector<double> GetInputVector(const vector<vector<double> > &input, int numInput, double *activityRowRead);
-vector<double> GetColumnResistance(const vector<double> &input, const vector<vector<double> > &weight, MemCell& cell, bool parallelRead, double resCellAccess);
-vector<double> GetRowResistance(const vector<double> &input, const vector<vector<double> > &weight, MemCell& cell, bool parallelRead, double resCellAccess);
-void GetWriteUpdateEstimation(SubArray *subArray, Technology& tech, MemCell& cell, const vector<vector<double> > &newMemory, const vector<vector<double> > &oldMemory, double *activityColWrite, double *activityRowWrite,
-								int *numWritePulseAVG, int *totalNumWritePulse, double *writeDynamicEnergyArray);
+void ProcessingUnitGetInputVectorStats(long *numEvaluated, long *numReused);	// 模拟阵列读循环中实际评估/复用的输入向量数
+void ProcessingUnitResetInputVectorStats();
+
+ProcessingUnitComponents ProcessingUnitGetComponents();		// 当前线程的模块实例
+ProcessingUnitComponents ProcessingUnitCopyComponents(const ProcessingUnitComponents &original);
+void ProcessingUnitSetComponents(const ProcessingUnitComponents &components);	// 当前线程改为使用给定的模块实例
+void ProcessingUnitDeleteComponents(ProcessingUnitComponents &components);
+
+MatrixView CopySubArray(const MatrixView &orginal, int positionRow, int positionCol, int numRow, int numCol);
+Matrix CopySubArray(const WeightOperand &orginal, int positionRow, int positionCol, int numRow, int numCol);
+BitMatrixView CopySubInput(const BitMatrixView &orginal, int positionRow, int numInputVector, int numRow);
+SubArrayEstimation GetSubArrayEstimation(const SubArray *subArray);
+void GetInputVectorBatch(SubArray *subArray, MemCell& cell, const BitMatrixView &input, int numInVector, const MatrixView &subArrayMemoryColumn, InputVectorBatch &batch);
+const SubArrayEstimation& EvaluateInputVector(SubArray *subArray, MemCell& cell, const MatrixView &subArrayMemory, InputVectorBatch &batch, int k);
+void GetInputVector(const BitMatrixView &input, int numInput, vector<uint64_t> &bits, double *activityRowRead);	// 第numInput个输入向量按位写入bits
+ColumnResistanceFunction SelectColumnResistance(MemCell& cell, bool parallelRead);
+RowResistanceFunction SelectRowResistance(MemCell& cell, bool parallelRead);
+WriteUpdateEstimationFunction SelectWriteUpdateEstimation(MemCell& cell);
 void GetArrayEstimation(SubArray *subArray, Technology &tech, MemCell &cell, const int weightMatrixRow, const int weightMatrixCol,int *mulNor, int *addNor, double *writeDynamicEnergyArray);  //需要根据矩阵的大小以及对应的subarray计算所需的mulNor次数、addNor次数以及阵列写能耗
 
 #endif /* PROCESSINGUNIT_H_ */
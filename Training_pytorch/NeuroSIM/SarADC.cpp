@@ -46,7 +46,7 @@
 
 using namespace std;
 
-extern Param *param;
+extern thread_local Param *param;
 
 SarADC::SarADC(const InputParameter& _inputParameter, const Technology& _tech, const MemCell& _cell): inputParameter(_inputParameter), tech(_tech), cell(_cell), FunctionUnit() {
 	initialized = false;
@@ -127,6 +127,8 @@ void SarADC::CalculateLatency(double numRead) {
 	if (!initialized) {
 		cout << "[SarADC] Error: Require initialization first!" << endl;
 	} else {
+		lastCall.latencyCalculated = true;
+		lastCall.numReadLatency = numRead;
 		readLatency = 0;
 		readLatency += (log2(levelOutput)+1)*1e-9;
 		readLatency *= numRead;
@@ -137,99 +139,158 @@ void SarADC::CalculatePower(const vector<double> &columnResistance, double numRe
 	if (!initialized) {
 		cout << "[SarADC] Error: Require initialization first!" << endl;
 	} else {
+		lastCall.powerCalculated = true;
+		lastCall.numReadPower = numRead;
 		leakage = 0;
-		readDynamicEnergy = 0;
-		for (double i=0; i<columnResistance.size(); i++) {
-			double E_Col = 0;
-			E_Col = GetColumnPower(columnResistance[i]);
-			if (columnResistance[i] == columnResistance[i]) {
-				readDynamicEnergy += E_Col;
-			} else {
-				readDynamicEnergy += 0;
+		CalculatePowerBatch(columnResistance.empty()? NULL : &columnResistance[0], 1, columnResistance.size(), numRead, &readDynamicEnergy);
+	}
+}
+
+void SarADC::CalculatePowerBatch(const double *columnResistance, int numVector, int numColumn, double numRead, double *energy) {
+	if (!initialized) {
+		cout << "[SarADC] Error: Require initialization first!" << endl;
+	} else {
+		long numElement = (long)numVector*numColumn;
+		vector<double> columnEnergy(numElement);
+		if (numElement > 0) {
+			GetColumnPowerBatch(columnResistance, numElement, &columnEnergy[0]);
+		}
+		for (int v=0; v<numVector; v++) {
+			const double *res = columnResistance + (long)v*numColumn;
+			const double *E_Col = numElement > 0? &columnEnergy[(long)v*numColumn] : NULL;
+			double readEnergy = 0;
+			for (int j=0; j<numColumn; j++) {
+				readEnergy += (res[j] == res[j])? E_Col[j] : 0;	// NaN的列不参与
 			}
+			energy[v] = readEnergy*numRead;
 		}
-		readDynamicEnergy *= numRead;
-		
 	}
-} 
+}
+
+void SarADC::RecalculateBatch(const double *columnResistance, int numVector, int numColumn, double *latency, double *energy) {
+	if (lastCall.powerCalculated) {
+		CalculatePowerBatch(columnResistance, numVector, numColumn, lastCall.numReadPower, energy);
+	}
+	for (int v=0; v<numVector; v++) {
+		latency[v] = readLatency;	// 延迟与columnResistance无关
+		if (!lastCall.powerCalculated) {
+			energy[v] = readDynamicEnergy;
+		}
+	}
+}
 
 void SarADC::PrintProperty(const char* str) {
 	FunctionUnit::PrintProperty(str);
 }
 
 
+// 列功耗拟合：P = staticPower + coefficient*exp(exponent*log10(R))，各系数只与工艺和levelOutput有关
+void SarADC::GetColumnPowerFit(double *staticPower, double *coefficient, double *exponent) {
+	if (param->deviceroadmap == 1) {  // HP
+		if (param->technode == 130) {
+			*staticPower = (6.4806*log2(levelOutput)+49.047)*1e-6;
+			*coefficient = 0.207452;
+			*exponent = -2.367;
+		} else if (param->technode == 90) {
+			*staticPower = (4.3474*log2(levelOutput)+31.782)*1e-6;
+			*coefficient = 0.164900;
+			*exponent = -2.345;
+		} else if (param->technode == 65) {
+			*staticPower = (2.9503*log2(levelOutput)+22.047)*1e-6;
+			*coefficient = 0.128483;
+			*exponent = -2.321;
+		} else if (param->technode == 45) {
+			*staticPower = (2.1843*log2(levelOutput)+11.931)*1e-6;
+			*coefficient = 0.097754;
+			*exponent = -2.296;
+		} else if (param->technode == 32){  
+			*staticPower = (1.0157*log2(levelOutput)+7.6286)*1e-6;
+			*coefficient = 0.083709;
+			*exponent = -2.313;
+		} else if (param->technode == 22){   
+			*staticPower = (0.7213*log2(levelOutput)+3.3041)*1e-6;
+			*coefficient = 0.084273;
+			*exponent = -2.311;
+		} else if (param->technode == 14){   
+			*staticPower = (0.4710*log2(levelOutput)+1.9529)*1e-6;
+			*coefficient = 0.060584;
+			*exponent = -2.311;
+		} else if (param->technode == 10){   
+			*staticPower = (0.3076*log2(levelOutput)+1.1543)*1e-6;
+			*coefficient = 0.049418;
+			*exponent = -2.311;
+		} else {   // 7nm
+			*staticPower = (0.2008*log2(levelOutput)+0.6823)*1e-6;
+			*coefficient = 0.040310;
+			*exponent = -2.311;
+		}
+	} else {                         // LP
+		if (param->technode == 130) {
+			*staticPower = (8.4483*log2(levelOutput)+65.243)*1e-6;
+			*coefficient = 0.169380;
+			*exponent = -2.303;
+		} else if (param->technode == 90) {
+			*staticPower = (5.9869*log2(levelOutput)+37.462)*1e-6;
+			*coefficient = 0.144323;
+			*exponent = -2.303;
+		} else if (param->technode == 65) {
+			*staticPower = (3.7506*log2(levelOutput)+25.844)*1e-6;
+			*coefficient = 0.121272;
+			*exponent = -2.303;
+		} else if (param->technode == 45) {
+			*staticPower = (2.1691*log2(levelOutput)+16.693)*1e-6;
+			*coefficient = 0.100225;
+			*exponent = -2.303;
+		} else if (param->technode == 32){  
+			*staticPower = (1.1294*log2(levelOutput)+8.8998)*1e-6;
+			*coefficient = 0.079449;
+			*exponent = -2.297;
+		} else if (param->technode == 22){   
+			*staticPower = (0.538*log2(levelOutput)+4.3753)*1e-6;
+			*coefficient = 0.072341;
+			*exponent = -2.303;
+		} else if (param->technode == 14){   
+			*staticPower = (0.3132*log2(levelOutput)+2.5681)*1e-6;
+			*coefficient = 0.061085;
+			*exponent = -2.303;
+		} else if (param->technode == 10){   
+			*staticPower = (0.1823*log2(levelOutput)+1.5073)*1e-6;
+			*coefficient = 0.051580;
+			*exponent = -2.303;
+		} else {   // 7nm
+			*staticPower = (0.1061*log2(levelOutput)+0.8847)*1e-6;
+			*coefficient = 0.043555;
+			*exponent = -2.303;
+		}
+	}
+}
+
 double SarADC::GetColumnPower(double columnRes) {
-	double Column_Power = 0;
 	double Column_Energy = 0;
+	GetColumnPowerBatch(&columnRes, 1, &Column_Energy);
+	return Column_Energy;
+}
+
+// 与GetColumnPower相同，输出的是每次转换的能耗
+void SarADC::GetColumnPowerBatch(const double *columnRes, long numColumn, double *columnEnergy) {
+	double staticPower, coefficient, exponent;
+	GetColumnPowerFit(&staticPower, &coefficient, &exponent);
 	// in Cadence simulation, we fix Vread to 0.5V, with user-defined Vread (different from 0.5V)
 	// we should modify the equivalent columnRes
-	columnRes *= 0.5/param->readVoltage;
-	if ((double) 1/columnRes == 0) { 
-		Column_Power = 1e-6;
-	} else if (columnRes == 0) {
-		Column_Power = 0;
-	} else {
-		if (param->deviceroadmap == 1) {  // HP
-			if (param->technode == 130) {
-				Column_Power = (6.4806*log2(levelOutput)+49.047)*1e-6;
-				Column_Power += 0.207452*exp(-2.367*log10(columnRes));
-			} else if (param->technode == 90) {
-				Column_Power = (4.3474*log2(levelOutput)+31.782)*1e-6;
-				Column_Power += 0.164900*exp(-2.345*log10(columnRes));
-			} else if (param->technode == 65) {
-				Column_Power = (2.9503*log2(levelOutput)+22.047)*1e-6;
-				Column_Power += 0.128483*exp(-2.321*log10(columnRes));
-			} else if (param->technode == 45) {
-				Column_Power = (2.1843*log2(levelOutput)+11.931)*1e-6;
-				Column_Power += 0.097754*exp(-2.296*log10(columnRes));
-			} else if (param->technode == 32){  
-				Column_Power = (1.0157*log2(levelOutput)+7.6286)*1e-6;
-				Column_Power += 0.083709*exp(-2.313*log10(columnRes));
-			} else if (param->technode == 22){   
-				Column_Power = (0.7213*log2(levelOutput)+3.3041)*1e-6;
-				Column_Power += 0.084273*exp(-2.311*log10(columnRes));
-			} else if (param->technode == 14){   
-				Column_Power = (0.4710*log2(levelOutput)+1.9529)*1e-6;
-				Column_Power += 0.060584*exp(-2.311*log10(columnRes));
-			} else if (param->technode == 10){   
-				Column_Power = (0.3076*log2(levelOutput)+1.1543)*1e-6;
-				Column_Power += 0.049418*exp(-2.311*log10(columnRes));
-			} else {   // 7nm
-				Column_Power = (0.2008*log2(levelOutput)+0.6823)*1e-6;
-				Column_Power += 0.040310*exp(-2.311*log10(columnRes));
-			}
-		} else {                         // LP
-			if (param->technode == 130) {
-				Column_Power = (8.4483*log2(levelOutput)+65.243)*1e-6;
-				Column_Power += 0.169380*exp(-2.303*log10(columnRes));
-			} else if (param->technode == 90) {
-				Column_Power = (5.9869*log2(levelOutput)+37.462)*1e-6;
-				Column_Power += 0.144323*exp(-2.303*log10(columnRes));
-			} else if (param->technode == 65) {
-				Column_Power = (3.7506*log2(levelOutput)+25.844)*1e-6;
-				Column_Power += 0.121272*exp(-2.303*log10(columnRes));
-			} else if (param->technode == 45) {
-				Column_Power = (2.1691*log2(levelOutput)+16.693)*1e-6;
-				Column_Power += 0.100225*exp(-2.303*log10(columnRes));
-			} else if (param->technode == 32){  
-				Column_Power = (1.1294*log2(levelOutput)+8.8998)*1e-6;
-				Column_Power += 0.079449*exp(-2.297*log10(columnRes));
-			} else if (param->technode == 22){   
-				Column_Power = (0.538*log2(levelOutput)+4.3753)*1e-6;
-				Column_Power += 0.072341*exp(-2.303*log10(columnRes));
-			} else if (param->technode == 14){   
-				Column_Power = (0.3132*log2(levelOutput)+2.5681)*1e-6;
-				Column_Power += 0.061085*exp(-2.303*log10(columnRes));
-			} else if (param->technode == 10){   
-				Column_Power = (0.1823*log2(levelOutput)+1.5073)*1e-6;
-				Column_Power += 0.051580*exp(-2.303*log10(columnRes));
-			} else {   // 7nm
-				Column_Power = (0.1061*log2(levelOutput)+0.8847)*1e-6;
-				Column_Power += 0.043555*exp(-2.303*log10(columnRes));
-			}
+	double scale = 0.5/param->readVoltage;
+	double temperatureFactor = 1+1.3e-3*(param->temp-300);
+	double numCycle = log2(levelOutput)+1;
+	for (long j=0; j<numColumn; j++) {
+		double res = columnRes[j]*scale;
+		double Column_Power;
+		if ((double) 1/res == 0) { 
+			Column_Power = 1e-6;
+		} else if (res == 0) {
+			Column_Power = 0;
+		} else {
+			Column_Power = staticPower + coefficient*exp(exponent*log10(res));
 		}
+		Column_Power *= temperatureFactor;
+		columnEnergy[j] = Column_Power * numCycle*1e-9;
 	}
-	Column_Power *= (1+1.3e-3*(param->temp-300));
-	Column_Energy = Column_Power * (log2(levelOutput)+1)*1e-9;
-	return Column_Energy;
 }
@@ -63,7 +63,12 @@ public:
 	void CalculateArea(double heightArray, double widthArray, AreaModify _option);
 	void CalculateLatency(double numRead);
 	void CalculatePower(const vector<double> &columnResistance, double numRead);
+	// 批量版本：columnResistance为numVector个输入向量的列电阻，按向量连续存储（每个向量numColumn列），结果按向量输出
+	void CalculatePowerBatch(const double *columnResistance, int numVector, int numColumn, double numRead, double *energy);
+	void RecalculateBatch(const double *columnResistance, int numVector, int numColumn, double *latency, double *energy);	// 按lastCall的参数重新计算，未调用过的部分输出当前结果
 	double GetColumnPower(double columnRes);
+	void GetColumnPowerBatch(const double *columnRes, long numColumn, double *columnEnergy);
+	void GetColumnPowerFit(double *staticPower, double *coefficient, double *exponent);
 
 	/* Properties */
 	bool initialized;		/* Initialization flag */
@@ -76,6 +81,7 @@ public:
 	double clkFreq, areaUnit;
 	int numReadCellPerOperationNeuro;
 	vector<double> Rref;
+	ReadoutCall lastCall;
 
 };
 
@@ -0,0 +1,375 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "NeuroSim.h"
+#include "Server.h"
+
+using namespace std;
+
+static const struct {
+	const char *name;
+	double NeuroSimPerformance::*field;
+} performanceFields[] = {
+	{"readLatency", &NeuroSimPerformance::readLatency}, {"readDynamicEnergy", &NeuroSimPerformance::readDynamicEnergy},
+	{"readLatencyAG", &NeuroSimPerformance::readLatencyAG}, {"readDynamicEnergyAG", &NeuroSimPerformance::readDynamicEnergyAG},
+	{"readLatencyWG", &NeuroSimPerformance::readLatencyWG}, {"readDynamicEnergyWG", &NeuroSimPerformance::readDynamicEnergyWG},
+	{"writeLatencyWU", &NeuroSimPerformance::writeLatencyWU}, {"writeDynamicEnergyWU", &NeuroSimPerformance::writeDynamicEnergyWU},
+	{"readLatencyPeakFW", &NeuroSimPerformance::readLatencyPeakFW}, {"readDynamicEnergyPeakFW", &NeuroSimPerformance::readDynamicEnergyPeakFW},
+	{"readLatencyPeakAG", &NeuroSimPerformance::readLatencyPeakAG}, {"readDynamicEnergyPeakAG", &NeuroSimPerformance::readDynamicEnergyPeakAG},
+	{"readLatencyPeakWG", &NeuroSimPerformance::readLatencyPeakWG}, {"readDynamicEnergyPeakWG", &NeuroSimPerformance::readDynamicEnergyPeakWG},
+	{"writeLatencyPeakWU", &NeuroSimPerformance::writeLatencyPeakWU}, {"writeDynamicEnergyPeakWU", &NeuroSimPerformance::writeDynamicEnergyPeakWU},
+	{"leakagePower", &NeuroSimPerformance::leakagePower}, {"leakageEnergy", &NeuroSimPerformance::leakageEnergy},
+	{"bufferLatency", &NeuroSimPerformance::bufferLatency}, {"bufferDynamicEnergy", &NeuroSimPerformance::bufferDynamicEnergy},
+	{"icLatency", &NeuroSimPerformance::icLatency}, {"icDynamicEnergy", &NeuroSimPerformance::icDynamicEnergy},
+	{"coreLatencyADC", &NeuroSimPerformance::coreLatencyADC}, {"coreLatencyAccum", &NeuroSimPerformance::coreLatencyAccum},
+	{"coreLatencyOther", &NeuroSimPerformance::coreLatencyOther}, {"coreEnergyADC", &NeuroSimPerformance::coreEnergyADC},
+	{"coreEnergyAccum", &NeuroSimPerformance::coreEnergyAccum}, {"coreEnergyOther", &NeuroSimPerformance::coreEnergyOther},
+	{"dramLatency", &NeuroSimPerformance::dramLatency}, {"dramDynamicEnergy", &NeuroSimPerformance::dramDynamicEnergy}
+};
+static const int numPerformanceFields = sizeof(performanceFields)/sizeof(performanceFields[0]);
+
+// 逐行读写一个连接（或标准输入、标准输出）
+class Connection {
+public:
+	Connection(int _inputFd, int _outputFd): inputFd(_inputFd), outputFd(_outputFd) {}
+	bool ReadLine(string *line);
+	bool Write(const string &line);	// 对方已关闭时返回false
+	
+private:
+	int inputFd, outputFd;
+	string buffer;
+};
+
+bool Connection::ReadLine(string *line) {
+	while (true) {
+		size_t end = buffer.find('\n');
+		if (end != string::npos) {
+			*line = buffer.substr(0, end);
+			buffer.erase(0, end+1);
+			if (!line->empty() && (*line)[line->size()-1] == '\r') {
+				line->erase(line->size()-1);
+			}
+			return true;
+		}
+		char data[4096];
+		ssize_t n = read(inputFd, data, sizeof(data));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			*line = buffer;		// 最后一行可以没有换行符
+			buffer.clear();
+			return !line->empty();
+		}
+		buffer.append(data, n);
+	}
+}
+
+bool Connection::Write(const string &line) {
+	string data = line + "\n";
+	size_t written = 0;
+	while (written < data.size()) {
+		ssize_t n = write(outputFd, data.data() + written, data.size() - written);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		written += n;
+	}
+	return true;
+}
+
+// 简单的JSON对象，按添加的顺序输出各成员
+class JsonLine {
+public:
+	JsonLine &Add(const string &name, const string &value) { Key(name); Escape(value); return *this; }
+	JsonLine &Add(const string &name, const char *value) { return Add(name, string(value)); }
+	JsonLine &Add(const string &name, double value);
+	JsonLine &Add(const string &name, int value) { Key(name); out << value; return *this; }
+	JsonLine &Add(const string &name, bool value) { Key(name); out << (value? "true" : "false"); return *this; }
+	JsonLine &Add(const NeuroSimPerformance &performance);
+	string str() const { return "{" + out.str() + "}"; }
+	
+private:
+	void Key(const string &name) { if (!out.str().empty()) out << ", "; Escape(name); out << ": "; }
+	void Escape(const string &value);
+	ostringstream out;
+};
+
+JsonLine &JsonLine::Add(const string &name, double value) {
+	Key(name);
+	if (std::isfinite(value)) {
+		char text[32];
+		snprintf(text, sizeof(text), "%.17g", value);
+		out << text;
+	} else {
+		out << "null";	// JSON中没有inf和nan
+	}
+	return *this;
+}
+
+JsonLine &JsonLine::Add(const NeuroSimPerformance &performance) {
+	for (int i=0; i<numPerformanceFields; i++) {
+		Add(performanceFields[i].name, performance.*performanceFields[i].field);
+	}
+	return *this;
+}
+
+void JsonLine::Escape(const string &value) {
+	out << '"';
+	for (int i=0; i<value.size(); i++) {
+		unsigned char c = value[i];
+		if (c == '"' || c == '\\') {
+			out << '\\' << c;
+		} else if (c < 0x20) {
+			char text[8];
+			snprintf(text, sizeof(text), "\\u%04x", c);
+			out << text;
+		} else {
+			out << c;
+		}
+	}
+	out << '"';
+}
+
+static JsonLine &AddChipPerformance(JsonLine &line, const NeuroSimChipPerformance &chip) {
+	return line.Add(chip.total).Add("numComputation", chip.numComputation).Add("energyEfficiency", chip.energyEfficiency).Add("throughputTOPS", chip.throughputTOPS).Add("throughputFPS", chip.throughputFPS)
+				.Add("peakEnergyEfficiency", chip.peakEnergyEfficiency).Add("peakThroughputTOPS", chip.peakThroughputTOPS).Add("peakThroughputFPS", chip.peakThroughputFPS);
+}
+
+static bool WriteError(Connection &connection, const string &job, const string &message) {
+	return connection.Write(JsonLine().Add("job", job).Add("error", message).str());
+}
+
+static bool FileReadable(const string &file) {
+	return ifstream(file.c_str()).good();
+}
+
+// 模拟计算：依次评估各层，每层完成后立即返回结果
+static bool RunLayersJob(NeuroSim *sim, const NeuroSimChipInfo &info, Connection &connection, const string &job, const vector<string> &args) {
+	if (info.digital) {
+		return WriteError(connection, job, "layers jobs need an analog chip (Param::digital == 0), use tokens");
+	}
+	if (args.size() != 4*info.numLayer) {
+		ostringstream message;
+		message << "expected 4 arguments (newWeight, oldWeight, input, activity) for each of the " << info.numLayer << " layers, got " << args.size();
+		return WriteError(connection, job, message.str());
+	}
+	for (int i=0; i<args.size(); i++) {
+		if (i%4 != 3 && !FileReadable(args[i])) {
+			return WriteError(connection, job, "the trace file " + args[i] + " cannot be opened");
+		}
+	}
+	
+	vector<NeuroSimPerformance> layers(info.numLayer);
+	for (int i=0; i<info.numLayer; i++) {
+		if (neurosim_evaluate_layer_files(sim, i, args[4*i].c_str(), args[4*i+1].c_str(), args[4*i+2].c_str(), atof(args[4*i+3].c_str()), &layers[i]) != 0) {
+			return WriteError(connection, job, neurosim_last_error());
+		}
+		if (!connection.Write(JsonLine().Add("job", job).Add("layer", i+1).Add(layers[i]).str())) {
+			return false;
+		}
+	}
+	NeuroSimChipPerformance chip;
+	neurosim_summarize(sim, &layers[0], &chip);
+	JsonLine line;
+	line.Add("job", job).Add("done", true);
+	return connection.Write(AddChipPerformance(line, chip).str());
+}
+
+// 数字计算：依次评估各个query，总结果为各query之和
+static bool RunTokensJob(NeuroSim *sim, const NeuroSimChipInfo &info, Connection &connection, const string &job, const vector<string> &args) {
+	if (!info.digital) {
+		return WriteError(connection, job, "tokens jobs need a digital chip (Param::digital != 0), use layers");
+	}
+	if (args.empty() || args.size()%2 != 0) {
+		return WriteError(connection, job, "expected pairs of input_len and output_len");
+	}
+	
+	NeuroSimChipPerformance total = NeuroSimChipPerformance();
+	for (int i=0; i<args.size(); i+=2) {
+		int inputLen = atoi(args[i].c_str());
+		int outputLen = atoi(args[i+1].c_str());
+		NeuroSimChipPerformance query;
+		if (neurosim_evaluate_tokens(sim, inputLen, outputLen, &query) != 0) {
+			return WriteError(connection, job, neurosim_last_error());
+		}
+		JsonLine line;
+		line.Add("job", job).Add("input_len", inputLen).Add("output_len", outputLen);
+		if (!connection.Write(AddChipPerformance(line, query).str())) {
+			return false;
+		}
+		for (int j=0; j<numPerformanceFields; j++) {
+			total.total.*performanceFields[j].field += query.total.*performanceFields[j].field;
+		}
+		total.numComputation += query.numComputation;
+	}
+	neurosim_update_efficiency(&total);
+	JsonLine line;
+	line.Add("job", job).Add("done", true);
+	return connection.Write(AddChipPerformance(line, total).str());
+}
+
+static JsonLine ChipInfoLine(const NeuroSimChipInfo &info) {
+	JsonLine line;
+	line.Add("numLayer", info.numLayer).Add("pipeline", info.pipeline != 0).Add("digital", info.digital)
+		.Add("numRowPerSynapse", info.numRowPerSynapse).Add("numColPerSynapse", info.numColPerSynapse).Add("numComputation", info.numComputation)
+		.Add("height", info.height).Add("width", info.width).Add("area", info.area).Add("areaArray", info.areaArray).Add("areaIC", info.areaIC)
+		.Add("areaADC", info.areaADC).Add("areaAccum", info.areaAccum).Add("areaOther", info.areaOther).Add("areaWG", info.areaWG);
+	return line;
+}
+
+// 处理一个连接上的所有任务，收到shutdown时返回true
+static bool Serve(NeuroSim *sim, const NeuroSimChipInfo &info, Connection &connection) {
+	string line;
+	while (connection.ReadLine(&line)) {
+		istringstream in(line);
+		string command, job, arg;
+		vector<string> args;
+		in >> command >> job;
+		while (in >> arg) {
+			args.push_back(arg);
+		}
+		
+		bool connected = true;
+		if (command.empty()) {
+			continue;
+		} else if (command == "layers") {
+			connected = RunLayersJob(sim, info, connection, job, args);
+		} else if (command == "tokens") {
+			connected = RunTokensJob(sim, info, connection, job, args);
+		} else if (command == "info") {
+			connected = connection.Write(ChipInfoLine(info).str());
+		} else if (command == "quit") {
+			return false;
+		} else if (command == "shutdown") {
+			return true;
+		} else {
+			connected = WriteError(connection, job, "unknown command " + command + ", expected layers, tokens, info, quit or shutdown");
+		}
+		if (!connected) {
+			return false;
+		}
+	}
+	return false;
+}
+
+int RunServer(int argc, char *argv[]) {
+	if (argc < 5) {
+		cerr << "Error: usage: " << argv[0] << " --serve NetWork.csv synapseBit numBitInput [socketPath]" << endl;
+		exit(1);
+	}
+	const char *socketPath = (argc > 5)? argv[5] : NULL;
+	
+	// 标准输出只用于返回结果，仿真过程中的其他输出（cout、printf）改到标准错误
+	cout.flush();
+	fflush(stdout);
+	int resultFd = dup(STDOUT_FILENO);
+	dup2(STDERR_FILENO, STDOUT_FILENO);
+	signal(SIGPIPE, SIG_IGN);	// 客户端提前断开时只结束该连接
+	
+	NeuroSim *sim = neurosim_create(argv[2], atoi(argv[3]), atoi(argv[4]));
+	if (sim == NULL) {
+		cerr << "Error: " << neurosim_last_error() << endl;
+		exit(1);
+	}
+	NeuroSimChipInfo info;
+	neurosim_get_chip_info(sim, &info);
+	
+	if (socketPath == NULL) {
+		Connection connection(STDIN_FILENO, resultFd);
+		Serve(sim, info, connection);
+	} else {
+		sockaddr_un address;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if (strlen(socketPath) >= sizeof(address.sun_path)) {
+			cerr << "Error: the socket path " << socketPath << " is too long" << endl;
+			exit(1);
+		}
+		strcpy(address.sun_path, socketPath);
+		struct stat status;
+		if (lstat(socketPath, &status) == 0 && S_ISSOCK(status.st_mode)) {
+			unlink(socketPath);		// 上一次运行留下的socket
+		}
+		int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listenFd < 0 || bind(listenFd, (sockaddr *)&address, sizeof(address)) != 0 || listen(listenFd, SOMAXCONN) != 0) {
+			cerr << "Error: cannot listen on " << socketPath << ": " << strerror(errno) << endl;
+			exit(1);
+		}
+		cerr << "NeuroSim server listening on " << socketPath << endl;
+		bool shutdown = false;
+		while (!shutdown) {
+			int fd = accept(listenFd, NULL, NULL);
+			if (fd < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				cerr << "Error: accept failed: " << strerror(errno) << endl;
+				break;
+			}
+			Connection connection(fd, fd);
+			shutdown = Serve(sim, info, connection);
+			close(fd);
+		}
+		close(listenFd);
+		unlink(socketPath);
+	}
+	
+	neurosim_destroy(sim);
+	close(resultFd);
+	return 0;
+}
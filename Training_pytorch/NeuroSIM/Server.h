@@ -0,0 +1,58 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+
+#ifndef SERVER_H_
+#define SERVER_H_
+
+// 常驻的仿真服务：./main --serve NetWork.csv synapseBit numBitInput [socketPath]
+// 只初始化一次芯片（工艺、floorplan、各模块以及面积），之后逐行读入评估任务，各模块在任务之间保留（数字计算模式下权重固定的PE的结果也保留）
+// 没有socketPath时从标准输入读任务、向标准输出写结果（仿真过程的其他输出改到标准错误）；
+// 否则在该路径上监听UNIX socket，依次处理各个连接，排队的连接等待前面的连接结束
+//
+// 每行一个任务，以空格分隔，与main的命令行参数相同的顺序：
+//   layers <job> <newWeight> <oldWeight> <input> <activity> ...	模拟计算，依次给出每一层的trace文件和激活率
+//   tokens <job> <input_len> <output_len> ...						数字计算，一个或多个query的输入、输出长度
+//   info															芯片面积等初始化的结果
+//   quit															结束当前连接（标准输入时退出）
+//   shutdown														退出
+// 结果为JSON lines：每层或每个query一行（"layer"或"input_len"、"output_len"），最后一行为整个任务的总结果（"done": true），
+// 出错时返回一行{"job": ..., "error": ...}，服务继续运行
+int RunServer(int argc, char *argv[]);
+
+#endif /* SERVER_H_ */
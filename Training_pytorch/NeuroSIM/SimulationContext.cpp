@@ -0,0 +1,146 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#include <cmath>
+#include <iostream>
+#include <stdlib.h>
+#include "SimulationContext.h"
+
+using namespace std;
+
+thread_local Param *param = NULL;
+
+SimulationContext::SimulationContext(): components() {
+	param = new Param();
+	inputParameter = new InputParameter();
+	tech = new Technology();
+	cell = new MemCell();
+	ownsTechnology = true;
+}
+
+SimulationContext::SimulationContext(const SimulationContext &original): components() {
+	param = new Param(*original.param);	// 各线程写入的参数（例如activity）互不影响
+	inputParameter = original.inputParameter;
+	tech = original.tech;
+	cell = original.cell;
+	components = ChipCopyComponents(original.components);
+	ownsTechnology = false;
+}
+
+SimulationContext::~SimulationContext() {
+	ChipDeleteComponents(components);
+	if (::param == param) {
+		::param = NULL;
+	}
+	delete param;
+	if (ownsTechnology) {
+		delete inputParameter;
+		delete tech;
+		delete cell;
+	}
+}
+
+void SimulationContext::Initialize(int synapseBit, int numBitInput) {
+	param->synapseBit = synapseBit;             		 // precision of synapse weight
+	param->numBitInput = numBitInput;            		 // precision of input neural activation
+	
+	if (param->cellBit > param->synapseBit) {
+		cout << "ERROR!: Memory precision is even higher than synapse precision, please modify 'cellBit' in Param.cpp!" << endl;
+		param->cellBit = param->synapseBit;
+	}
+	
+	/*** initialize operationMode as default ***/
+	param->conventionalParallel = 0;
+	param->conventionalSequential = 0;
+	param->BNNparallelMode = 0;                // parallel BNN
+	param->BNNsequentialMode = 0;              // sequential BNN
+	param->XNORsequentialMode = 0;           // Use several multi-bit RRAM as one synapse
+	param->XNORparallelMode = 0;         // Use several multi-bit RRAM as one synapse
+	switch(param->operationmode) {
+		case 6:	    param->XNORparallelMode = 1;               break;     
+		case 5:	    param->XNORsequentialMode = 1;             break;     
+		case 4:	    param->BNNparallelMode = 1;                break;     
+		case 3:	    param->BNNsequentialMode = 1;              break;    
+		case 2:	    param->conventionalParallel = 1;           break;     
+		case 1:	    param->conventionalSequential = 1;         break;    
+		case -1:	break;
+		default:	exit(-1);
+	}
+	
+	if (param->XNORparallelMode || param->XNORsequentialMode) {
+		param->numRowPerSynapse = 2;
+	} else {
+		param->numRowPerSynapse = 1;
+	}
+	if (param->BNNparallelMode) {
+		param->numColPerSynapse = 2;
+	} else if (param->XNORparallelMode || param->XNORsequentialMode || param->BNNsequentialMode) {
+		param->numColPerSynapse = 1;
+	} else {
+		param->numColPerSynapse = ceil((double)param->synapseBit/(double)param->cellBit); 
+	}
+	
+	switch(param->transistortype) {
+		case 3:	    inputParameter->transistorType = TFET;          break;
+		case 2:	    inputParameter->transistorType = FET_2D;        break;
+		case 1:	    inputParameter->transistorType = conventional;  break;
+		case -1:	break;
+		default:	exit(-1);
+	}
+	
+	switch(param->deviceroadmap) {
+		case 2:	    inputParameter->deviceRoadmap = LSTP;  break;
+		case 1:	    inputParameter->deviceRoadmap = HP;    break;
+		case -1:	break;
+		default:	exit(-1);
+	}
+	
+	/* Create SubArray object and link the required global objects (not initialization) */
+	inputParameter->temperature = param->temp;   // Temperature (K)
+	inputParameter->processNode = param->technode;    // Technology node
+	tech->Initialize(inputParameter->processNode, inputParameter->deviceRoadmap, inputParameter->transistorType);
+}
+
+void SimulationContext::Bind() {
+	::param = param;
+	ChipSetComponents(components);
+}
+
+SimulationContext *SimulationContext::Fork() {
+	return new SimulationContext(*this);
+}
@@ -0,0 +1,77 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#ifndef SIMULATIONCONTEXT_H_
+#define SIMULATIONCONTEXT_H_
+
+#include <string>
+#include <vector>
+#include "InputParameter.h"
+#include "Technology.h"
+#include "MemCell.h"
+#include "Param.h"
+
+using namespace std;
+
+#include "Chip.h"
+
+extern thread_local Param *param;	// 当前线程绑定的context的参数
+
+// 一个设计点的完整仿真状态：参数、工艺、器件以及Chip/Tile/PE的所有模块实例
+// Chip级的接口在入口处把context绑定到当前线程，因此不同的context可以在不同线程中同时仿真
+class SimulationContext {
+public:
+	SimulationContext();
+	virtual ~SimulationContext();
+	void Initialize(int synapseBit, int numBitInput);	// 设置权重和输入的精度，确定工作模式和每个突触占用的行列数，并初始化工艺参数
+	void Bind();	// 当前线程改为使用本context的param和模块实例
+	SimulationContext *Fork();	// 复制一份参数和模块实例供其他线程使用，工艺和器件在初始化后只读，与本context共享，本context需要比复制出的context存在更久
+
+	Param *param;
+	InputParameter *inputParameter;
+	Technology *tech;
+	MemCell *cell;
+	ChipComponents components;	// 由ChipDesignInitialize和ChipInitialize创建
+
+private:
+	SimulationContext(const SimulationContext &original);	// 只通过Fork复制
+	SimulationContext &operator=(const SimulationContext &original);
+	bool ownsTechnology;	// inputParameter、tech和cell由本context创建（不是Fork出来的）
+};
+
+#endif /* SIMULATIONCONTEXT_H_ */
@@ -37,6 +37,7 @@
 ********************************************************************************/
 
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include "constant.h"
@@ -1117,6 +1118,7 @@ void SubArray::CalculateLatency(double columnRes, const vector<double> &columnRe
 		// cout<<"here\n";
 		readLatency = 0;
 		writeLatency = 0;
+		readoutInLatencyADC = false;
 
 		if (cell.memCellType == Type::SRAM) {
 			if (conventionalSequential) {
@@ -1250,6 +1252,7 @@ void SubArray::CalculateLatency(double columnRes, const vector<double> &columnRe
 				readLatency += sarADC.readLatency;
 				
 				readLatencyADC = precharger.readLatency + colDelay + multilevelSenseAmp.readLatency + multilevelSAEncoder.readLatency + sarADC.readLatency;
+				readoutInLatencyADC = true;
 				readLatencyAccum = shiftAddInput.readLatency + shiftAddWeight.readLatency;
 				readLatencyOther = MAX(wlSwitchMatrix.readLatency, ( ((numColMuxed > 1)==true? (mux.readLatency+muxDecoder.readLatency):0) )/numReadPulse);
 
@@ -1525,6 +1528,7 @@ void SubArray::CalculateLatency(double columnRes, const vector<double> &columnRe
 				readLatency += sarADC.readLatency;
 				
 				readLatencyADC = multilevelSenseAmp.readLatency + multilevelSAEncoder.readLatency + sarADC.readLatency;
+				readoutInLatencyADC = true;
 				readLatencyAccum = shiftAddInput.readLatency + shiftAddWeight.readLatency;
 				readLatencyOther = MAX(wlNewSwitchMatrix.readLatency + wlSwitchMatrix.readLatency, ( ((numColMuxed > 1)==true? (mux.readLatency+muxDecoder.readLatency):0) )) + colDelay + slSwitchMatrix.readLatency;
 
@@ -1666,6 +1670,7 @@ void SubArray::CalculateLatency(double columnRes, const vector<double> &columnRe
 				readLatency += sarADC.readLatency;
 				
 				readLatencyADC = multilevelSenseAmp.readLatency + multilevelSAEncoder.readLatency + sarADC.readLatency;
+				readoutInLatencyADC = true;
 				readLatencyAccum = adder.readLatency + dff.readLatency + shiftAddInput.readLatency + shiftAddWeight.readLatency;
 				readLatencyOther = MAX(wlDecoder.readLatency + wlNewDecoderDriver.readLatency + wlDecoderDriver.readLatency, ( ((numColMuxed > 1)==true? (mux.readLatency+muxDecoder.readLatency):0) )/numReadPulse) + colDelay/numReadPulse;
 				
@@ -1765,6 +1770,7 @@ void SubArray::CalculateLatency(double columnRes, const vector<double> &columnRe
 				readLatency += sarADC.readLatency;
 				
 				readLatencyADC = multilevelSenseAmp.readLatency + multilevelSAEncoder.readLatency + sarADC.readLatency;
+				readoutInLatencyADC = true;
 				readLatencyAccum = shiftAddInput.readLatency + shiftAddWeight.readLatency;
 				readLatencyOther = MAX(wlNewSwitchMatrix.readLatency + wlSwitchMatrix.readLatency, ( ((numColMuxed > 1)==true? (mux.readLatency+muxDecoder.readLatency):0) )/numReadPulse) + colDelay/numReadPulse;
 
@@ -1991,6 +1997,8 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 		readDynamicEnergy = 0;
 		writeDynamicEnergy = 0;
 		readDynamicEnergyArray = 0;
+		readoutInEnergyADC = false;
+		multilevelSenseAmpInEnergy = false;
 		
 		double numReadOperationPerRow;   // average value (can be non-integer for energy calculation)
 		if (numCol > numReadCellPerOperationNeuro)
@@ -2130,6 +2138,7 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 				readDynamicEnergy += precharger.readDynamicEnergy;
 				readDynamicEnergy += readDynamicEnergyArray;
 				readDynamicEnergy += multilevelSenseAmp.readDynamicEnergy;
+				multilevelSenseAmpInEnergy = true;
 				readDynamicEnergy += multilevelSAEncoder.readDynamicEnergy;
 				readDynamicEnergy += ((numColMuxed > 1)==true? (mux.readDynamicEnergy/numReadPulse):0);
 				readDynamicEnergy += ((numColMuxed > 1)==true? (muxDecoder.readDynamicEnergy/numReadPulse):0);
@@ -2137,6 +2146,7 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 				readDynamicEnergy += sarADC.readDynamicEnergy;
  
 				readDynamicEnergyADC = precharger.readDynamicEnergy + readDynamicEnergyArray + multilevelSenseAmp.readDynamicEnergy + multilevelSAEncoder.readDynamicEnergy + sarADC.readDynamicEnergy;
+				readoutInEnergyADC = true;
 				readDynamicEnergyAccum = shiftAddWeight.readDynamicEnergy + shiftAddInput.readDynamicEnergy;
 				readDynamicEnergyOther = wlSwitchMatrix.readDynamicEnergy + ( ((numColMuxed > 1)==true? (mux.readDynamicEnergy + muxDecoder.readDynamicEnergy):0) )/numReadPulse;
 				
@@ -2300,6 +2310,7 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 				readDynamicEnergy += precharger.readDynamicEnergy;
 				readDynamicEnergy += readDynamicEnergyArray;
 				readDynamicEnergy += multilevelSenseAmp.readDynamicEnergy;
+				multilevelSenseAmpInEnergy = true;
 				readDynamicEnergy += multilevelSAEncoder.readDynamicEnergy;
 				readDynamicEnergy += sarADC.readDynamicEnergy;
 				
@@ -2341,6 +2352,7 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 				readDynamicEnergy += precharger.readDynamicEnergy;
 				readDynamicEnergy += readDynamicEnergyArray;
 				readDynamicEnergy += multilevelSenseAmp.readDynamicEnergy;
+				multilevelSenseAmpInEnergy = true;
 				readDynamicEnergy += multilevelSAEncoder.readDynamicEnergy;
 				readDynamicEnergy += shiftAddInput.readDynamicEnergy + shiftAddWeight.readDynamicEnergy;
 				readDynamicEnergy += sarADC.readDynamicEnergy;
@@ -2394,6 +2406,7 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 				readDynamicEnergy += wlSwitchMatrix.readDynamicEnergy;
 				readDynamicEnergy += ( ((numColMuxed > 1)==true? (mux.readDynamicEnergy + muxDecoder.readDynamicEnergy):0) );
 				readDynamicEnergy += multilevelSenseAmp.readDynamicEnergy;
+				multilevelSenseAmpInEnergy = true;
 				readDynamicEnergy += multilevelSAEncoder.readDynamicEnergy;
 				readDynamicEnergy += shiftAddWeight.readDynamicEnergy + shiftAddInput.readDynamicEnergy;
 				readDynamicEnergy += readDynamicEnergyArray;
@@ -2403,6 +2416,7 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 				readDynamicEnergy += slSwitchMatrix.readDynamicEnergy;//将slSwitch矩阵的nor能耗计入
 				// cout<<"Subarray readDynamicEnergy is"<<readDynamicEnergy<<" Subarray arrayEnergy is "<<writeDynamicEnergyArray<<endl;
 				readDynamicEnergyADC = readDynamicEnergyArray + multilevelSenseAmp.readDynamicEnergy + multilevelSAEncoder.readDynamicEnergy + sarADC.readDynamicEnergy;
+				readoutInEnergyADC = true;
 				readDynamicEnergyAccum = shiftAddWeight.readDynamicEnergy + shiftAddInput.readDynamicEnergy;
 				readDynamicEnergyOther = wlNewSwitchMatrix.readDynamicEnergy + wlSwitchMatrix.readDynamicEnergy + ( ((numColMuxed > 1)==true? (mux.readDynamicEnergy + muxDecoder.readDynamicEnergy):0) );
 				
@@ -2582,6 +2596,7 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 				readDynamicEnergy += sarADC.readDynamicEnergy;
 				
 				readDynamicEnergyADC = readDynamicEnergyArray + multilevelSenseAmp.readDynamicEnergy + multilevelSAEncoder.readDynamicEnergy + sarADC.readDynamicEnergy;
+				readoutInEnergyADC = true;
 				readDynamicEnergyAccum = adder.readDynamicEnergy + dff.readDynamicEnergy + shiftAddWeight.readDynamicEnergy + shiftAddInput.readDynamicEnergy;
 				readDynamicEnergyOther = wlDecoder.readDynamicEnergy + wlNewDecoderDriver.readDynamicEnergy + wlDecoderDriver.readDynamicEnergy + ( ((numColMuxed > 1)==true? (mux.readDynamicEnergy + muxDecoder.readDynamicEnergy):0) )/numReadPulse;
 
@@ -2706,12 +2721,14 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 				readDynamicEnergy += wlSwitchMatrix.readDynamicEnergy;
 				readDynamicEnergy += ( ((numColMuxed > 1)==true? (mux.readDynamicEnergy + muxDecoder.readDynamicEnergy):0) )/numReadPulse;
 				readDynamicEnergy += multilevelSenseAmp.readDynamicEnergy;
+				multilevelSenseAmpInEnergy = true;
 				readDynamicEnergy += multilevelSAEncoder.readDynamicEnergy;
 				readDynamicEnergy += shiftAddWeight.readDynamicEnergy + shiftAddInput.readDynamicEnergy;
 				readDynamicEnergy += readDynamicEnergyArray;
 				readDynamicEnergy += sarADC.readDynamicEnergy;
 				
 				readDynamicEnergyADC = readDynamicEnergyArray + multilevelSenseAmp.readDynamicEnergy + multilevelSAEncoder.readDynamicEnergy + sarADC.readDynamicEnergy;
+				readoutInEnergyADC = true;
 				readDynamicEnergyAccum = shiftAddWeight.readDynamicEnergy + shiftAddInput.readDynamicEnergy;
 				readDynamicEnergyOther = wlNewSwitchMatrix.readDynamicEnergy + wlSwitchMatrix.readDynamicEnergy + ( ((numColMuxed > 1)==true? (mux.readDynamicEnergy + muxDecoder.readDynamicEnergy):0) )/numReadPulse;
 				
@@ -2930,6 +2947,7 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 				readDynamicEnergy += wlSwitchMatrix.readDynamicEnergy;
 				readDynamicEnergy += ( ((numColMuxed > 1)==true? (mux.readDynamicEnergy + muxDecoder.readDynamicEnergy):0) )/numReadPulse;
 				readDynamicEnergy += multilevelSenseAmp.readDynamicEnergy;
+				multilevelSenseAmpInEnergy = true;
 				readDynamicEnergy += multilevelSAEncoder.readDynamicEnergy;
 				readDynamicEnergy += readDynamicEnergyArray;
 				readDynamicEnergy += sarADC.readDynamicEnergy;
@@ -2992,6 +3010,7 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 				readDynamicEnergy += wlSwitchMatrix.readDynamicEnergy;
 				readDynamicEnergy += ( ((numColMuxed > 1)==true? (mux.readDynamicEnergy + muxDecoder.readDynamicEnergy):0) )/numReadPulse;
 				readDynamicEnergy += multilevelSenseAmp.readDynamicEnergy;
+				multilevelSenseAmpInEnergy = true;
 				readDynamicEnergy += multilevelSAEncoder.readDynamicEnergy;
 				readDynamicEnergy += shiftAddInput.readDynamicEnergy + shiftAddWeight.readDynamicEnergy;
 				readDynamicEnergy += readDynamicEnergyArray;
@@ -3022,6 +3041,136 @@ void SubArray::CalculatePower(const vector<double> &columnResistance, const vect
 	}
 }
 
+template <class Readout>
+static void SaveReadoutState(const Readout &readout, SubArrayReadoutState &state) {
+	state.call = readout.lastCall;
+	state.readLatency = readout.readLatency;
+	state.readDynamicEnergy = readout.readDynamicEnergy;
+}
+
+// 用新的columnResistance重新计算Prepare()时调用过的读出电路，返回每个输入向量的延迟和能耗的变化量
+template <class Readout>
+static void UpdateReadout(Readout &readout, const SubArrayReadoutState &state, const double *columnResistance, int numVector, int numColumn, vector<double> &deltaLatency, vector<double> &deltaEnergy) {
+	deltaLatency.assign(numVector, 0);
+	deltaEnergy.assign(numVector, 0);
+	if (!state.call.latencyCalculated && !state.call.powerCalculated) {
+		return;
+	}
+	readout.lastCall = state.call;
+	readout.readLatency = state.readLatency;
+	readout.readDynamicEnergy = state.readDynamicEnergy;
+	readout.RecalculateBatch(columnResistance, numVector, numColumn, &deltaLatency[0], &deltaEnergy[0]);
+	for (int v=0; v<numVector; v++) {
+		deltaLatency[v] -= state.readLatency;
+		deltaEnergy[v] -= state.readDynamicEnergy;
+	}
+}
+
+void SubArray::Prepare(const vector<double> &columnResistance, const vector<double> &rowResistance) {
+	multilevelSenseAmp.lastCall = ReadoutCall();
+	sarADC.lastCall = ReadoutCall();
+	rowCurrentSenseAmp.lastCall = ReadoutCall();
+	multilevelSenseAmpBP.lastCall = ReadoutCall();
+	sarADCBP.lastCall = ReadoutCall();
+	
+	CalculateLatency(1e20, columnResistance, rowResistance);
+	CalculatePower(columnResistance, rowResistance);
+	
+	SubArrayPrepared &state = prepared[activityRowRead];
+	state.estimation.readLatency = readLatency;
+	state.estimation.readDynamicEnergy = readDynamicEnergy;
+	state.estimation.leakage = leakage;
+	state.estimation.readLatencyAG = readLatencyAG;
+	state.estimation.readDynamicEnergyAG = readDynamicEnergyAG;
+	state.estimation.readLatencyADC = readLatencyADC;
+	state.estimation.readLatencyAccum = readLatencyAccum;
+	state.estimation.readLatencyOther = readLatencyOther;
+	state.estimation.readDynamicEnergyADC = readDynamicEnergyADC;
+	state.estimation.readDynamicEnergyAccum = readDynamicEnergyAccum;
+	state.estimation.readDynamicEnergyOther = readDynamicEnergyOther;
+	state.estimation.writeLatency = writeLatency;
+	state.estimation.writeDynamicEnergy = writeDynamicEnergy;
+	state.readoutInLatencyADC = readoutInLatencyADC;
+	state.readoutInEnergyADC = readoutInEnergyADC;
+	state.multilevelSenseAmpInEnergy = multilevelSenseAmpInEnergy;
+	SaveReadoutState(multilevelSenseAmp, state.multilevelSenseAmp);
+	SaveReadoutState(sarADC, state.sarADC);
+	SaveReadoutState(rowCurrentSenseAmp, state.rowCurrentSenseAmp);
+	SaveReadoutState(multilevelSenseAmpBP, state.multilevelSenseAmpBP);
+	SaveReadoutState(sarADCBP, state.sarADCBP);
+}
+
+void SubArray::Evaluate(const vector<double> &columnResistance) {
+	SubArrayEstimation estimation;
+	EvaluateBatch(columnResistance.empty()? NULL : &columnResistance[0], 1, columnResistance.size(), &estimation);
+	readLatency = estimation.readLatency;
+	readDynamicEnergy = estimation.readDynamicEnergy;
+	leakage = estimation.leakage;
+	readLatencyAG = estimation.readLatencyAG;
+	readDynamicEnergyAG = estimation.readDynamicEnergyAG;
+	readLatencyADC = estimation.readLatencyADC;
+	readLatencyAccum = estimation.readLatencyAccum;
+	readLatencyOther = estimation.readLatencyOther;
+	readDynamicEnergyADC = estimation.readDynamicEnergyADC;
+	readDynamicEnergyAccum = estimation.readDynamicEnergyAccum;
+	readDynamicEnergyOther = estimation.readDynamicEnergyOther;
+	writeLatency = estimation.writeLatency;
+	writeDynamicEnergy = estimation.writeDynamicEnergy;
+}
+
+void SubArray::EvaluateBatch(const double *columnResistance, int numVector, int numColumn, SubArrayEstimation *estimation) {
+	map<double, SubArrayPrepared>::const_iterator it = prepared.find(activityRowRead);
+	if (it == prepared.end()) {
+		cout << "[Subarray] Error: Require Prepare() with the same activityRowRead first!" << endl;
+		exit(-1);
+	}
+	const SubArrayPrepared &state = it->second;
+	for (int v=0; v<numVector; v++) {
+		estimation[v] = state.estimation;
+	}
+	
+	// 读出电路的漏电为0，只需更新读延迟和读能耗
+	vector<double> deltaLatency, deltaEnergy;
+	UpdateReadout(multilevelSenseAmp, state.multilevelSenseAmp, columnResistance, numVector, numColumn, deltaLatency, deltaEnergy);
+	for (int v=0; v<numVector; v++) {
+		estimation[v].readLatency += deltaLatency[v];
+		estimation[v].readDynamicEnergy += (state.multilevelSenseAmpInEnergy? deltaEnergy[v] : 0);
+		estimation[v].readLatencyADC += (state.readoutInLatencyADC? deltaLatency[v] : 0);
+		estimation[v].readDynamicEnergyADC += (state.readoutInEnergyADC? deltaEnergy[v] : 0);
+	}
+	
+	UpdateReadout(sarADC, state.sarADC, columnResistance, numVector, numColumn, deltaLatency, deltaEnergy);
+	for (int v=0; v<numVector; v++) {
+		estimation[v].readLatency += deltaLatency[v];
+		estimation[v].readDynamicEnergy += deltaEnergy[v];
+		estimation[v].readLatencyADC += (state.readoutInLatencyADC? deltaLatency[v] : 0);
+		estimation[v].readDynamicEnergyADC += (state.readoutInEnergyADC? deltaEnergy[v] : 0);
+	}
+	
+	UpdateReadout(rowCurrentSenseAmp, state.rowCurrentSenseAmp, columnResistance, numVector, numColumn, deltaLatency, deltaEnergy);
+	for (int v=0; v<numVector; v++) {
+		estimation[v].readLatency += deltaLatency[v];
+		estimation[v].readDynamicEnergy += deltaEnergy[v];
+	}
+	
+	/* Transpose Peripheral for BP */
+	UpdateReadout(multilevelSenseAmpBP, state.multilevelSenseAmpBP, columnResistance, numVector, numColumn, deltaLatency, deltaEnergy);
+	for (int v=0; v<numVector; v++) {
+		estimation[v].readLatencyAG += deltaLatency[v];
+		estimation[v].readDynamicEnergyAG += deltaEnergy[v];
+		estimation[v].readLatencyADC += deltaLatency[v];
+		estimation[v].readDynamicEnergyADC += deltaEnergy[v];
+	}
+	
+	UpdateReadout(sarADCBP, state.sarADCBP, columnResistance, numVector, numColumn, deltaLatency, deltaEnergy);
+	for (int v=0; v<numVector; v++) {
+		estimation[v].readLatencyAG += deltaLatency[v];
+		estimation[v].readDynamicEnergyAG += deltaEnergy[v];
+		estimation[v].readLatencyADC += deltaLatency[v];
+		estimation[v].readDynamicEnergyADC += deltaEnergy[v];
+	}
+}
+
 void SubArray::PrintProperty() {
 
 	if (cell.memCellType == Type::SRAM) {
@@ -39,6 +39,7 @@
 #ifndef SUBARRAY_H_
 #define SUBARRAY_H_
 
+#include <map>
 #include <vector>
 #include "typedef.h"
 #include "InputParameter.h"
@@ -68,6 +69,25 @@
 
 using namespace std;
 
+struct SubArrayEstimation {
+	double readLatency, readDynamicEnergy, leakage, readLatencyAG, readDynamicEnergyAG;
+	double readLatencyADC, readLatencyAccum, readLatencyOther, readDynamicEnergyADC, readDynamicEnergyAccum, readDynamicEnergyOther;
+	double writeLatency, writeDynamicEnergy;
+};
+
+// 读出电路（SA/ADC）在Prepare()时的调用参数和结果
+struct SubArrayReadoutState {
+	ReadoutCall call;
+	double readLatency, readDynamicEnergy;
+};
+
+// Prepare()完整计算一次后的结果，Evaluate()在此基础上只替换读出电路的贡献
+struct SubArrayPrepared {
+	SubArrayEstimation estimation;
+	bool readoutInLatencyADC, readoutInEnergyADC, multilevelSenseAmpInEnergy;
+	SubArrayReadoutState multilevelSenseAmp, sarADC, rowCurrentSenseAmp, multilevelSenseAmpBP, sarADCBP;
+};
+
 class SubArray: public FunctionUnit {
 public:
 	SubArray(InputParameter& _inputParameter, Technology& _tech, MemCell& _cell);
@@ -82,6 +102,14 @@ public:
 	void CalculateArea();
 	void CalculateLatency(double _rampInput, const vector<double> &columnResistance, const vector<double> &rowResistance);
 	void CalculatePower(const vector<double> &columnResistance, const vector<double> &rowResistance);
+	// 两阶段评估：除读出电路（SA/ADC）外，读写结果只与activityRowRead有关，与具体的columnResistance无关
+	// Prepare()对当前activityRowRead完整计算一次并记录，Evaluate()只用新的columnResistance重新计算读出电路
+	void Prepare(const vector<double> &columnResistance, const vector<double> &rowResistance);
+	void Evaluate(const vector<double> &columnResistance);
+	// Evaluate()的批量版本：numVector个activityRowRead相同的输入向量，columnResistance按向量连续存储（每个向量numColumn列）
+	void EvaluateBatch(const double *columnResistance, int numVector, int numColumn, SubArrayEstimation *estimation);
+	bool IsPrepared() const { return prepared.count(activityRowRead) > 0; }
+	void ClearPrepared() { prepared.clear(); }	// 权重、写入参数或levelOutput改变后需要清空
 
 	/* Properties */	
 	bool initialized;	   // Initialization flag
@@ -162,6 +190,8 @@ public:
 
 	double areaADC, areaAccum, areaOther, readLatencyADC, readLatencyAccum, readLatencyOther, readDynamicEnergyADC, readDynamicEnergyAccum, readDynamicEnergyOther;
 	double areaAG, readLatencyAG, readDynamicEnergyAG;
+	bool readoutInLatencyADC, readoutInEnergyADC, multilevelSenseAmpInEnergy;	// 读出电路是否计入readLatencyADC、readDynamicEnergyADC、readDynamicEnergy
+	map<double, SubArrayPrepared> prepared;	// 按activityRowRead索引
 
 	/* Circuit modules */
 	RowDecoder                   wlDecoder;
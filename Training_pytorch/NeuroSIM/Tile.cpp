@@ -39,11 +39,11 @@
 #include <cmath>
 #include <iostream>
 #include <fstream>
-#include <random> //用于生成权重矩阵
 #include <string>
 #include <stdlib.h>
 #include <vector>
 #include <sstream>
+#include <map>
 #include "Sigmoid.h"
 #include "BitShifter.h"
 #include "AdderTree.h"
@@ -55,34 +55,42 @@
 #include "formula.h"
 #include "Param.h"
 #include "Tile.h"
+#include "SimulationContext.h"
+#include "WeightOperand.h"
 
 using namespace std;
 
-extern Param *param;
-int numInBufferCore = 0;
-int numOutBufferCore = 0;
+extern thread_local Param *param;
+thread_local int numInBufferCore = 0;
+thread_local int numOutBufferCore = 0;
 
-SubArray *subArrayInPE;
-Buffer *inputBufferCM;
-Buffer *outputBufferCM;
-HTree *hTreeCM;
-AdderTree *accumulationCM;
-Sigmoid *sigmoidCM;
-BitShifter *reLuCM;
-Buffer *inputBufferNM;
-Buffer *outputBufferNM;
-HTree *hTreeNM;
-AdderTree *accumulationNM;
-Sigmoid *sigmoidNM;
-BitShifter *reLuNM;				   
+// 模块实例为线程私有，由SimulationContext::Bind通过TileSetComponents绑定到当前线程
+thread_local SubArray *subArrayInPE;
+thread_local Buffer *inputBufferCM;
+thread_local Buffer *outputBufferCM;
+thread_local HTree *hTreeCM;
+thread_local AdderTree *accumulationCM;
+thread_local Sigmoid *sigmoidCM;
+thread_local BitShifter *reLuCM;
+thread_local Buffer *inputBufferNM;
+thread_local Buffer *outputBufferNM;
+thread_local HTree *hTreeNM;
+thread_local AdderTree *accumulationNM;
+thread_local Sigmoid *sigmoidNM;
+thread_local BitShifter *reLuNM;				   
 
 
-static int seq_len_total =0; //用于记录当前已经生成的总token数量，用于确认k v 的大小
+static thread_local map<int, vector<PEPerformance> > *staticPECache; //增量解码模式下按seq_len缓存权重固定的PE的评估结果
 
 
 void TileInitialize(InputParameter& inputParameter, Technology& tech, MemCell& cell, double _numPENM, double _peSizeNM, double _numPECM, double _peSizeCM, bool digital ){
 	
 	subArrayInPE = new SubArray(inputParameter, tech, cell);
+	if (staticPECache) {
+		staticPECache->clear();
+	} else {
+		staticPECache = new map<int, vector<PEPerformance> >;
+	}
 	inputBufferNM = new Buffer(inputParameter, tech, cell);
 	outputBufferNM = new Buffer(inputParameter, tech, cell);
 	hTreeNM = new HTree(inputParameter, tech, cell);
@@ -346,9 +354,9 @@ vector<double> TileCalculateArea(double numPE, double peSize, bool NMTile, doubl
 }
 
 
-void TileCalculatePerformance(const vector<vector<double> > &newMemory, const vector<vector<double> > &oldMemory, const vector<vector<double> > &inputVector, 
+void TileCalculatePerformance(const MatrixView &newMemory, const MatrixView &oldMemory, const BitMatrixView &inputVector, 
 							int novelMap, bool digital, int seq_len ,int seq_len_total, int layerNumber, double numPE, 
-							double peSize, int speedUpRow, int speedUpCol, int weightMatrixRow, int weightMatrixCol, int numInVector, Technology& tech, MemCell& cell, 
+							double peSize, int speedUpRow, int speedUpCol, int weightMatrixRow, int weightMatrixCol, int numInVector, SimulationContext& context, 
 							double *readLatency, double *readDynamicEnergy, double *leakage, double *readLatencyAG, double *readDynamicEnergyAG, double *writeLatencyWU, double *writeDynamicEnergyWU,
 							double *bufferLatency, double *bufferDynamicEnergy, double *icLatency, double *icDynamicEnergy,
 							double *coreLatencyADC, double *coreLatencyAccum, double *coreLatencyOther, double *coreEnergyADC, 
@@ -398,10 +406,6 @@ void TileCalculatePerformance(const vector<vector<double> > &newMemory, const ve
 
 		// int seq_len = seq_len; //TODO获取序列长度，由于这里不需要实际的Input输入，输入向量只用来表征token的个数，在每个pe传递一个fake input，用于适配其中模拟计算的代码。
 		
-		vector<vector<double> > pEMemoryOld; //无数据
-		vector<vector<double> > pEMemory; //由于无法获取处理过程中的实际权重矩阵，因此采用随机数生成的方式
-		vector<vector<double> > pEInput; // fake input，此处的物理意义并不是输入，而是代表矩阵读出时激活的行数 ，用于适配其中的mux的功耗计算。 input直接设置为一个全1的列，行数与权重行相对应，列数与输入token数相对应
-
 
 		//Wq、Wk、Wv矩阵依次映射到不同的pe上 矩阵维度（d_model, d_k*n_heads），同时由于数字计算，因此矩阵需要转置，则映射矩阵维度为（d_k*n_heads,d_model）
 		//在行上需要多bit存储，因此最终矩阵维度为  
@@ -411,7 +415,7 @@ void TileCalculatePerformance(const vector<vector<double> > &newMemory, const ve
 		// numInVector = seq_len; 
 		// pEInput = generateOnesMatrix(weightMatrixRow,seq_len);
 		// cout << "----------------- Start PE Performance ------------------" <<  endl;
-		// ProcessingUnitCalculatePerformance(subArrayInPE, tech, cell, layerNumber, false, true, 0, pEMemory, pEMemoryOld, pEInput, 0, 0, 
+		// ProcessingUnitCalculatePerformance(subArrayInPE, context, layerNumber, false, true, 0, pEMemory, pEMemoryOld, pEInput, 0, 0, 
 		// 									numSubArrayRow, numSubArrayCol, weightMatrixRow, weightMatrixCol, numInVector, &PEreadLatency, &PEreadDynamicEnergy, &PEleakage,
 		// 									&PEreadLatencyAG, &PEreadDynamicEnergyAG, &PEwriteLatencyWU, &PEwriteDynamicEnergyWU,
 		// 									&PEbufferLatency, &PEbufferDynamicEnergy, &PEicLatency, &PEicDynamicEnergy,
@@ -424,210 +428,48 @@ void TileCalculatePerformance(const vector<vector<double> > &newMemory, const ve
 		// *readDynamicEnergy += PEreadDynamicEnergy*2;
 		//其他的延迟和能耗暂时不考虑
 
-		// Wv矩阵  由于wv矩阵、wk矩阵、wq矩阵一般情况下大小相同，并且可以并行运算，所以直接简化计算
-		weightMatrixRow = param->d_v*param->n_heads;
-		weightMatrixCol = param->d_model*param->synapseBit;
-		pEMemory = generateRandomWeightMatrix(weightMatrixRow,weightMatrixCol);
-		numInVector = seq_len; 
-		pEInput = generateOnesMatrix(weightMatrixRow,seq_len);
-		ProcessingUnitCalculatePerformance(subArrayInPE, tech, cell, layerNumber, false, true, 0, pEMemory, pEMemoryOld, pEInput, 0, 0, 
-											numSubArrayRow, numSubArrayCol, weightMatrixRow, weightMatrixCol, numInVector, &PEreadLatency, &PEreadDynamicEnergy, &PEleakage,
-											&PEreadLatencyAG, &PEreadDynamicEnergyAG, &PEwriteLatencyWU, &PEwriteDynamicEnergyWU,
-											&PEbufferLatency, &PEbufferDynamicEnergy, &PEicLatency, &PEicDynamicEnergy,
-											&peLatencyADC, &peLatencyAccum, &peLatencyOther, &peEnergyADC, &peEnergyAccum, &peEnergyOther, 
-											&peReadLatencyPeakFW, &peReadDynamicEnergyPeakFW, &peReadLatencyPeakAG, &peReadDynamicEnergyPeakAG,
-											&peWriteLatencyPeakWU, &peWriteDynamicEnergyPeakWU);
+		// 权重固定的PE（Wv、linear、FFN1、FFN2）的结果只与seq_len有关，在增量解码模式下对相同的seq_len只评估一次，
+		// 每个token只需要重新评估随seq_len_total增长的K、V缓存矩阵
+		vector<PEPerformance> staticPE;
+		map<int, vector<PEPerformance> >::iterator it = staticPECache->find(seq_len);
+		if (param->incrementalDecode && it != staticPECache->end()) {
+			staticPE = it->second;
+		} else {
+			// Wv矩阵  由于wv矩阵、wk矩阵、wq矩阵一般情况下大小相同，并且可以并行运算，所以直接简化计算
+			staticPE.push_back(DigitalPECalculatePerformance(param->d_v*param->n_heads, param->d_model*param->synapseBit, 1, seq_len, layerNumber, numSubArrayRow, numSubArrayCol, context));
+			//linear layer
+			//线性层需要将d_v*n_heads 映射到 d_model
+			staticPE.push_back(DigitalPECalculatePerformance(param->d_model, param->d_v*param->n_heads*param->synapseBit, 4, seq_len, layerNumber, numSubArrayRow, numSubArrayCol, context));
+			//FFN1层 为 d_model*d_hidden
+			staticPE.push_back(DigitalPECalculatePerformance(param->d_hidden, param->d_model*param->synapseBit, 5, seq_len, layerNumber, numSubArrayRow, numSubArrayCol, context));
+			//FFN2层 为 d_hidden*d_model
+			staticPE.push_back(DigitalPECalculatePerformance(param->d_model, param->d_hidden*param->synapseBit, 6, seq_len, layerNumber, numSubArrayRow, numSubArrayCol, context));
+			if (param->incrementalDecode) {
+				(*staticPECache)[seq_len] = staticPE;
+			}
+		}
 		
-		*readLatency += PEreadLatency; //由于每个pe之间是串行执行的 乘2由于Wq和Wk大小相同
-		*readDynamicEnergy += PEreadDynamicEnergy*3;
-		*readLatencyAG += PEreadLatencyAG;
-		*readDynamicEnergyAG += PEreadDynamicEnergyAG*3;
-
-		*bufferLatency += PEbufferLatency;
-		*bufferDynamicEnergy += PEbufferDynamicEnergy*3;
-		*icLatency += PEicLatency;
-		*icDynamicEnergy += PEicDynamicEnergy*3;
-
-		*coreLatencyADC += peLatencyADC;
-		*coreLatencyAccum += peLatencyAccum;
-		*coreLatencyOther += peLatencyOther;
-
-		*coreEnergyADC += peEnergyADC*3;
-		*coreEnergyAccum += peEnergyAccum*3;
-		*coreEnergyOther += peEnergyOther*3;
-		//其他的延迟和能耗暂时不考虑
-
-
-		// K缓存矩阵 K矩阵存储的是转置后的版本
-		weightMatrixRow = seq_len_total;
-		weightMatrixCol = param->d_k*param->n_heads*param->synapseBit;
-		pEMemory = generateRandomWeightMatrix(weightMatrixRow,weightMatrixCol);
-		numInVector = seq_len; 
-		pEInput = generateOnesMatrix(weightMatrixRow,seq_len);
-		ProcessingUnitCalculatePerformance(subArrayInPE, tech, cell, layerNumber, false, true, 0, pEMemory, pEMemoryOld, pEInput, 0, 0, 
-											numSubArrayRow, numSubArrayCol, weightMatrixRow, weightMatrixCol, numInVector, &PEreadLatency, &PEreadDynamicEnergy, &PEleakage,
-											&PEreadLatencyAG, &PEreadDynamicEnergyAG, &PEwriteLatencyWU, &PEwriteDynamicEnergyWU,
-											&PEbufferLatency, &PEbufferDynamicEnergy, &PEicLatency, &PEicDynamicEnergy,
-											&peLatencyADC, &peLatencyAccum, &peLatencyOther, &peEnergyADC, &peEnergyAccum, &peEnergyOther, 
-											&peReadLatencyPeakFW, &peReadDynamicEnergyPeakFW, &peReadLatencyPeakAG, &peReadDynamicEnergyPeakAG,
-											&peWriteLatencyPeakWU, &peWriteDynamicEnergyPeakWU);
+		// 由于每个pe之间是串行执行的，延迟直接累加；Wq、Wk、Wv大小相同，能耗乘3
+		AccumulatePEPerformance(staticPE[0], 3, readLatency, readDynamicEnergy, readLatencyAG, readDynamicEnergyAG, bufferLatency, bufferDynamicEnergy, icLatency, icDynamicEnergy,
+								coreLatencyADC, coreLatencyAccum, coreLatencyOther, coreEnergyADC, coreEnergyAccum, coreEnergyOther);
 		
-		*readLatency += PEreadLatency; //由于每个pe之间是串行执行的 乘2由于Wq和Wk大小相同
-		*readDynamicEnergy += PEreadDynamicEnergy;
-		*readLatencyAG += PEreadLatencyAG;
-		*readDynamicEnergyAG += PEreadDynamicEnergyAG;
-
-		*bufferLatency += PEbufferLatency;
-		*bufferDynamicEnergy += PEbufferDynamicEnergy;
-		*icLatency += PEicLatency;
-		*icDynamicEnergy += PEicDynamicEnergy;
-
-		*coreLatencyADC += peLatencyADC;
-		*coreLatencyAccum += peLatencyAccum;
-		*coreLatencyOther += peLatencyOther;
-
-		*coreEnergyADC += peEnergyADC;
-		*coreEnergyAccum += peEnergyAccum;
-		*coreEnergyOther += peEnergyOther;
-		//其他的延迟和能耗暂时不考虑
+		// K缓存矩阵 K矩阵存储的是转置后的版本
+		AccumulatePEPerformance(DigitalPECalculatePerformance(seq_len_total, param->d_k*param->n_heads*param->synapseBit, 2, seq_len, layerNumber, numSubArrayRow, numSubArrayCol, context), 1,
+								readLatency, readDynamicEnergy, readLatencyAG, readDynamicEnergyAG, bufferLatency, bufferDynamicEnergy, icLatency, icDynamicEnergy,
+								coreLatencyADC, coreLatencyAccum, coreLatencyOther, coreEnergyADC, coreEnergyAccum, coreEnergyOther);
 
 		//SoftMax矩阵
 		//S为seq_len*seq_len_total //设计起来较为复杂，暂时考虑引入其他电路元件来处理，暂时忽略
-
 		
 		// V缓存矩阵 
-		weightMatrixRow = param->d_v*param->n_heads;
-		weightMatrixCol = seq_len_total*param->synapseBit;
-		pEMemory = generateRandomWeightMatrix(weightMatrixRow,weightMatrixCol);
-		numInVector = seq_len; 
-		pEInput = generateOnesMatrix(weightMatrixRow,seq_len);
-		ProcessingUnitCalculatePerformance(subArrayInPE, tech, cell, layerNumber, false, true, 0, pEMemory, pEMemoryOld, pEInput, 0, 0, 
-											numSubArrayRow, numSubArrayCol, weightMatrixRow, weightMatrixCol, numInVector, &PEreadLatency, &PEreadDynamicEnergy, &PEleakage,
-											&PEreadLatencyAG, &PEreadDynamicEnergyAG, &PEwriteLatencyWU, &PEwriteDynamicEnergyWU,
-											&PEbufferLatency, &PEbufferDynamicEnergy, &PEicLatency, &PEicDynamicEnergy,
-											&peLatencyADC, &peLatencyAccum, &peLatencyOther, &peEnergyADC, &peEnergyAccum, &peEnergyOther, 
-											&peReadLatencyPeakFW, &peReadDynamicEnergyPeakFW, &peReadLatencyPeakAG, &peReadDynamicEnergyPeakAG,
-											&peWriteLatencyPeakWU, &peWriteDynamicEnergyPeakWU);
-		
-		*readLatency += PEreadLatency; //由于每个pe之间是串行执行的 乘2由于Wq和Wk大小相同
-		*readDynamicEnergy += PEreadDynamicEnergy;
-		*readLatencyAG += PEreadLatencyAG;
-		*readDynamicEnergyAG += PEreadDynamicEnergyAG;
-
-		*bufferLatency += PEbufferLatency;
-		*bufferDynamicEnergy += PEbufferDynamicEnergy;
-		*icLatency += PEicLatency;
-		*icDynamicEnergy += PEicDynamicEnergy;
-
-		*coreLatencyADC += peLatencyADC;
-		*coreLatencyAccum += peLatencyAccum;
-		*coreLatencyOther += peLatencyOther;
-
-		*coreEnergyADC += peEnergyADC;
-		*coreEnergyAccum += peEnergyAccum;
-		*coreEnergyOther += peEnergyOther;
-		//其他的延迟和能耗暂时不考虑
-
-		
-
-		//linear layer
-		//线性层需要将d_v*n_heads 映射到 d_model
-		weightMatrixRow = param->d_model;
-		weightMatrixCol = param->d_v*param->n_heads*param->synapseBit;
-		pEMemory = generateRandomWeightMatrix(weightMatrixRow,weightMatrixCol);
-		numInVector = seq_len; 
-		pEInput = generateOnesMatrix(weightMatrixRow,seq_len);
-		ProcessingUnitCalculatePerformance(subArrayInPE, tech, cell, layerNumber, false, true, 0, pEMemory, pEMemoryOld, pEInput, 0, 0, 
-											numSubArrayRow, numSubArrayCol, weightMatrixRow, weightMatrixCol, numInVector, &PEreadLatency, &PEreadDynamicEnergy, &PEleakage,
-											&PEreadLatencyAG, &PEreadDynamicEnergyAG, &PEwriteLatencyWU, &PEwriteDynamicEnergyWU,
-											&PEbufferLatency, &PEbufferDynamicEnergy, &PEicLatency, &PEicDynamicEnergy,
-											&peLatencyADC, &peLatencyAccum, &peLatencyOther, &peEnergyADC, &peEnergyAccum, &peEnergyOther, 
-											&peReadLatencyPeakFW, &peReadDynamicEnergyPeakFW, &peReadLatencyPeakAG, &peReadDynamicEnergyPeakAG,
-											&peWriteLatencyPeakWU, &peWriteDynamicEnergyPeakWU);
-		
-		*readLatency += PEreadLatency; //由于每个pe之间是串行执行的 乘2由于Wq和Wk大小相同
-		*readDynamicEnergy += PEreadDynamicEnergy;
-		*readLatencyAG += PEreadLatencyAG;
-		*readDynamicEnergyAG += PEreadDynamicEnergyAG;
-
-		*bufferLatency += PEbufferLatency;
-		*bufferDynamicEnergy += PEbufferDynamicEnergy;
-		*icLatency += PEicLatency;
-		*icDynamicEnergy += PEicDynamicEnergy;
-
-		*coreLatencyADC += peLatencyADC;
-		*coreLatencyAccum += peLatencyAccum;
-		*coreLatencyOther += peLatencyOther;
-
-		*coreEnergyADC += peEnergyADC;
-		*coreEnergyAccum += peEnergyAccum;
-		*coreEnergyOther += peEnergyOther;
-		//其他的延迟和能耗暂时不考虑
-
-		//FFN1层 为 d_model*d_hidden
-		weightMatrixRow = param->d_hidden;
-		weightMatrixCol = param->d_model*param->synapseBit;
-		pEMemory = generateRandomWeightMatrix(weightMatrixRow,weightMatrixCol);
-		numInVector = seq_len; 
-		pEInput = generateOnesMatrix(weightMatrixRow,seq_len);
-		ProcessingUnitCalculatePerformance(subArrayInPE, tech, cell, layerNumber, false, true, 0, pEMemory, pEMemoryOld, pEInput, 0, 0, 
-											numSubArrayRow, numSubArrayCol, weightMatrixRow, weightMatrixCol, numInVector, &PEreadLatency, &PEreadDynamicEnergy, &PEleakage,
-											&PEreadLatencyAG, &PEreadDynamicEnergyAG, &PEwriteLatencyWU, &PEwriteDynamicEnergyWU,
-											&PEbufferLatency, &PEbufferDynamicEnergy, &PEicLatency, &PEicDynamicEnergy,
-											&peLatencyADC, &peLatencyAccum, &peLatencyOther, &peEnergyADC, &peEnergyAccum, &peEnergyOther, 
-											&peReadLatencyPeakFW, &peReadDynamicEnergyPeakFW, &peReadLatencyPeakAG, &peReadDynamicEnergyPeakAG,
-											&peWriteLatencyPeakWU, &peWriteDynamicEnergyPeakWU);
+		AccumulatePEPerformance(DigitalPECalculatePerformance(param->d_v*param->n_heads, seq_len_total*param->synapseBit, 3, seq_len, layerNumber, numSubArrayRow, numSubArrayCol, context), 1,
+								readLatency, readDynamicEnergy, readLatencyAG, readDynamicEnergyAG, bufferLatency, bufferDynamicEnergy, icLatency, icDynamicEnergy,
+								coreLatencyADC, coreLatencyAccum, coreLatencyOther, coreEnergyADC, coreEnergyAccum, coreEnergyOther);
 		
-		*readLatency += PEreadLatency; //由于每个pe之间是串行执行的 乘2由于Wq和Wk大小相同
-		*readDynamicEnergy += PEreadDynamicEnergy;
-		*readLatencyAG += PEreadLatencyAG;
-		*readDynamicEnergyAG += PEreadDynamicEnergyAG;
-
-		*bufferLatency += PEbufferLatency;
-		*bufferDynamicEnergy += PEbufferDynamicEnergy;
-		*icLatency += PEicLatency;
-		*icDynamicEnergy += PEicDynamicEnergy;
-
-		*coreLatencyADC += peLatencyADC;
-		*coreLatencyAccum += peLatencyAccum;
-		*coreLatencyOther += peLatencyOther;
-
-		*coreEnergyADC += peEnergyADC;
-		*coreEnergyAccum += peEnergyAccum;
-		*coreEnergyOther += peEnergyOther;
-		//其他的延迟和能耗暂时不考虑
-
-		//FFN2层 为 d_hidden*d_model
-		weightMatrixRow = param->d_model;
-		weightMatrixCol = param->d_hidden*param->synapseBit;
-		pEMemory = generateRandomWeightMatrix(weightMatrixRow,weightMatrixCol);
-		numInVector = seq_len; 
-		pEInput = generateOnesMatrix(weightMatrixRow,seq_len);
-		ProcessingUnitCalculatePerformance(subArrayInPE, tech, cell, layerNumber, false, true, 0, pEMemory, pEMemoryOld, pEInput, 0, 0, 
-											numSubArrayRow, numSubArrayCol, weightMatrixRow, weightMatrixCol, numInVector, &PEreadLatency, &PEreadDynamicEnergy, &PEleakage,
-											&PEreadLatencyAG, &PEreadDynamicEnergyAG, &PEwriteLatencyWU, &PEwriteDynamicEnergyWU,
-											&PEbufferLatency, &PEbufferDynamicEnergy, &PEicLatency, &PEicDynamicEnergy,
-											&peLatencyADC, &peLatencyAccum, &peLatencyOther, &peEnergyADC, &peEnergyAccum, &peEnergyOther, 
-											&peReadLatencyPeakFW, &peReadDynamicEnergyPeakFW, &peReadLatencyPeakAG, &peReadDynamicEnergyPeakAG,
-											&peWriteLatencyPeakWU, &peWriteDynamicEnergyPeakWU);
-		
-		*readLatency += PEreadLatency; //由于每个pe之间是串行执行的 乘2由于Wq和Wk大小相同
-		*readDynamicEnergy += PEreadDynamicEnergy;
-		*readLatencyAG += PEreadLatencyAG;
-		*readDynamicEnergyAG += PEreadDynamicEnergyAG;
-
-		*bufferLatency += PEbufferLatency;
-		*bufferDynamicEnergy += PEbufferDynamicEnergy;
-		*icLatency += PEicLatency;
-		*icDynamicEnergy += PEicDynamicEnergy;
-
-		*coreLatencyADC += peLatencyADC;
-		*coreLatencyAccum += peLatencyAccum;
-		*coreLatencyOther += peLatencyOther;
-
-		*coreEnergyADC += peEnergyADC;
-		*coreEnergyAccum += peEnergyAccum;
-		*coreEnergyOther += peEnergyOther;
+		for (int i=1; i<staticPE.size(); i++) {	// linear、FFN1、FFN2
+			AccumulatePEPerformance(staticPE[i], 1, readLatency, readDynamicEnergy, readLatencyAG, readDynamicEnergyAG, bufferLatency, bufferDynamicEnergy, icLatency, icDynamicEnergy,
+									coreLatencyADC, coreLatencyAccum, coreLatencyOther, coreEnergyADC, coreEnergyAccum, coreEnergyOther);
+		}
 		//其他的延迟和能耗暂时不考虑
 		
 		cout << "----------------- End PE Performance ------------------" <<  endl;
@@ -706,14 +548,14 @@ void TileCalculatePerformance(const vector<vector<double> > &newMemory, const ve
 			if ((speedUpRow >= numPE) && (speedUpCol >= numPE)) {
 				// duplication in PE or subArray --> tell each PE to take the whole assigned weight  --> "fully" duplication
 				// assign weight and input to specific tile
-				vector<vector<double> > pEMemoryOld;
+				MatrixView pEMemoryOld;
 				pEMemoryOld = CopyPEArray(oldMemory, 0, 0, weightMatrixRow, weightMatrixCol);
-				vector<vector<double> > pEMemory;
+				MatrixView pEMemory;
 				pEMemory = CopyPEArray(newMemory, 0, 0, weightMatrixRow, weightMatrixCol);
-				vector<vector<double> > pEInput;
+				BitMatrixView pEInput;
 				pEInput = CopyPEInput(inputVector, 0, numInVector, weightMatrixRow);
 				
-				ProcessingUnitCalculatePerformance(subArrayInPE, tech, cell, layerNumber, false, false, 0, pEMemory, pEMemoryOld, pEInput, ceil((double)speedUpRow/(double)numPE), ceil((double)speedUpCol/(double)numPE), 
+				ProcessingUnitCalculatePerformance(subArrayInPE, context, layerNumber, false, false, 0, pEMemory, pEMemoryOld, pEInput, NULL, ceil((double)speedUpRow/(double)numPE), ceil((double)speedUpCol/(double)numPE), 
 											numSubArrayRow, numSubArrayCol, weightMatrixRow, weightMatrixCol, numInVector, &PEreadLatency, &PEreadDynamicEnergy, &PEleakage,
 											&PEreadLatencyAG, &PEreadDynamicEnergyAG, &PEwriteLatencyWU, &PEwriteDynamicEnergyWU,
 											&PEbufferLatency, &PEbufferDynamicEnergy, &PEicLatency, &PEicDynamicEnergy,
@@ -758,14 +600,14 @@ void TileCalculatePerformance(const vector<vector<double> > &newMemory, const ve
 							int numColMatrix = min(peSize, (double) weightMatrixCol-j*peSize);
 					
 							// assign weight and input to specific tile
-							vector<vector<double> > pEMemoryOld;
+							MatrixView pEMemoryOld;
 							pEMemoryOld = CopyPEArray(oldMemory, i*peSize, j*peSize, numRowMatrix, numColMatrix);
-							vector<vector<double> > pEMemory;
+							MatrixView pEMemory;
 							pEMemory = CopyPEArray(newMemory, i*peSize, j*peSize, numRowMatrix, numColMatrix);
-							vector<vector<double> > pEInput;
+							BitMatrixView pEInput;
 							pEInput = CopyPEInput(inputVector, i*peSize, numInVector, numRowMatrix);
 							
-							ProcessingUnitCalculatePerformance(subArrayInPE, tech, cell, layerNumber, false, false, 0, pEMemory, pEMemoryOld, pEInput, 1, 1, 
+							ProcessingUnitCalculatePerformance(subArrayInPE, context, layerNumber, false, false, 0, pEMemory, pEMemoryOld, pEInput, NULL, 1, 1, 
 												numSubArrayRow, numSubArrayCol, numRowMatrix, numColMatrix, numInVector, &PEreadLatency, &PEreadDynamicEnergy, &PEleakage,
 												&PEreadLatencyAG, &PEreadDynamicEnergyAG, &PEwriteLatencyWU, &PEwriteDynamicEnergyWU,
 												&PEbufferLatency, &PEbufferDynamicEnergy, &PEicLatency, &PEicDynamicEnergy,
@@ -844,14 +686,14 @@ void TileCalculatePerformance(const vector<vector<double> > &newMemory, const ve
 						int numRowMatrix = min(peSize, (double) weightMatrixRow-i*peSize);
 						int numColMatrix = min(peSize, (double) weightMatrixCol-j*peSize);
 						
-						vector<vector<double> > pEMemoryOld;
+						MatrixView pEMemoryOld;
 						pEMemoryOld = CopyPEArray(oldMemory, i*peSize, j*peSize, numRowMatrix, numColMatrix);
-						vector<vector<double> > pEMemory;
+						MatrixView pEMemory;
 						pEMemory = CopyPEArray(newMemory, i*peSize, j*peSize, numRowMatrix, numColMatrix);
-						vector<vector<double> > pEInput;
+						BitMatrixView pEInput;
 						pEInput = CopyPEInput(inputVector, i*peSize, numInVector, numRowMatrix);
 							
-						ProcessingUnitCalculatePerformance(subArrayInPE, tech, cell, layerNumber, false, false, 0, pEMemory, pEMemoryOld, pEInput, 1, 1, numSubArrayRow, numSubArrayCol, numRowMatrix,
+						ProcessingUnitCalculatePerformance(subArrayInPE, context, layerNumber, false, false, 0, pEMemory, pEMemoryOld, pEInput, NULL, 1, 1, numSubArrayRow, numSubArrayCol, numRowMatrix,
 												numColMatrix, numInVector, &PEreadLatency, &PEreadDynamicEnergy, &PEleakage,
 												&PEreadLatencyAG, &PEreadDynamicEnergyAG, &PEwriteLatencyWU, &PEwriteDynamicEnergyWU,
 												&PEbufferLatency, &PEbufferDynamicEnergy, &PEicLatency, &PEicDynamicEnergy,
@@ -1002,15 +844,15 @@ void TileCalculatePerformance(const vector<vector<double> > &newMemory, const ve
 	} else {  // novel Mapping
 		for (int i=0; i<numPE; i++) {
 			int location = i*MIN(peSize, (int) weightMatrixRow/numPE);
-			vector<vector<double> > pEMemoryOld;
+			MatrixView pEMemoryOld;
 			pEMemoryOld = CopyPEArray(oldMemory, location, 0, (int)(weightMatrixRow/numPE), weightMatrixCol);
 			
-			vector<vector<double> > pEMemory;
+			MatrixView pEMemory;
 			pEMemory = CopyPEArray(newMemory, location, 0, (int)(weightMatrixRow/numPE), weightMatrixCol);
-			vector<vector<double> > pEInput;
+			BitMatrixView pEInput;
 			pEInput = CopyPEInput(inputVector, location, numInVector, weightMatrixRow/numPE);
 			
-			ProcessingUnitCalculatePerformance(subArrayInPE, tech, cell, layerNumber, true, false, 0, pEMemory, pEMemoryOld, pEInput, 1, 1, numSubArrayRow, numSubArrayCol, weightMatrixRow/numPE,
+			ProcessingUnitCalculatePerformance(subArrayInPE, context, layerNumber, true, false, 0, pEMemory, pEMemoryOld, pEInput, NULL, 1, 1, numSubArrayRow, numSubArrayCol, weightMatrixRow/numPE,
 									weightMatrixCol, numInVector, &PEreadLatency, &PEreadDynamicEnergy, &PEleakage,
 									&PEreadLatencyAG, &PEreadDynamicEnergyAG, &PEwriteLatencyWU, &PEwriteDynamicEnergyWU,
 									&PEbufferLatency, &PEbufferDynamicEnergy, &PEicLatency, &PEicDynamicEnergy, 
@@ -1172,70 +1014,147 @@ void TileCalculatePerformance(const vector<vector<double> > &newMemory, const ve
 }
 
 
-vector<vector<double> > CopyPEArray(const vector<vector<double> > &orginal, int positionRow, int positionCol, int numRow, int numCol) {
-	
-	vector<vector<double> > copy;
-	for (int i=0; i<numRow; i++) {
-		vector<double> copyRow;
-		for (int j=0; j<numCol; j++) {
-			copyRow.push_back(orginal[positionRow+i][positionCol+j]);
-		}
-		copy.push_back(copyRow);
-		copyRow.clear();
-	}
-	return copy;
-	copy.clear();
-} 
+TileComponents TileGetComponents() {
+	TileComponents components;
+	components.subArrayInPE = subArrayInPE;
+	components.inputBufferCM = inputBufferCM;
+	components.outputBufferCM = outputBufferCM;
+	components.hTreeCM = hTreeCM;
+	components.accumulationCM = accumulationCM;
+	components.sigmoidCM = sigmoidCM;
+	components.reLuCM = reLuCM;
+	components.inputBufferNM = inputBufferNM;
+	components.outputBufferNM = outputBufferNM;
+	components.hTreeNM = hTreeNM;
+	components.accumulationNM = accumulationNM;
+	components.sigmoidNM = sigmoidNM;
+	components.reLuNM = reLuNM;
+	components.numInBufferCore = numInBufferCore;
+	components.numOutBufferCore = numOutBufferCore;
+	components.staticPECache = staticPECache;
+	components.processingUnit = ProcessingUnitGetComponents();
+	return components;
+}
 
 
-vector<vector<double> > CopyPEInput(const vector<vector<double> > &orginal, int positionRow, int numInputVector, int numRow) {
-	vector<vector<double> > copy;
-	for (int i=0; i<numRow; i++) {
-		vector<double> copyRow;
-		for (int j=0; j<numInputVector; j++) {
-			copyRow.push_back(orginal[positionRow+i][j]);
-		}
-		copy.push_back(copyRow);
-		copyRow.clear();
-	}
-	return copy;
-	copy.clear();
+TileComponents TileCopyComponents(const TileComponents &original) {
+	TileComponents components;
+	components.subArrayInPE = new SubArray(*original.subArrayInPE);
+	components.inputBufferCM = new Buffer(*original.inputBufferCM);
+	components.outputBufferCM = new Buffer(*original.outputBufferCM);
+	components.hTreeCM = new HTree(*original.hTreeCM);
+	components.accumulationCM = new AdderTree(*original.accumulationCM);
+	components.sigmoidCM = original.sigmoidCM? new Sigmoid(*original.sigmoidCM) : NULL;
+	components.reLuCM = original.reLuCM? new BitShifter(*original.reLuCM) : NULL;
+	components.inputBufferNM = new Buffer(*original.inputBufferNM);
+	components.outputBufferNM = new Buffer(*original.outputBufferNM);
+	components.hTreeNM = new HTree(*original.hTreeNM);
+	components.accumulationNM = new AdderTree(*original.accumulationNM);
+	components.sigmoidNM = original.sigmoidNM? new Sigmoid(*original.sigmoidNM) : NULL;
+	components.reLuNM = original.reLuNM? new BitShifter(*original.reLuNM) : NULL;
+	components.numInBufferCore = original.numInBufferCore;
+	components.numOutBufferCore = original.numOutBufferCore;
+	components.staticPECache = new map<int, vector<PEPerformance> >(*original.staticPECache);
+	components.processingUnit = ProcessingUnitCopyComponents(original.processingUnit);
+	return components;
 }
 
-std::vector<std::vector<int>> generateRandomMatrix(int rows, int cols) {
-    std::random_device rd;  // 用于获取随机种子
-    std::mt19937 gen(rd()); // 标准 mersenne_twister_engine
-    std::uniform_int_distribution<> dis(0, 1); // 生成0或1的均匀分布
 
-    std::vector<std::vector<int>> matrix(rows, std::vector<int>(cols));
+void TileSetComponents(const TileComponents &components) {
+	subArrayInPE = components.subArrayInPE;
+	inputBufferCM = components.inputBufferCM;
+	outputBufferCM = components.outputBufferCM;
+	hTreeCM = components.hTreeCM;
+	accumulationCM = components.accumulationCM;
+	sigmoidCM = components.sigmoidCM;
+	reLuCM = components.reLuCM;
+	inputBufferNM = components.inputBufferNM;
+	outputBufferNM = components.outputBufferNM;
+	hTreeNM = components.hTreeNM;
+	accumulationNM = components.accumulationNM;
+	sigmoidNM = components.sigmoidNM;
+	reLuNM = components.reLuNM;
+	numInBufferCore = components.numInBufferCore;
+	numOutBufferCore = components.numOutBufferCore;
+	staticPECache = components.staticPECache;
+	ProcessingUnitSetComponents(components.processingUnit);
+}
 
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            matrix[i][j] = dis(gen); // 生成随机0或1
-        }
-    }
 
-    return matrix;
+void TileDeleteComponents(TileComponents &components) {
+	delete components.subArrayInPE;
+	delete components.inputBufferCM;
+	delete components.outputBufferCM;
+	delete components.hTreeCM;
+	delete components.accumulationCM;
+	delete components.sigmoidCM;
+	delete components.reLuCM;
+	delete components.inputBufferNM;
+	delete components.outputBufferNM;
+	delete components.hTreeNM;
+	delete components.accumulationNM;
+	delete components.sigmoidNM;
+	delete components.reLuNM;
+	delete components.staticPECache;
+	ProcessingUnitDeleteComponents(components.processingUnit);
 }
 
-std::vector<std::vector<double>> generateRandomWeightMatrix(int rows, int cols){
-	vector<vector<int>> bitMatrix = generateRandomMatrix(rows,cols);
-	vector<vector<double>> weightMatrix(rows,vector<double>(cols));
-	for(int i =0; i<bitMatrix.size();i++){
-		for(int j =0; j<bitMatrix[0].size();j++){
-			if(bitMatrix[i][j] == 1){
-				weightMatrix[i][j] = param->maxConductance;
-			}
-			else{
-				weightMatrix[i][j] = param->minConductance;
-			}
-		}
-	}
-	return weightMatrix;
+
+PEPerformance DigitalPECalculatePerformance(int weightMatrixRow, int weightMatrixCol, unsigned int seed, int seq_len, int layerNumber, int numSubArrayRow, int numSubArrayCol, SimulationContext& context) {
+	PEPerformance pe;
+	double leakage, readLatencyPeakFW, readDynamicEnergyPeakFW, readLatencyPeakAG, readDynamicEnergyPeakAG, writeLatencyPeakWU, writeDynamicEnergyPeakWU;
+	double writeLatencyWU, writeDynamicEnergyWU;
+	
+	MatrixView pEMemoryOld; //无数据
+	MatrixView pEMemory; //无数据，权重由WeightOperand按需生成
+	WeightOperand weight(weightMatrixRow, weightMatrixCol, seed); //由于无法获取处理过程中的实际权重矩阵，因此采用固定种子的随机方式生成
+	BitMatrix pEInput; // fake input，此处的物理意义并不是输入，而是代表矩阵读出时激活的行数 ，用于适配其中的mux的功耗计算。 input直接设置为一个全1的列，行数与权重行相对应，列数与输入token数相对应
+	pEInput = generateOnesMatrix(weightMatrixRow, seq_len);
+	ProcessingUnitCalculatePerformance(subArrayInPE, context, layerNumber, false, true, 0, pEMemory, pEMemoryOld, pEInput, &weight, 0, 0, 
+										numSubArrayRow, numSubArrayCol, weightMatrixRow, weightMatrixCol, seq_len, &pe.readLatency, &pe.readDynamicEnergy, &leakage,
+										&pe.readLatencyAG, &pe.readDynamicEnergyAG, &writeLatencyWU, &writeDynamicEnergyWU,
+										&pe.bufferLatency, &pe.bufferDynamicEnergy, &pe.icLatency, &pe.icDynamicEnergy,
+										&pe.coreLatencyADC, &pe.coreLatencyAccum, &pe.coreLatencyOther, &pe.coreEnergyADC, &pe.coreEnergyAccum, &pe.coreEnergyOther, 
+										&readLatencyPeakFW, &readDynamicEnergyPeakFW, &readLatencyPeakAG, &readDynamicEnergyPeakAG,
+										&writeLatencyPeakWU, &writeDynamicEnergyPeakWU);
+	return pe;
+}
+
+
+void AccumulatePEPerformance(const PEPerformance &pe, int numPE, double *readLatency, double *readDynamicEnergy, double *readLatencyAG, double *readDynamicEnergyAG,
+							double *bufferLatency, double *bufferDynamicEnergy, double *icLatency, double *icDynamicEnergy,
+							double *coreLatencyADC, double *coreLatencyAccum, double *coreLatencyOther, double *coreEnergyADC, double *coreEnergyAccum, double *coreEnergyOther) {
+	// numPE个相同的PE并行执行：延迟只计一次，能耗乘以numPE
+	*readLatency += pe.readLatency;
+	*readDynamicEnergy += pe.readDynamicEnergy*numPE;
+	*readLatencyAG += pe.readLatencyAG;
+	*readDynamicEnergyAG += pe.readDynamicEnergyAG*numPE;
+
+	*bufferLatency += pe.bufferLatency;
+	*bufferDynamicEnergy += pe.bufferDynamicEnergy*numPE;
+	*icLatency += pe.icLatency;
+	*icDynamicEnergy += pe.icDynamicEnergy*numPE;
+
+	*coreLatencyADC += pe.coreLatencyADC;
+	*coreLatencyAccum += pe.coreLatencyAccum;
+	*coreLatencyOther += pe.coreLatencyOther;
+
+	*coreEnergyADC += pe.coreEnergyADC*numPE;
+	*coreEnergyAccum += pe.coreEnergyAccum*numPE;
+	*coreEnergyOther += pe.coreEnergyOther*numPE;
+}
+
+
+MatrixView CopyPEArray(const MatrixView &orginal, int positionRow, int positionCol, int numRow, int numCol) {
+	return orginal.SubView(positionRow, positionCol, numRow, numCol);
+} 
+
+
+BitMatrixView CopyPEInput(const BitMatrixView &orginal, int positionRow, int numInputVector, int numRow) {
+	return orginal.SubView(positionRow, 0, numRow, numInputVector);
 }
 
-std::vector<std::vector<double>> generateOnesMatrix(int rows, int cols) {
+BitMatrix generateOnesMatrix(int rows, int cols) {
     // 初始化一个大小为 rows x cols 的矩阵，所有元素为1
-    std::vector<std::vector<double>> matrix(rows, std::vector<double>(cols, 1));
-    return matrix;
+    return BitMatrix(rows, cols, true);
 }
\ No newline at end of file
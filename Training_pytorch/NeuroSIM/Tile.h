@@ -48,26 +48,63 @@
 #include "InputParameter.h"
 #include "Technology.h"
 #include "MemCell.h"
+#include "SubArray.h"
+#include "Buffer.h"
+#include "HTree.h"
+#include "AdderTree.h"
+#include "Sigmoid.h"
+#include "BitShifter.h"
+#include "ProcessingUnit.h"
+#include "Matrix.h"
+#include "BitMatrix.h"
 
 using namespace std;
 
+class SimulationContext;
+
+// 数字计算模式下单个PE的评估结果
+struct PEPerformance {
+	double readLatency, readDynamicEnergy, readLatencyAG, readDynamicEnergyAG;
+	double bufferLatency, bufferDynamicEnergy, icLatency, icDynamicEnergy;
+	double coreLatencyADC, coreLatencyAccum, coreLatencyOther, coreEnergyADC, coreEnergyAccum, coreEnergyOther;
+};
+
+// Tile（以及其中PE）的模块实例，由SimulationContext持有
+struct TileComponents {
+	SubArray *subArrayInPE;
+	Buffer *inputBufferCM, *outputBufferCM, *inputBufferNM, *outputBufferNM;
+	HTree *hTreeCM, *hTreeNM;
+	AdderTree *accumulationCM, *accumulationNM;
+	Sigmoid *sigmoidCM, *sigmoidNM;
+	BitShifter *reLuCM, *reLuNM;
+	int numInBufferCore, numOutBufferCore;
+	map<int, vector<PEPerformance> > *staticPECache;
+	ProcessingUnitComponents processingUnit;
+};
+
 /*** Functions ***/
 void TileInitialize(InputParameter& inputParameter, Technology& tech, MemCell& cell, double _numPENM, double _peSizeNM, double _numPECM, double _peSizeCM, bool digital);
 vector<double> TileCalculateArea(double numPE, double peSize, bool NMTile, double *height, double *width); //暂时不进行tile面积的计算
-void TileCalculatePerformance(const vector<vector<double> > &newMemory, const vector<vector<double> > &oldMemory, const vector<vector<double> > &inputVector, 
+void TileCalculatePerformance(const MatrixView &newMemory, const MatrixView &oldMemory, const BitMatrixView &inputVector, 
 			int novelMap,bool digital , int seq_len, int seq_len_total, int layerNumber, double numPE, double peSize, //使用digital标志位表示使用数字计算的block，实际上可以添加控制位以支持其他类型的网络，目前只支持transformer  //使用seq_len_total来表示当前的序列总长度，由于tile内部对延迟和能耗的评估只与每一次的序列长度相关
 			int speedUpRow, int speedUpCol, int weightMatrixRow, int weightMatrixCol, int numInVector,  //在这里的控制策略， inputVector代表当前批次的输入token个数，用seq_len_total表示当前已生成的token总数
-			Technology& tech, MemCell& cell, double *readLatency, double *readDynamicEnergy, double *leakage,
+			SimulationContext& context, double *readLatency, double *readDynamicEnergy, double *leakage,
 			double *readLatencyAG, double *readDynamicEnergyAG, double *writeLatencyWU, double *writeDynamicEnergyWU,
 			double *bufferLatency, double *bufferDynamicEnergy, double *icLatency, double *icDynamicEnergy,
 			double *coreLatencyADC, double *coreLatencyAccum, double *coreLatencyOther, double *coreEnergyADC, 
 			double *coreEnergyAccum, double *coreEnergyOther, double *readLatencyPeakFW, double *readDynamicEnergyPeakFW,
 			double *readLatencyPeakAG, double *readDynamicEnergyPeakAG, double *writeLatencyPeakWU, double *writeDynamicEnergyPeakWU);
 		
-vector<vector<double> > CopyPEArray(const vector<vector<double> > &orginal, int positionRow, int positionCol, int numRow, int numCol);
-vector<vector<double> > CopyPEInput(const vector<vector<double> > &orginal, int positionRow, int numInputVector, int numRow);
-std::vector<std::vector<int>> generateRandomMatrix(int rows, int cols);
-std::vector<std::vector<double>> generateRandomWeightMatrix(int rows, int cols);
-std::vector<std::vector<double>> generateOnesMatrix(int rows, int cols);
+TileComponents TileGetComponents();		// 当前线程的模块实例
+TileComponents TileCopyComponents(const TileComponents &original);
+void TileSetComponents(const TileComponents &components);	// 当前线程改为使用给定的模块实例
+void TileDeleteComponents(TileComponents &components);
+PEPerformance DigitalPECalculatePerformance(int weightMatrixRow, int weightMatrixCol, unsigned int seed, int seq_len, int layerNumber, int numSubArrayRow, int numSubArrayCol, SimulationContext& context);
+void AccumulatePEPerformance(const PEPerformance &pe, int numPE, double *readLatency, double *readDynamicEnergy, double *readLatencyAG, double *readDynamicEnergyAG,
+			double *bufferLatency, double *bufferDynamicEnergy, double *icLatency, double *icDynamicEnergy,
+			double *coreLatencyADC, double *coreLatencyAccum, double *coreLatencyOther, double *coreEnergyADC, double *coreEnergyAccum, double *coreEnergyOther);
+MatrixView CopyPEArray(const MatrixView &orginal, int positionRow, int positionCol, int numRow, int numCol);
+BitMatrixView CopyPEInput(const BitMatrixView &orginal, int positionRow, int numInputVector, int numRow);
+BitMatrix generateOnesMatrix(int rows, int cols);
 
 #endif /* TILE_H_ */
\ No newline at end of file
@@ -0,0 +1,182 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <omp.h>
+#include "formula.h"
+#include "Param.h"
+#include "SimulationContext.h"
+#include "TokenSweep.h"
+
+using namespace std;
+
+double GetTokenComputation(int seq_len, int seq_len_total) {
+	double numComputation = 0;
+	numComputation += (double)seq_len*param->d_k*param->n_heads*param->d_model*2; //WQ
+	numComputation += (double)seq_len*param->d_k*param->n_heads*param->d_model*2; //WK
+	numComputation += (double)seq_len*param->d_v*param->n_heads*param->d_model*2; //WV
+	numComputation += (double)seq_len*seq_len_total*param->d_k*param->n_heads*2;    //K cache
+	numComputation += (double)seq_len*seq_len_total*param->d_v*param->n_heads*2;    //V cache
+	numComputation += (double)seq_len*param->d_model*param->d_v*param->n_heads*2;   //Linear
+	numComputation += (double)seq_len*param->d_hidden*param->d_model*2; 			//FFN1
+	numComputation += (double)seq_len*param->d_model*param->d_hidden*2; 			//FFN2
+	return numComputation;
+}
+
+// 自回归阶段每个token的结果只通过K缓存矩阵的行数(seq_len_total)和V缓存矩阵的列数(seq_len_total*synapseBit)与seq_len_total相关，
+// 在subArray的划分（以及V缓存后adderTree的输入个数）不变的区间内近似线性，因此只需要完整评估每个区间的两端
+vector<int> GetFastSweepBreakpoints(int firstToken, int lastToken) {
+	vector<int> breakpoints;
+	for (int t=firstToken; t<=lastToken; t++) {
+		bool tilingChanged = (t == firstToken) || (t == lastToken)
+							|| ceil((double)t/param->numRowSubArray) != ceil((double)(t-1)/param->numRowSubArray)
+							|| ceil((double)t*param->synapseBit/param->numColSubArray) != ceil((double)(t-1)*param->synapseBit/param->numColSubArray)
+							|| ceil((double)t*param->synapseBit/param->numRowSubArray) != ceil((double)(t-1)*param->synapseBit/param->numRowSubArray);
+		if (tilingChanged) {
+			if (t > firstToken && breakpoints.back() != t-1) {
+				breakpoints.push_back(t-1);	// 上一个区间的结尾
+			}
+			breakpoints.push_back(t);
+		}
+	}
+	return breakpoints;
+}
+
+static double TokenPerformance::* const tokenPerformanceFields[] = {
+	&TokenPerformance::readLatency, &TokenPerformance::readDynamicEnergy, &TokenPerformance::leakage, &TokenPerformance::readLatencyAG, &TokenPerformance::readDynamicEnergyAG,
+	&TokenPerformance::readLatencyWG, &TokenPerformance::readDynamicEnergyWG, &TokenPerformance::writeLatencyWU, &TokenPerformance::writeDynamicEnergyWU,
+	&TokenPerformance::bufferLatency, &TokenPerformance::bufferDynamicEnergy, &TokenPerformance::icLatency, &TokenPerformance::icDynamicEnergy,
+	&TokenPerformance::coreLatencyADC, &TokenPerformance::coreLatencyAccum, &TokenPerformance::coreLatencyOther,
+	&TokenPerformance::coreEnergyADC, &TokenPerformance::coreEnergyAccum, &TokenPerformance::coreEnergyOther,
+	&TokenPerformance::DRAMLatency, &TokenPerformance::DRAMDynamicEnergy,
+	&TokenPerformance::readLatencyPeakFW, &TokenPerformance::readDynamicEnergyPeakFW, &TokenPerformance::readLatencyPeakAG, &TokenPerformance::readDynamicEnergyPeakAG,
+	&TokenPerformance::readLatencyPeakWG, &TokenPerformance::readDynamicEnergyPeakWG, &TokenPerformance::writeLatencyPeakWU, &TokenPerformance::writeDynamicEnergyPeakWU
+};
+static const int numTokenPerformanceFields = sizeof(tokenPerformanceFields)/sizeof(tokenPerformanceFields[0]);
+
+TokenPerformance InterpolateTokenPerformance(const TokenPerformance &start, const TokenPerformance &end, double ratio) {
+	TokenPerformance token;
+	for (int i=0; i<numTokenPerformanceFields; i++) {
+		token.*tokenPerformanceFields[i] = start.*tokenPerformanceFields[i] + (end.*tokenPerformanceFields[i] - start.*tokenPerformanceFields[i])*ratio;
+	}
+	return token;
+}
+
+double GetTokenPerformanceError(const TokenPerformance &estimated, const TokenPerformance &simulated) {
+	double maxRelativeError = 0;
+	for (int i=0; i<numTokenPerformanceFields; i++) {
+		if (simulated.*tokenPerformanceFields[i] != 0) {
+			maxRelativeError = MAX(maxRelativeError, fabs(estimated.*tokenPerformanceFields[i] - simulated.*tokenPerformanceFields[i])/fabs(simulated.*tokenPerformanceFields[i]));
+		}
+	}
+	return maxRelativeError;
+}
+
+
+vector<TokenPerformance> CalculateTokensPerformance(SimulationContext &context, vector<SimulationContext *> *threadContexts, const vector<int> &tokens, const TokenEvaluator &evaluate) {
+	vector<TokenPerformance> results(tokens.size());
+	int numThread = MAX(MIN(omp_get_max_threads(), (int)tokens.size()), 1);
+	while (threadContexts->size() < numThread-1) {
+		threadContexts->push_back(context.Fork());
+	}
+	#pragma omp parallel num_threads(numThread)
+	{
+		int thread = omp_get_thread_num();
+		SimulationContext &threadContext = (thread == 0)? context : *(*threadContexts)[thread-1];
+		#pragma omp for schedule(dynamic)
+		for (int i=0; i<(int)tokens.size(); i++) {
+			results[i] = evaluate(threadContext, 1, tokens[i]);
+		}
+	}
+	return results;
+}
+
+vector<TokenPerformance> CalculateDecodePerformance(SimulationContext &context, vector<SimulationContext *> *threadContexts, int firstToken, int lastToken, const TokenEvaluator &evaluate) {
+	vector<TokenPerformance> decodeTokens(MAX(lastToken-firstToken+1, 0));
+	if (param->fastSweep) {
+		// 只在K、V缓存矩阵的subArray划分改变的位置完整评估，其余的token在两端之间线性插值
+		vector<bool> simulated(decodeTokens.size(), false);
+		vector<int> breakpoints = GetFastSweepBreakpoints(firstToken, lastToken);
+		vector<TokenPerformance> breakpointTokens = CalculateTokensPerformance(context, threadContexts, breakpoints, evaluate);
+		for (int i=0; i<breakpoints.size(); i++) {
+			decodeTokens[breakpoints[i]-firstToken] = breakpointTokens[i];
+			simulated[breakpoints[i]-firstToken] = true;
+		}
+		vector<int> interpolated;
+		for (int i=0; i+1<breakpoints.size(); i++) {
+			for (int t=breakpoints[i]+1; t<breakpoints[i+1]; t++) {
+				double ratio = (double)(t-breakpoints[i])/(double)(breakpoints[i+1]-breakpoints[i]);
+				decodeTokens[t-firstToken] = InterpolateTokenPerformance(decodeTokens[breakpoints[i]-firstToken], decodeTokens[breakpoints[i+1]-firstToken], ratio);
+				interpolated.push_back(t);
+			}
+		}
+		// spot check: 在插值的token中均匀抽样，与完整评估的结果比较
+		int numSpotCheck = MIN(param->fastSweepSpotCheck, (int)interpolated.size());
+		vector<int> sampled;
+		for (int i=0; i<numSpotCheck; i++) {
+			sampled.push_back(interpolated[(long)(i+1)*interpolated.size()/(numSpotCheck+1)]);
+		}
+		vector<TokenPerformance> sampledTokens = CalculateTokensPerformance(context, threadContexts, sampled, evaluate);
+		double maxRelativeError = 0;
+		int maxErrorToken = 0;
+		for (int i=0; i<numSpotCheck; i++) {
+			int t = sampled[i];
+			const TokenPerformance &token = sampledTokens[i];
+			double relativeError = GetTokenPerformanceError(decodeTokens[t-firstToken], token);
+			if (relativeError >= maxRelativeError) {
+				maxRelativeError = relativeError;
+				maxErrorToken = t;
+			}
+			decodeTokens[t-firstToken] = token;
+		}
+		cout << "Fast sweep: " << breakpoints.size() << " of " << decodeTokens.size() << " tokens simulated, " << interpolated.size() << " interpolated" << endl;
+		if (numSpotCheck > 0) {
+			cout << "Fast sweep spot check: max relative error of " << numSpotCheck << " sampled tokens is " << maxRelativeError*100 << "% (seq_len_total=" << maxErrorToken << ")" << endl;
+		}
+	} else {
+		vector<int> tokens;
+		for (int t=firstToken; t<=lastToken; t++) {
+			tokens.push_back(t);
+		}
+		decodeTokens = CalculateTokensPerformance(context, threadContexts, tokens, evaluate);
+	}
+	return decodeTokens;
+}
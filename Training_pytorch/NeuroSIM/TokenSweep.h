@@ -0,0 +1,74 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+
+#ifndef TOKENSWEEP_H_
+#define TOKENSWEEP_H_
+
+#include <vector>
+#include <functional>
+
+using namespace std;
+
+class SimulationContext;
+
+// 数字计算模式下一次推理（prefill或者生成一个token）的评估结果
+struct TokenPerformance {
+	double readLatency, readDynamicEnergy, leakage, readLatencyAG, readDynamicEnergyAG, readLatencyWG, readDynamicEnergyWG, writeLatencyWU, writeDynamicEnergyWU;
+	double bufferLatency, bufferDynamicEnergy, icLatency, icDynamicEnergy;
+	double coreLatencyADC, coreLatencyAccum, coreLatencyOther, coreEnergyADC, coreEnergyAccum, coreEnergyOther;
+	double DRAMLatency, DRAMDynamicEnergy;
+	double readLatencyPeakFW, readDynamicEnergyPeakFW, readLatencyPeakAG, readDynamicEnergyPeakAG;
+	double readLatencyPeakWG, readDynamicEnergyPeakWG, writeLatencyPeakWU, writeDynamicEnergyPeakWU;
+};
+
+// 在给定的context上评估一次推理，结果只与seq_len和seq_len_total有关
+typedef function<TokenPerformance(SimulationContext &context, int seq_len, int seq_len_total)> TokenEvaluator;
+
+double GetTokenComputation(int seq_len, int seq_len_total);
+vector<int> GetFastSweepBreakpoints(int firstToken, int lastToken);
+TokenPerformance InterpolateTokenPerformance(const TokenPerformance &start, const TokenPerformance &end, double ratio);
+double GetTokenPerformanceError(const TokenPerformance &estimated, const TokenPerformance &simulated);
+
+// 用OpenMP并行评估一组token，主线程使用context，其他线程使用threadContexts中由context复制出的模块实例（不够时补充，由调用者释放）
+// 结果按tokens中的顺序返回，因此与线程数无关
+vector<TokenPerformance> CalculateTokensPerformance(SimulationContext &context, vector<SimulationContext *> *threadContexts, const vector<int> &tokens, const TokenEvaluator &evaluate);
+// 自回归阶段第firstToken..lastToken个token（seq_len_total）的结果，param->fastSweep时只完整评估subArray划分改变的位置，其余插值
+vector<TokenPerformance> CalculateDecodePerformance(SimulationContext &context, vector<SimulationContext *> *threadContexts, int firstToken, int lastToken, const TokenEvaluator &evaluate);
+
+#endif /* TOKENSWEEP_H_ */
@@ -0,0 +1,155 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#include <iostream>
+#include <sstream>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "TraceFile.h"
+
+using namespace std;
+
+static_assert(sizeof(TraceHeader) == 40, "TraceHeader must match the layout written by utee/hook.py");
+
+TraceFile::TraceFile() {
+	mapped = NULL;
+	length = 0;
+	memset(&header, 0, sizeof(header));
+}
+
+TraceFile::~TraceFile() {
+	Close();
+}
+
+int TraceFile::ReadHeader(const string &filename, TraceHeader *header, string *error) {
+	memset(header, 0, sizeof(*header));
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return 0;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(TraceHeader)
+		|| pread(fd, header, sizeof(*header), 0) != (ssize_t) sizeof(*header) || memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) {
+		close(fd);
+		memset(header, 0, sizeof(*header));
+		return 0;	// 不是二进制trace，由调用者按CSV读取
+	}
+	close(fd);
+	
+	ostringstream message;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	message << "binary trace " << filename << " is little-endian and cannot be read on this machine";
+#else
+	size_t dataLength = 0;
+	if (header->dataType == TRACE_FLOAT32) {
+		dataLength = (size_t) header->numRow * header->numCol * sizeof(float);
+	} else if (header->dataType == TRACE_BIT) {
+		dataLength = (size_t) header->numCol * ((header->numRow + 63) / 64) * sizeof(uint64_t);
+	}
+	if (header->version != TRACE_VERSION) {
+		message << "binary trace " << filename << " has version " << header->version << ", expected " << TRACE_VERSION;
+	} else if (header->dataType != TRACE_FLOAT32 && header->dataType != TRACE_BIT) {
+		message << "binary trace " << filename << " has unknown data type " << header->dataType;
+	} else if ((size_t) st.st_size < sizeof(TraceHeader) + dataLength) {
+		message << "binary trace " << filename << " is truncated (" << st.st_size << " bytes, expected " << sizeof(TraceHeader) + dataLength << ")";
+	}
+#endif
+	if (!message.str().empty()) {
+		*error = message.str();
+		return -1;
+	}
+	return 1;
+}
+
+bool TraceFile::Open(const string &_filename) {
+	Close();
+	filename = _filename;
+	
+	string error;
+	int status = ReadHeader(filename, &header, &error);
+	if (status < 0) {
+		cerr << "Error: " << error << endl;
+		exit(1);
+	} else if (status == 0) {
+		return false;
+	}
+	
+	int fd = open(filename.c_str(), O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		cerr << "Error: binary trace " << filename << " cannot be opened!" << endl;
+		exit(1);
+	}
+	length = st.st_size;
+	mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		cerr << "Error: binary trace " << filename << " cannot be mapped!" << endl;
+		exit(1);
+	}
+	madvise(mapped, length, MADV_WILLNEED);
+	return true;
+}
+
+void TraceFile::Close() {
+	if (mapped != NULL) {
+		munmap(mapped, length);
+		mapped = NULL;
+		length = 0;
+	}
+}
+
+const float *TraceFile::GetFloat32() const {
+	if (header.dataType != TRACE_FLOAT32) {
+		cerr << "Error: binary trace " << filename << " does not contain float32 data" << endl;
+		exit(1);
+	}
+	return (const float *) ((const char *) mapped + sizeof(TraceHeader));
+}
+
+BitMatrixView TraceFile::GetBitMatrix() const {
+	if (header.dataType != TRACE_BIT) {
+		cerr << "Error: binary trace " << filename << " does not contain bit data" << endl;
+		exit(1);
+	}
+	return BitMatrixView((const uint64_t *) ((const char *) mapped + sizeof(TraceHeader)), header.numRow, header.numCol, 0, (header.numRow + 63) / 64);
+}
@@ -0,0 +1,97 @@
+/*******************************************************************************
+* Copyright (c) 2015-2017
+* School of Electrical, Computer and Energy Engineering, Arizona State University
+* PI: Prof. Shimeng Yu
+* All rights reserved.
+*   
+* This source code is part of NeuroSim - a device-circuit-algorithm framework to benchmark 
+* neuro-inspired architectures with synaptic devices(e.g., SRAM and emerging non-volatile memory). 
+* Copyright of the model is maintained by the developers, and the model is distributed under 
+* the terms of the Creative Commons Attribution-NonCommercial 4.0 International Public License 
+* http://creativecommons.org/licenses/by-nc/4.0/legalcode.
+* The source code is free and you can redistribute and/or modify it
+* by providing that the following conditions are met:
+*   
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer. 
+*   
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+*   
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Developer list: 
+*   Pai-Yu Chen     Email: pchen72 at asu dot edu 
+*                     
+*   Xiaochen Peng   Email: xpeng15 at asu dot edu
+********************************************************************************/
+
+#ifndef TRACEFILE_H_
+#define TRACEFILE_H_
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include "BitMatrix.h"
+
+using namespace std;
+
+// 二进制层trace文件（由utee/hook.py写出），替代逐值解析的CSV权重/输入文件
+// 文件 = 40字节的TraceHeader + 数据区，均为小端序，数据区从8字节对齐的位置开始：
+//   TRACE_FLOAT32: numRow x numCol 的float32矩阵，行主序（权重，每行对应一个输入，每列对应一个输出通道）
+//   TRACE_BIT:     numRow x numCol 的0/1矩阵，按BitMatrix的列存储格式打包（输入bit平面），
+//                  每列占(numRow+63)/64个64位字，第row行位于第row/64个字的第row%64位
+#define TRACE_MAGIC		"NSTRACE"
+#define TRACE_VERSION	1
+
+enum TraceDataType {
+	TRACE_FLOAT32 = 1,
+	TRACE_BIT = 2
+};
+
+struct TraceHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t dataType;		// TraceDataType
+	uint32_t numRow, numCol;
+	uint32_t quantBits;		// 权重/激活的量化位数，未知时为0
+	uint32_t reserved;
+	double activity;		// 输入的平均激活率，权重文件为0
+};
+
+// 以只读方式mmap整个trace文件，析构时解除映射；数据直接指向映射的内存，不做复制
+class TraceFile {
+public:
+	TraceFile();
+	~TraceFile();
+
+	bool Open(const string &filename);	// 不是二进制trace（例如CSV）时返回false，格式损坏时报错退出
+	// 只读取并检查文件头，不映射数据也不退出：合法的二进制trace返回1，不是二进制trace返回0，格式损坏返回-1并给出原因
+	static int ReadHeader(const string &filename, TraceHeader *header, string *error);
+	void Close();
+	bool IsOpen() const { return mapped != NULL; }
+	const float *GetFloat32() const;	// TRACE_FLOAT32的数据区
+	BitMatrixView GetBitMatrix() const;	// TRACE_BIT的数据区
+
+	TraceHeader header;
+
+private:
+	TraceFile(const TraceFile &);
+	TraceFile &operator=(const TraceFile &);
+
+	void *mapped;
+	size_t length;
+	string filename;
+};
+
+#endif /* TRACEFILE_H_ */
@@ -49,7 +49,7 @@
 #include "Param.h"
 
 using namespace std;
-extern Param *param;
+extern thread_local Param *param;
 
 WeightGradientUnit::WeightGradientUnit(const InputParameter& _inputParameter, const Technology& _tech, const MemCell& _cell): 
 										inputParameter(_inputParameter), tech(_tech), cell(_cell), FunctionUnit(),
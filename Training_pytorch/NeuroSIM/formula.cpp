@@ -41,13 +41,14 @@
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
+#include <map>
 #include "constant.h"
 #include "formula.h"
 
 using namespace std;
 
 /* Beyond 22 nm technology, the value capIdealGate is the sum of capIdealGate and capOverlap and capFringe */
-double CalculateGateCap(double width, Technology tech) {
+double CalculateGateCap(double width, const Technology& tech) {
 	double widthEff = 0;
 	if (tech.featureSize >= 22 * 1e-9 || tech.transistorType != conventional) {
 		widthEff = width;
@@ -59,10 +60,10 @@ double CalculateGateCap(double width, Technology tech) {
            + tech.phyGateLength * tech.capPolywire;
 }
 
-double CalculateGateArea(	// Calculate layout area and width of logic gate given fixed layout height
+static double EvaluateGateArea(	// Calculate layout area and width of logic gate given fixed layout height
     int gateType, int numInput,
     double widthNMOS, double widthPMOS,
-    double heightTransistorRegion, Technology tech,
+    double heightTransistorRegion, const Technology& tech,
     double *height, double *width) {
 		
 	if (tech.featureSize <= 14 * 1e-9) {  // finfet
@@ -213,10 +214,10 @@ double CalculateGateArea(	// Calculate layout area and width of logic gate given
     return (*width)*(*height);
 }
  
-void CalculateGateCapacitance(
+static void EvaluateGateCapacitance(
     int gateType, int numInput,
     double widthNMOS, double widthPMOS,
-    double heightTransistorRegion, Technology tech,
+    double heightTransistorRegion, const Technology& tech,
     double *capInput, double *capOutput) {
 	if (tech.featureSize <= 14 * 1e-9) {  // finfet
 		widthNMOS *= tech.PitchFin/(2 * tech.featureSize);
@@ -412,9 +413,100 @@ void CalculateGateCapacitance(
 }
 
 
+/* Memo table for the gate-level primitives. A design point only queries a handful of distinct
+   transistor sizes, so the layout and capacitance results are kept per thread and reused.
+   The table is dropped whenever a different technology is passed in. */
+struct GateKey {
+	int gateType;
+	int numInput;
+	double widthNMOS;
+	double widthPMOS;
+	double heightTransistorRegion;
+	bool operator<(const GateKey &other) const {
+		if (gateType != other.gateType) return gateType < other.gateType;
+		if (numInput != other.numInput) return numInput < other.numInput;
+		if (widthNMOS != other.widthNMOS) return widthNMOS < other.widthNMOS;
+		if (widthPMOS != other.widthPMOS) return widthPMOS < other.widthPMOS;
+		return heightTransistorRegion < other.heightTransistorRegion;
+	}
+};
+
+struct GateArea {
+	double area, height, width;
+};
+
+struct GateCapacitance {
+	double capInput, capOutput;
+};
+
+struct GateMemo {
+	const Technology *tech;
+	int featureSizeInNano;
+	DeviceRoadmap deviceRoadmap;
+	TransistorType transistorType;
+	map<GateKey, GateArea> area;
+	map<GateKey, GateCapacitance> capacitance;
+};
+
+static thread_local GateMemo *gateMemo = NULL;
+
+static GateMemo& GetGateMemo(const Technology& tech) {
+	if (!gateMemo) {
+		gateMemo = new GateMemo();
+		gateMemo->tech = NULL;
+	}
+	if (gateMemo->tech != &tech || gateMemo->featureSizeInNano != tech.featureSizeInNano
+			|| gateMemo->deviceRoadmap != tech.deviceRoadmap || gateMemo->transistorType != tech.transistorType) {
+		gateMemo->tech = &tech;
+		gateMemo->featureSizeInNano = tech.featureSizeInNano;
+		gateMemo->deviceRoadmap = tech.deviceRoadmap;
+		gateMemo->transistorType = tech.transistorType;
+		gateMemo->area.clear();
+		gateMemo->capacitance.clear();
+	}
+	return *gateMemo;
+}
+
+double CalculateGateArea(
+    int gateType, int numInput,
+    double widthNMOS, double widthPMOS,
+    double heightTransistorRegion, const Technology& tech,
+    double *height, double *width) {
+	GateMemo &memo = GetGateMemo(tech);
+	GateKey key = {gateType, numInput, widthNMOS, widthPMOS, heightTransistorRegion};
+	map<GateKey, GateArea>::iterator it = memo.area.find(key);
+	if (it == memo.area.end()) {
+		GateArea value;
+		value.area = EvaluateGateArea(gateType, numInput, widthNMOS, widthPMOS, heightTransistorRegion, tech, &value.height, &value.width);
+		it = memo.area.insert(make_pair(key, value)).first;
+	}
+	*height = it->second.height;
+	*width = it->second.width;
+	return it->second.area;
+}
+
+void CalculateGateCapacitance(
+    int gateType, int numInput,
+    double widthNMOS, double widthPMOS,
+    double heightTransistorRegion, const Technology& tech,
+    double *capInput, double *capOutput) {
+	GateMemo &memo = GetGateMemo(tech);
+	GateKey key = {gateType, numInput, widthNMOS, widthPMOS, heightTransistorRegion};
+	map<GateKey, GateCapacitance>::iterator it = memo.capacitance.find(key);
+	if (it == memo.capacitance.end()) {
+		GateCapacitance value;
+		EvaluateGateCapacitance(gateType, numInput, widthNMOS, widthPMOS, heightTransistorRegion, tech, &value.capInput, &value.capOutput);
+		it = memo.capacitance.insert(make_pair(key, value)).first;
+	}
+	if (capInput)
+		*capInput = it->second.capInput;
+	if (capOutput)
+		*capOutput = it->second.capOutput;
+}
+
 double CalculateDrainCap(
     double width, int type,
-    double heightTransistorRegion, Technology tech) {
+    double heightTransistorRegion, const Technology& tech) {
     double drainCap = 0;
     if (type == NMOS)
         CalculateGateCapacitance(INV, 1, width, 0, heightTransistorRegion, tech, NULL, &drainCap);
@@ -426,14 +518,14 @@ double CalculateDrainCap(
 double CalculateGateLeakage(
     int gateType, int numInput,
     double widthNMOS, double widthPMOS,
-    double temperature, Technology tech) {
+    double temperature, const Technology& tech) {
     int tempIndex = (int)temperature - 300;
     if ((tempIndex > 100) || (tempIndex < 0)) {
         cout<<"Error: Temperature is out of range"<<endl;
         exit(-1);
     }
-    double *leakN = tech.currentOffNmos;
-    double *leakP = tech.currentOffPmos;
+    const double *leakN = tech.currentOffNmos;
+    const double *leakP = tech.currentOffPmos;
     double leakageN, leakageP;
 	
 	double widthNMOSEff, widthPMOSEff;
@@ -473,7 +565,7 @@ double CalculateGateLeakage(
     }
 }
 
-double CalculateOnResistance(double width, int type, double temperature, Technology tech) {
+double CalculateOnResistance(double width, int type, double temperature, const Technology& tech) {
     double r;
     int tempIndex = (int)temperature - 300;
     if ((tempIndex > 100) || (tempIndex < 0)) {
@@ -495,7 +587,7 @@ double CalculateOnResistance(double width, int type, double temperature, Technol
     return r;
 }
 
-double CalculateTransconductance(double width, int type, Technology tech) {
+double CalculateTransconductance(double width, int type, const Technology& tech) {
     double gm;
     if (type == NMOS) {
         gm = (2*tech.current_gmNmos)*width/(0.7*tech.vdd-tech.vth);
@@ -518,7 +610,7 @@ double horowitz(double tr, double beta, double rampInput, double *rampOutput) {
 
 double CalculatePassGateArea(	// Calculate layout area, height and width of pass gate given the number of folding on the pass gate width
     // This function is for pass gate where the cell height can change. For normal standard cells, use CalculateGateArea() where the cell height is fixed
-    double widthNMOS, double widthPMOS, Technology tech, int numFold, double *height, double *width) {
+    double widthNMOS, double widthPMOS, const Technology& tech, int numFold, double *height, double *width) {
 
     if (tech.featureSize >= 22 * 1e-9 || tech.transistorType != conventional) {	// Bulk
 		*width = (numFold + 1) * (POLY_WIDTH + MIN_GAP_BET_GATE_POLY) * tech.featureSize;	// No folding means numFold=1
@@ -37,7 +37,6 @@
 ********************************************************************************/
 
 #include <cstdio>
-#include <random>
 #include <cmath>
 #include <iostream>
 #include <fstream>
@@ -47,6 +46,7 @@
 #include <sstream>
 #include <chrono>
 #include <algorithm>
+#include <omp.h>
 #include "constant.h"
 #include "formula.h"
 #include "Param.h"
@@ -54,17 +54,27 @@
 #include "Chip.h"
 #include "ProcessingUnit.h"
 #include "SubArray.h"
+#include "SimulationContext.h"
 #include "Definition.h"
+#include "CsvParser.h"
+#include "LayerLoader.h"
+#include "TokenSweep.h"
+#include "Server.h"
 
 using namespace std;
 
 vector<vector<double> > getNetStructure(const string &inputfile);
+LayerPrefetcher *StartLayerPrefetch(SimulationContext &context, int numLayer, char *argv[]);
 
 int main(int argc, char * argv[]) {   
 
+	if (argc > 1 && string(argv[1]) == "--serve") {
+		return RunServer(argc, argv);	// 常驻进程，只初始化一次芯片，见Server.h
+	}
+	
 	auto start = chrono::high_resolution_clock::now();
 	
-	gen.seed(0);
+	context.Bind();
 	
 	vector<vector<double> > netStructure;
 
@@ -72,72 +82,15 @@ int main(int argc, char * argv[]) {
 		netStructure = getNetStructure(argv[2]);
 	
 	// define weight/input/memory precision from wrapper
-	param->synapseBit = atoi(argv[3]);             		 // precision of synapse weight
-	param->numBitInput = atoi(argv[4]);            		 // precision of input neural activation
-	
-	if (param->cellBit > param->synapseBit) {
-		cout << "ERROR!: Memory precision is even higher than synapse precision, please modify 'cellBit' in Param.cpp!" << endl;
-		param->cellBit = param->synapseBit;
-	}
-	
-	/*** initialize operationMode as default ***/
-	param->conventionalParallel = 0;
-	param->conventionalSequential = 0;
-	param->BNNparallelMode = 0;                // parallel BNN
-	param->BNNsequentialMode = 0;              // sequential BNN
-	param->XNORsequentialMode = 0;           // Use several multi-bit RRAM as one synapse
-	param->XNORparallelMode = 0;         // Use several multi-bit RRAM as one synapse
-	switch(param->operationmode) {
-		case 6:	    param->XNORparallelMode = 1;               break;     
-		case 5:	    param->XNORsequentialMode = 1;             break;     
-		case 4:	    param->BNNparallelMode = 1;                break;     
-		case 3:	    param->BNNsequentialMode = 1;              break;    
-		case 2:	    param->conventionalParallel = 1;           break;     
-		case 1:	    param->conventionalSequential = 1;         break;    
-		case -1:	break;
-		default:	exit(-1);
-	}
-	
-	if (param->XNORparallelMode || param->XNORsequentialMode) {
-		param->numRowPerSynapse = 2;
-	} else {
-		param->numRowPerSynapse = 1;
-	}
-	if (param->BNNparallelMode) {
-		param->numColPerSynapse = 2;
-	} else if (param->XNORparallelMode || param->XNORsequentialMode || param->BNNsequentialMode) {
-		param->numColPerSynapse = 1;
-	} else {
-		param->numColPerSynapse = ceil((double)param->synapseBit/(double)param->cellBit); 
-	}
-	
-	switch(param->transistortype) {
-		case 3:	    inputParameter.transistorType = TFET;          break;
-		case 2:	    inputParameter.transistorType = FET_2D;        break;
-		case 1:	    inputParameter.transistorType = conventional;  break;
-		case -1:	break;
-		default:	exit(-1);
-	}
-	
-	switch(param->deviceroadmap) {
-		case 2:	    inputParameter.deviceRoadmap = LSTP;  break;
-		case 1:	    inputParameter.deviceRoadmap = HP;    break;
-		case -1:	break;
-		default:	exit(-1);
-	}
-	
-	/* Create SubArray object and link the required global objects (not initialization) */
-	inputParameter.temperature = param->temp;   // Temperature (K)
-	inputParameter.processNode = param->technode;    // Technology node
-	tech.Initialize(inputParameter.processNode, inputParameter.deviceRoadmap, inputParameter.transistorType);
+	context.Initialize(atoi(argv[3]), atoi(argv[4]));
 
 	double maxPESizeNM, maxTileSizeCM, numPENM;
 	vector<int> markNM;
 	vector<int> pipelineSpeedUp;
 
 	//该函数数字计算也需要调用，因为里面有部分电路原件的初始化
-	markNM = ChipDesignInitialize(inputParameter, tech, cell, false, netStructure, &maxPESizeNM, &maxTileSizeCM, &numPENM);
-	pipelineSpeedUp = ChipDesignInitialize(inputParameter, tech, cell, true, netStructure, &maxPESizeNM, &maxTileSizeCM, &numPENM);
+	markNM = ChipDesignInitialize(context, false, netStructure, &maxPESizeNM, &maxTileSizeCM, &numPENM);
+	pipelineSpeedUp = ChipDesignInitialize(context, true, netStructure, &maxPESizeNM, &maxTileSizeCM, &numPENM);
 	
 	
 	
@@ -151,19 +104,19 @@ int main(int argc, char * argv[]) {
 	vector<vector<double> > tileLocaEachLayer;
 	
 	if(!param->digital){
-		numTileEachLayer = ChipFloorPlan(true, false, false, netStructure, markNM, 
+		numTileEachLayer = ChipFloorPlan(context, true, false, false, netStructure, markNM, 
 			maxPESizeNM, maxTileSizeCM, numPENM, pipelineSpeedUp,
 			&desiredNumTileNM, &desiredPESizeNM, &desiredNumTileCM, &desiredTileSizeCM, &desiredPESizeCM, &numTileRow, &numTileCol);	
 
-		utilizationEachLayer = ChipFloorPlan(false, true, false, netStructure, markNM, 
+		utilizationEachLayer = ChipFloorPlan(context, false, true, false, netStructure, markNM, 
 					maxPESizeNM, maxTileSizeCM, numPENM, pipelineSpeedUp,
 					&desiredNumTileNM, &desiredPESizeNM, &desiredNumTileCM, &desiredTileSizeCM, &desiredPESizeCM, &numTileRow, &numTileCol);
 
-		speedUpEachLayer = ChipFloorPlan(false, false, true, netStructure, markNM,
+		speedUpEachLayer = ChipFloorPlan(context, false, false, true, netStructure, markNM,
 					maxPESizeNM, maxTileSizeCM, numPENM, pipelineSpeedUp,
 					&desiredNumTileNM, &desiredPESizeNM, &desiredNumTileCM, &desiredTileSizeCM, &desiredPESizeCM, &numTileRow, &numTileCol);
 					
-		tileLocaEachLayer = ChipFloorPlan(false, false, false, netStructure, markNM,
+		tileLocaEachLayer = ChipFloorPlan(context, false, false, false, netStructure, markNM,
 					maxPESizeNM, maxTileSizeCM, numPENM, pipelineSpeedUp,
 					&desiredNumTileNM, &desiredPESizeNM, &desiredNumTileCM, &desiredTileSizeCM, &desiredPESizeCM, &numTileRow, &numTileCol);
 	}
@@ -239,7 +192,7 @@ int main(int argc, char * argv[]) {
 	}
 
 	cout << "----------------- Start Initializing ------------------" <<  endl;
-	ChipInitialize(inputParameter, tech, cell, netStructure, markNM, numTileEachLayer,
+	ChipInitialize(context, netStructure, markNM, numTileEachLayer,
 					numPENM, desiredNumTileNM, desiredPESizeNM, desiredNumTileCM, desiredTileSizeCM, desiredPESizeCM, numTileRow, numTileCol, &numArrayWriteParallel);
 
 	cout << "----------------- End Initializing ------------------" <<  endl;
@@ -252,7 +205,7 @@ int main(int argc, char * argv[]) {
 	vector<double> chipAreaResults;
 	
 	cout << "----------------- Start Area Calculating ------------------" <<  endl;
-	chipAreaResults = ChipCalculateArea(inputParameter, tech, cell, desiredNumTileNM, numPENM, desiredPESizeNM, desiredNumTileCM, desiredTileSizeCM, desiredPESizeCM, numTileRow, 
+	chipAreaResults = ChipCalculateArea(context, desiredNumTileNM, numPENM, desiredPESizeNM, desiredNumTileCM, desiredTileSizeCM, desiredPESizeCM, numTileRow, 
 		&chipHeight, &chipWidth, &CMTileheight, &CMTilewidth, &NMTileheight, &NMTilewidth);	
 	chipArea = chipAreaResults[0];
 	chipAreaIC = chipAreaResults[1];
@@ -359,231 +312,109 @@ int main(int argc, char * argv[]) {
 	}
 	
 	if(param->digital){ //进行数字计算，完成一个query的完整推理流程或者部分推理流程
-		if(param->digital == 1){
-			//进行完整推理流程
-			//prefill
-			int seq_len = param->input_len;
-			int seq_len_total = seq_len;
-			ChipCalculatePerformance(inputParameter, tech, cell, 0, "", "", "", 0,
+		// 评估一次推理（prefill或者生成一个token），结果只与seq_len和seq_len_total有关
+		auto calculateTokenPerformance = [&](SimulationContext &tokenContext, int seq_len, int seq_len_total) {
+			TokenPerformance token;
+			ChipCalculatePerformance(tokenContext, 0, "", "", "", 0,
 				netStructure, markNM, 1, seq_len, seq_len_total, numTileEachLayer, utilizationEachLayer, speedUpEachLayer, tileLocaEachLayer,
 				numPENM, desiredPESizeNM, desiredTileSizeCM, desiredPESizeCM, CMTileheight, CMTilewidth, NMTileheight, NMTilewidth, numArrayWriteParallel,
-				&layerReadLatency, &layerReadDynamicEnergy, &tileLeakage, &layerReadLatencyAG, &layerReadDynamicEnergyAG, &layerReadLatencyWG, &layerReadDynamicEnergyWG, 
-				&layerWriteLatencyWU, &layerWriteDynamicEnergyWU, &layerbufferLatency, &layerbufferDynamicEnergy, &layericLatency, &layericDynamicEnergy,
-				&coreLatencyADC, &coreLatencyAccum, &coreLatencyOther, &coreEnergyADC, &coreEnergyAccum, &coreEnergyOther, &layerDRAMLatency, &layerDRAMDynamicEnergy,
-				&layerReadLatencyPeakFW, &layerReadDynamicEnergyPeakFW, &layerReadLatencyPeakAG, &layerReadDynamicEnergyPeakAG,
-				&layerReadLatencyPeakWG, &layerReadDynamicEnergyPeakWG, &layerWriteLatencyPeakWU, &layerWriteDynamicEnergyPeakWU);
-
+				&token.readLatency, &token.readDynamicEnergy, &token.leakage, &token.readLatencyAG, &token.readDynamicEnergyAG, &token.readLatencyWG, &token.readDynamicEnergyWG, 
+				&token.writeLatencyWU, &token.writeDynamicEnergyWU, &token.bufferLatency, &token.bufferDynamicEnergy, &token.icLatency, &token.icDynamicEnergy,
+				&token.coreLatencyADC, &token.coreLatencyAccum, &token.coreLatencyOther, &token.coreEnergyADC, &token.coreEnergyAccum, &token.coreEnergyOther, &token.DRAMLatency, &token.DRAMDynamicEnergy,
+				&token.readLatencyPeakFW, &token.readDynamicEnergyPeakFW, &token.readLatencyPeakAG, &token.readDynamicEnergyPeakAG,
+				&token.readLatencyPeakWG, &token.readDynamicEnergyPeakWG, &token.writeLatencyPeakWU, &token.writeDynamicEnergyPeakWU);
+			return token;
+		};
+		// 写入breakdown文件并累加到chip的总结果中
+		auto accumulateTokenPerformance = [&](int seq_len, int seq_len_total, const TokenPerformance &token) {
 			if (breakdownfile.is_open()) {
-				breakdownfile << seq_len_total << "," << layerReadLatency << "," << layerReadLatencyAG << "," << layerReadLatencyWG << "," << layerWriteLatencyWU << ",";
-				breakdownfile << layerReadDynamicEnergy << "," << layerReadDynamicEnergyAG << "," << layerReadDynamicEnergyWG << "," << layerWriteDynamicEnergyWU << ",";
-				breakdownfile << layerReadLatencyPeakFW << "," << layerReadLatencyPeakAG << "," << layerReadLatencyPeakWG << "," << layerWriteLatencyPeakWU << ",";
-				breakdownfile << layerReadDynamicEnergyPeakFW << "," << layerReadDynamicEnergyPeakAG << "," << layerReadDynamicEnergyPeakWG << "," << layerWriteDynamicEnergyPeakWU <<",";
-				breakdownfile << ", , " << coreLatencyADC << "," << coreLatencyAccum << "," << coreLatencyOther << "," <<layerbufferLatency << "," << layericLatency << "," << layerReadLatencyPeakWG << "," << layerWriteLatencyPeakWU << "," << layerDRAMLatency << ",";
-				breakdownfile << coreEnergyADC << "," << coreEnergyAccum << "," << coreEnergyOther << "," << layerbufferDynamicEnergy << "," << layericDynamicEnergy << "," << layerReadDynamicEnergyPeakWG << "," << layerWriteDynamicEnergyPeakWU << "," << layerDRAMDynamicEnergy << endl;
+				breakdownfile << seq_len_total << "," << token.readLatency << "," << token.readLatencyAG << "," << token.readLatencyWG << "," << token.writeLatencyWU << ",";
+				breakdownfile << token.readDynamicEnergy << "," << token.readDynamicEnergyAG << "," << token.readDynamicEnergyWG << "," << token.writeDynamicEnergyWU << ",";
+				breakdownfile << token.readLatencyPeakFW << "," << token.readLatencyPeakAG << "," << token.readLatencyPeakWG << "," << token.writeLatencyPeakWU << ",";
+				breakdownfile << token.readDynamicEnergyPeakFW << "," << token.readDynamicEnergyPeakAG << "," << token.readDynamicEnergyPeakWG << "," << token.writeDynamicEnergyPeakWU <<",";
+				breakdownfile << ", , " << token.coreLatencyADC << "," << token.coreLatencyAccum << "," << token.coreLatencyOther << "," << token.bufferLatency << "," << token.icLatency << "," << token.readLatencyPeakWG << "," << token.writeLatencyPeakWU << "," << token.DRAMLatency << ",";
+				breakdownfile << token.coreEnergyADC << "," << token.coreEnergyAccum << "," << token.coreEnergyOther << "," << token.bufferDynamicEnergy << "," << token.icDynamicEnergy << "," << token.readDynamicEnergyPeakWG << "," << token.writeDynamicEnergyPeakWU << "," << token.DRAMDynamicEnergy << endl;
 			} else {
 				cout << "Error: the breakdown file cannot be opened!" << endl;
 			}
 			
-			chipReadLatency += layerReadLatency;
-			chipReadDynamicEnergy += layerReadDynamicEnergy;
-			chipReadLatencyAG += layerReadLatencyAG;
-			chipReadDynamicEnergyAG += layerReadDynamicEnergyAG;
-			chipReadLatencyWG += layerReadLatencyWG;
-			chipReadDynamicEnergyWG += layerReadDynamicEnergyWG;
-			chipWriteLatencyWU += layerWriteLatencyWU;
-			chipWriteDynamicEnergyWU += layerWriteDynamicEnergyWU;
-			chipDRAMLatency += layerDRAMLatency;
-			chipDRAMDynamicEnergy += layerDRAMDynamicEnergy;
+			chipReadLatency += token.readLatency;
+			chipReadDynamicEnergy += token.readDynamicEnergy;
+			chipReadLatencyAG += token.readLatencyAG;
+			chipReadDynamicEnergyAG += token.readDynamicEnergyAG;
+			chipReadLatencyWG += token.readLatencyWG;
+			chipReadDynamicEnergyWG += token.readDynamicEnergyWG;
+			chipWriteLatencyWU += token.writeLatencyWU;
+			chipWriteDynamicEnergyWU += token.writeDynamicEnergyWU;
+			chipDRAMLatency += token.DRAMLatency;
+			chipDRAMDynamicEnergy += token.DRAMDynamicEnergy;
 			
-			chipReadLatencyPeakFW += layerReadLatencyPeakFW;
-			chipReadDynamicEnergyPeakFW += layerReadDynamicEnergyPeakFW;
-			chipReadLatencyPeakAG += layerReadLatencyPeakAG;
-			chipReadDynamicEnergyPeakAG += layerReadDynamicEnergyPeakAG;
-			chipReadLatencyPeakWG += layerReadLatencyPeakWG;
-			chipReadDynamicEnergyPeakWG += layerReadDynamicEnergyPeakWG;
-			chipWriteLatencyPeakWU += layerWriteLatencyPeakWU;
-			chipWriteDynamicEnergyPeakWU += layerWriteDynamicEnergyPeakWU;
+			chipReadLatencyPeakFW += token.readLatencyPeakFW;
+			chipReadDynamicEnergyPeakFW += token.readDynamicEnergyPeakFW;
+			chipReadLatencyPeakAG += token.readLatencyPeakAG;
+			chipReadDynamicEnergyPeakAG += token.readDynamicEnergyPeakAG;
+			chipReadLatencyPeakWG += token.readLatencyPeakWG;
+			chipReadDynamicEnergyPeakWG += token.readDynamicEnergyPeakWG;
+			chipWriteLatencyPeakWU += token.writeLatencyPeakWU;
+			chipWriteDynamicEnergyPeakWU += token.writeDynamicEnergyPeakWU;
 			
+			chipbufferLatency += token.bufferLatency;
+			chipbufferReadDynamicEnergy += token.bufferDynamicEnergy;
+			chipicLatency += token.icLatency;
+			chipicReadDynamicEnergy += token.icDynamicEnergy;
 			
-			chipbufferLatency += layerbufferLatency;
-			chipbufferReadDynamicEnergy += layerbufferDynamicEnergy;
-			chipicLatency += layericLatency;
-			chipicReadDynamicEnergy += layericDynamicEnergy;
+			chipLatencyADC += token.coreLatencyADC;
+			chipLatencyAccum += token.coreLatencyAccum;
+			chipLatencyOther += token.coreLatencyOther;
+			chipEnergyADC += token.coreEnergyADC;
+			chipEnergyAccum += token.coreEnergyAccum;
+			chipEnergyOther += token.coreEnergyOther;
 			
-			chipLatencyADC += coreLatencyADC;
-			chipLatencyAccum += coreLatencyAccum;
-			chipLatencyOther += coreLatencyOther;
-			chipEnergyADC += coreEnergyADC;
-			chipEnergyAccum += coreEnergyAccum;
-			chipEnergyOther += coreEnergyOther;
-
-
-			numComputation += seq_len*param->d_k*param->n_heads*param->d_model*2; //WQ
-			numComputation += seq_len*param->d_k*param->n_heads*param->d_model*2; //WK
-			numComputation += seq_len*param->d_v*param->n_heads*param->d_model*2; //WV
-			numComputation += seq_len*seq_len_total*param->d_k*param->n_heads*2;    //K cache
-			numComputation += seq_len*seq_len_total*param->d_v*param->n_heads*2;    //V cache
-			numComputation += seq_len*param->d_model*param->d_v*param->n_heads*2;   //Linear
-			numComputation += seq_len*param->d_hidden*param->d_model*2; 			//FFN1
-			numComputation += seq_len*param->d_model*param->d_hidden*2; 			//FFN2
-			//自回归阶段
-			for(int i =seq_len+1;i<=param->output_len;i++){
-				seq_len = 1;
-				seq_len_total++;
-				ChipCalculatePerformance(inputParameter, tech, cell, 0, "", "", "", 0,
-					netStructure, markNM, 1, seq_len, seq_len_total, numTileEachLayer, utilizationEachLayer, speedUpEachLayer, tileLocaEachLayer,
-					numPENM, desiredPESizeNM, desiredTileSizeCM, desiredPESizeCM, CMTileheight, CMTilewidth, NMTileheight, NMTilewidth, numArrayWriteParallel,
-					&layerReadLatency, &layerReadDynamicEnergy, &tileLeakage, &layerReadLatencyAG, &layerReadDynamicEnergyAG, &layerReadLatencyWG, &layerReadDynamicEnergyWG, 
-					&layerWriteLatencyWU, &layerWriteDynamicEnergyWU, &layerbufferLatency, &layerbufferDynamicEnergy, &layericLatency, &layericDynamicEnergy,
-					&coreLatencyADC, &coreLatencyAccum, &coreLatencyOther, &coreEnergyADC, &coreEnergyAccum, &coreEnergyOther, &layerDRAMLatency, &layerDRAMDynamicEnergy,
-					&layerReadLatencyPeakFW, &layerReadDynamicEnergyPeakFW, &layerReadLatencyPeakAG, &layerReadDynamicEnergyPeakAG,
-					&layerReadLatencyPeakWG, &layerReadDynamicEnergyPeakWG, &layerWriteLatencyPeakWU, &layerWriteDynamicEnergyPeakWU);
-
-				if (breakdownfile.is_open()) {
-					breakdownfile << seq_len_total << "," << layerReadLatency << "," << layerReadLatencyAG << "," << layerReadLatencyWG << "," << layerWriteLatencyWU << ",";
-					breakdownfile << layerReadDynamicEnergy << "," << layerReadDynamicEnergyAG << "," << layerReadDynamicEnergyWG << "," << layerWriteDynamicEnergyWU << ",";
-					breakdownfile << layerReadLatencyPeakFW << "," << layerReadLatencyPeakAG << "," << layerReadLatencyPeakWG << "," << layerWriteLatencyPeakWU << ",";
-					breakdownfile << layerReadDynamicEnergyPeakFW << "," << layerReadDynamicEnergyPeakAG << "," << layerReadDynamicEnergyPeakWG << "," << layerWriteDynamicEnergyPeakWU <<",";
-					breakdownfile << ", , " << coreLatencyADC << "," << coreLatencyAccum << "," << coreLatencyOther << "," <<layerbufferLatency << "," << layericLatency << "," << layerReadLatencyPeakWG << "," << layerWriteLatencyPeakWU << "," << layerDRAMLatency << ",";
-					breakdownfile << coreEnergyADC << "," << coreEnergyAccum << "," << coreEnergyOther << "," << layerbufferDynamicEnergy << "," << layericDynamicEnergy << "," << layerReadDynamicEnergyPeakWG << "," << layerWriteDynamicEnergyPeakWU << "," << layerDRAMDynamicEnergy << endl;
-				} else {
-					cout << "Error: the breakdown file cannot be opened!" << endl;
-				}
-				
-				chipReadLatency += layerReadLatency;
-				chipReadDynamicEnergy += layerReadDynamicEnergy;
-				chipReadLatencyAG += layerReadLatencyAG;
-				chipReadDynamicEnergyAG += layerReadDynamicEnergyAG;
-				chipReadLatencyWG += layerReadLatencyWG;
-				chipReadDynamicEnergyWG += layerReadDynamicEnergyWG;
-				chipWriteLatencyWU += layerWriteLatencyWU;
-				chipWriteDynamicEnergyWU += layerWriteDynamicEnergyWU;
-				chipDRAMLatency += layerDRAMLatency;
-				chipDRAMDynamicEnergy += layerDRAMDynamicEnergy;
-				
-				chipReadLatencyPeakFW += layerReadLatencyPeakFW;
-				chipReadDynamicEnergyPeakFW += layerReadDynamicEnergyPeakFW;
-				chipReadLatencyPeakAG += layerReadLatencyPeakAG;
-				chipReadDynamicEnergyPeakAG += layerReadDynamicEnergyPeakAG;
-				chipReadLatencyPeakWG += layerReadLatencyPeakWG;
-				chipReadDynamicEnergyPeakWG += layerReadDynamicEnergyPeakWG;
-				chipWriteLatencyPeakWU += layerWriteLatencyPeakWU;
-				chipWriteDynamicEnergyPeakWU += layerWriteDynamicEnergyPeakWU;
-				
-				
-				chipbufferLatency += layerbufferLatency;
-				chipbufferReadDynamicEnergy += layerbufferDynamicEnergy;
-				chipicLatency += layericLatency;
-				chipicReadDynamicEnergy += layericDynamicEnergy;
-				
-				chipLatencyADC += coreLatencyADC;
-				chipLatencyAccum += coreLatencyAccum;
-				chipLatencyOther += coreLatencyOther;
-				chipEnergyADC += coreEnergyADC;
-				chipEnergyAccum += coreEnergyAccum;
-				chipEnergyOther += coreEnergyOther;
-	
-				numComputation += seq_len*param->d_k*param->n_heads*param->d_model*2; //WQ
-				numComputation += seq_len*param->d_k*param->n_heads*param->d_model*2; //WK
-				numComputation += seq_len*param->d_v*param->n_heads*param->d_model*2; //WV
-				numComputation += seq_len*seq_len_total*param->d_k*param->n_heads*2;    //K cache
-				numComputation += seq_len*seq_len_total*param->d_v*param->n_heads*2;    //V cache
-				numComputation += seq_len*param->d_model*param->d_v*param->n_heads*2;   //Linear
-				numComputation += seq_len*param->d_hidden*param->d_model*2; 			//FFN1
-				numComputation += seq_len*param->d_model*param->d_hidden*2; 			//FFN2
-			}
+			numComputation += GetTokenComputation(seq_len, seq_len_total);
+		};
+		
+		int seq_len = param->input_len;
+		int seq_len_total = param->input_len;
+		if(param->digital == 1){
+			//进行完整推理流程
+			//prefill
+			accumulateTokenPerformance(seq_len, seq_len_total, calculateTokenPerformance(context, seq_len, seq_len_total));
 		}
-		else{
-			//只执行自回归生成阶段
-			//自回归阶段
-			int seq_len = param->input_len;
-			int seq_len_total = param->input_len;
-			for(int i =seq_len+1;i<=param->output_len;i++){
-				seq_len = 1;
-				seq_len_total++;
-				ChipCalculatePerformance(inputParameter, tech, cell, 0, "", "", "", 0,
-					netStructure, markNM, 1, seq_len, seq_len_total, numTileEachLayer, utilizationEachLayer, speedUpEachLayer, tileLocaEachLayer,
-					numPENM, desiredPESizeNM, desiredTileSizeCM, desiredPESizeCM, CMTileheight, CMTilewidth, NMTileheight, NMTilewidth, numArrayWriteParallel,
-					&layerReadLatency, &layerReadDynamicEnergy, &tileLeakage, &layerReadLatencyAG, &layerReadDynamicEnergyAG, &layerReadLatencyWG, &layerReadDynamicEnergyWG, 
-					&layerWriteLatencyWU, &layerWriteDynamicEnergyWU, &layerbufferLatency, &layerbufferDynamicEnergy, &layericLatency, &layericDynamicEnergy,
-					&coreLatencyADC, &coreLatencyAccum, &coreLatencyOther, &coreEnergyADC, &coreEnergyAccum, &coreEnergyOther, &layerDRAMLatency, &layerDRAMDynamicEnergy,
-					&layerReadLatencyPeakFW, &layerReadDynamicEnergyPeakFW, &layerReadLatencyPeakAG, &layerReadDynamicEnergyPeakAG,
-					&layerReadLatencyPeakWG, &layerReadDynamicEnergyPeakWG, &layerWriteLatencyPeakWU, &layerWriteDynamicEnergyPeakWU);
-				
-				if (breakdownfile.is_open()) {
-					breakdownfile << seq_len_total << "," << layerReadLatency << "," << layerReadLatencyAG << "," << layerReadLatencyWG << "," << layerWriteLatencyWU << ",";
-					breakdownfile << layerReadDynamicEnergy << "," << layerReadDynamicEnergyAG << "," << layerReadDynamicEnergyWG << "," << layerWriteDynamicEnergyWU << ",";
-					breakdownfile << layerReadLatencyPeakFW << "," << layerReadLatencyPeakAG << "," << layerReadLatencyPeakWG << "," << layerWriteLatencyPeakWU << ",";
-					breakdownfile << layerReadDynamicEnergyPeakFW << "," << layerReadDynamicEnergyPeakAG << "," << layerReadDynamicEnergyPeakWG << "," << layerWriteDynamicEnergyPeakWU <<",";
-					breakdownfile << ", , " << coreLatencyADC << "," << coreLatencyAccum << "," << coreLatencyOther << "," <<layerbufferLatency << "," << layericLatency << "," << layerReadLatencyPeakWG << "," << layerWriteLatencyPeakWU << "," << layerDRAMLatency << ",";
-					breakdownfile << coreEnergyADC << "," << coreEnergyAccum << "," << coreEnergyOther << "," << layerbufferDynamicEnergy << "," << layericDynamicEnergy << "," << layerReadDynamicEnergyPeakWG << "," << layerWriteDynamicEnergyPeakWU << "," << layerDRAMDynamicEnergy << endl;
-				} else {
-					cout << "Error: the breakdown file cannot be opened!" << endl;
-				}
-				
-				chipReadLatency += layerReadLatency;
-				chipReadDynamicEnergy += layerReadDynamicEnergy;
-				chipReadLatencyAG += layerReadLatencyAG;
-				chipReadDynamicEnergyAG += layerReadDynamicEnergyAG;
-				chipReadLatencyWG += layerReadLatencyWG;
-				chipReadDynamicEnergyWG += layerReadDynamicEnergyWG;
-				chipWriteLatencyWU += layerWriteLatencyWU;
-				chipWriteDynamicEnergyWU += layerWriteDynamicEnergyWU;
-				chipDRAMLatency += layerDRAMLatency;
-				chipDRAMDynamicEnergy += layerDRAMDynamicEnergy;
-				
-				chipReadLatencyPeakFW += layerReadLatencyPeakFW;
-				chipReadDynamicEnergyPeakFW += layerReadDynamicEnergyPeakFW;
-				chipReadLatencyPeakAG += layerReadLatencyPeakAG;
-				chipReadDynamicEnergyPeakAG += layerReadDynamicEnergyPeakAG;
-				chipReadLatencyPeakWG += layerReadLatencyPeakWG;
-				chipReadDynamicEnergyPeakWG += layerReadDynamicEnergyPeakWG;
-				chipWriteLatencyPeakWU += layerWriteLatencyPeakWU;
-				chipWriteDynamicEnergyPeakWU += layerWriteDynamicEnergyPeakWU;
-				
-				
-				chipbufferLatency += layerbufferLatency;
-				chipbufferReadDynamicEnergy += layerbufferDynamicEnergy;
-				chipicLatency += layericLatency;
-				chipicReadDynamicEnergy += layericDynamicEnergy;
-				
-				chipLatencyADC += coreLatencyADC;
-				chipLatencyAccum += coreLatencyAccum;
-				chipLatencyOther += coreLatencyOther;
-				chipEnergyADC += coreEnergyADC;
-				chipEnergyAccum += coreEnergyAccum;
-				chipEnergyOther += coreEnergyOther;
-				
-				numComputation += seq_len*param->d_k*param->n_heads*param->d_model*2; //WQ
-				numComputation += seq_len*param->d_k*param->n_heads*param->d_model*2; //WK
-				numComputation += seq_len*param->d_v*param->n_heads*param->d_model*2; //WV
-				numComputation += seq_len*seq_len_total*param->d_k*param->n_heads*2;    //K cache
-				numComputation += seq_len*seq_len_total*param->d_v*param->n_heads*2;    //V cache
-				numComputation += seq_len*param->d_model*param->d_v*param->n_heads*2;   //Linear
-				numComputation += seq_len*param->d_hidden*param->d_model*2; 			//FFN1
-				numComputation += seq_len*param->d_model*param->d_hidden*2; 			//FFN2
-			}
+		//自回归阶段，digital为2时只执行自回归生成阶段
+		//incrementalDecode模式下权重固定的PE只在第一个token时评估，之后只重新评估K、V缓存矩阵
+		int firstToken = seq_len_total+1;
+		int lastToken = param->output_len;
+		vector<SimulationContext *> threadContexts;
+		vector<TokenPerformance> decodeTokens = CalculateDecodePerformance(context, &threadContexts, firstToken, lastToken, calculateTokenPerformance);
+		for (int i=0; i<threadContexts.size(); i++) {
+			delete threadContexts[i];
+		}
+		for (int t=firstToken; t<=lastToken; t++) {
+			accumulateTokenPerformance(1, t, decodeTokens[t-firstToken]);
 		}
 	}
 	else if (! param->pipeline) {
 		// layer-by-layer process
 		// show the detailed hardware performance for each layer
+		LayerPrefetcher *prefetcher = StartLayerPrefetch(context, netStructure.size(), argv);
 		for (int i=0; i<netStructure.size(); i++) {
 			cout << "-------------------- Estimation of Layer " << i+1 << " ----------------------" << endl;
+			ProcessingUnitResetInputVectorStats();
 			
 			param->activityRowReadWG = atof(argv[4*i+8]);
                         param->activityRowWriteWG = atof(argv[4*i+8]);
                         param->activityColWriteWG = atof(argv[4*i+8]);
 						
 			
-			ChipCalculatePerformance(inputParameter, tech, cell, i, argv[4*i+5], argv[4*i+6], argv[4*i+7], netStructure[i][6],
+			ChipCalculatePerformance(context, i, argv[4*i+5], argv[4*i+6], argv[4*i+7], netStructure[i][6],
 						netStructure, markNM, 0, 0, 0, numTileEachLayer, utilizationEachLayer, speedUpEachLayer, tileLocaEachLayer,
 						numPENM, desiredPESizeNM, desiredTileSizeCM, desiredPESizeCM, CMTileheight, CMTilewidth, NMTileheight, NMTilewidth, numArrayWriteParallel,
 						&layerReadLatency, &layerReadDynamicEnergy, &tileLeakage, &layerReadLatencyAG, &layerReadDynamicEnergyAG, &layerReadLatencyWG, &layerReadDynamicEnergyWG, 
 						&layerWriteLatencyWU, &layerWriteDynamicEnergyWU, &layerbufferLatency, &layerbufferDynamicEnergy, &layericLatency, &layericDynamicEnergy,
 						&coreLatencyADC, &coreLatencyAccum, &coreLatencyOther, &coreEnergyADC, &coreEnergyAccum, &coreEnergyOther, &layerDRAMLatency, &layerDRAMDynamicEnergy,
 						&layerReadLatencyPeakFW, &layerReadDynamicEnergyPeakFW, &layerReadLatencyPeakAG, &layerReadDynamicEnergyPeakAG,
-						&layerReadLatencyPeakWG, &layerReadDynamicEnergyPeakWG, &layerWriteLatencyPeakWU, &layerWriteDynamicEnergyPeakWU);
+						&layerReadLatencyPeakWG, &layerReadDynamicEnergyPeakWG, &layerWriteLatencyPeakWU, &layerWriteDynamicEnergyPeakWU,
+						prefetcher? prefetcher->Get(i) : NULL);
 			
 			double numTileOtherLayer = 0;
 			double layerLeakageEnergy = 0;		
@@ -594,6 +425,12 @@ int main(int argc, char * argv[]) {
 			}
 			layerLeakageEnergy = numTileOtherLayer*tileLeakage*(layerReadLatency+layerReadLatencyAG);
 			
+			long numInputVectorEvaluated, numInputVectorReused;
+			ProcessingUnitGetInputVectorStats(&numInputVectorEvaluated, &numInputVectorReused);
+			if (numInputVectorEvaluated + numInputVectorReused > 0) {
+				cout << "layer" << i+1 << "'s input vectors: " << numInputVectorEvaluated << " evaluated, " << numInputVectorReused << " reused ("
+					 << (double) numInputVectorReused/(numInputVectorEvaluated + numInputVectorReused)*100 << "% hit rate)" << endl;
+			}
 			cout << "layer" << i+1 << "'s readLatency of Forward is: " << layerReadLatency*1e9 << "ns" << endl;
 			cout << "layer" << i+1 << "'s readDynamicEnergy of Forward is: " << layerReadDynamicEnergy*1e12 << "pJ" << endl;
 			cout << "layer" << i+1 << "'s readLatency of Activation Gradient is: " << layerReadLatencyAG*1e9 << "ns" << endl;
@@ -686,6 +523,7 @@ int main(int argc, char * argv[]) {
 			chipEnergyAccum += coreEnergyAccum;
 			chipEnergyOther += coreEnergyOther;
 		}
+		delete prefetcher;
 	} else {
 		// pipeline system
 		// firstly define system clock
@@ -728,19 +566,21 @@ int main(int argc, char * argv[]) {
 		vector<double> coreLatencyOtherPerLayer;
 		vector<double> coreEnergyOtherPerLayer;
 		
+		LayerPrefetcher *prefetcher = StartLayerPrefetch(context, netStructure.size(), argv);
 		for (int i=0; i<netStructure.size(); i++) {
 			
             param->activityRowReadWG = atof(argv[4*i+8]);
             param->activityRowWriteWG = atof(argv[4*i+8]);
             param->activityColWriteWG = atof(argv[4*i+8]);
-			ChipCalculatePerformance(inputParameter, tech, cell, i, argv[4*i+5], argv[4*i+6], argv[4*i+7], netStructure[i][6],
+			ChipCalculatePerformance(context, i, argv[4*i+5], argv[4*i+6], argv[4*i+7], netStructure[i][6],
 						netStructure, markNM, 0, 0, 0, numTileEachLayer, utilizationEachLayer, speedUpEachLayer, tileLocaEachLayer,
 						numPENM, desiredPESizeNM, desiredTileSizeCM, desiredPESizeCM, CMTileheight, CMTilewidth, NMTileheight, NMTilewidth, numArrayWriteParallel,
 						&layerReadLatency, &layerReadDynamicEnergy, &tileLeakage, &layerReadLatencyAG, &layerReadDynamicEnergyAG, &layerReadLatencyWG, &layerReadDynamicEnergyWG, &layerWriteLatencyWU, &layerWriteDynamicEnergyWU,
 						&layerbufferLatency, &layerbufferDynamicEnergy, &layericLatency, &layericDynamicEnergy,
 						&coreLatencyADC, &coreLatencyAccum, &coreLatencyOther, &coreEnergyADC, &coreEnergyAccum, &coreEnergyOther, &layerDRAMLatency, &layerDRAMDynamicEnergy,
 						&layerReadLatencyPeakFW, &layerReadDynamicEnergyPeakFW, &layerReadLatencyPeakAG, &layerReadDynamicEnergyPeakAG,
-						&layerReadLatencyPeakWG, &layerReadDynamicEnergyPeakWG, &layerWriteLatencyPeakWU, &layerWriteDynamicEnergyPeakWU);
+						&layerReadLatencyPeakWG, &layerReadDynamicEnergyPeakWG, &layerWriteLatencyPeakWU, &layerWriteDynamicEnergyPeakWU,
+						prefetcher? prefetcher->Get(i) : NULL);
 						
 			
 			systemClock = MAX(systemClock, layerReadLatency);
@@ -810,6 +650,7 @@ int main(int argc, char * argv[]) {
 			chipEnergyOther += coreEnergyOther;
 			
 		}
+		delete prefetcher;
 		chipReadLatency = systemClock;
 		chipReadLatencyAG = systemClockAG;
 		chipReadLatencyPeakFW = systemClockPeakFW;
@@ -1011,52 +852,30 @@ int main(int argc, char * argv[]) {
 }
 
 vector<vector<double> > getNetStructure(const string &inputfile) {
-	ifstream infile(inputfile.c_str());      
-	string inputline;
-	string inputval;
-	
-	int ROWin=0, COLin=0;      
-	if (!infile.good()) {        
+	CsvMatrix csv;
+	if (!LoadCsvMatrix(inputfile, &csv)) {
 		cerr << "Error: the input file cannot be opened!" << endl;
 		exit(1);
-	}else{
-		while (getline(infile, inputline, '\n')) {       
-			ROWin++;                                
-		}
-		infile.clear();
-		infile.seekg(0, ios::beg);      
-		if (getline(infile, inputline, '\n')) {        
-			istringstream iss (inputline);      
-			while (getline(iss, inputval, ',')) {       
-				COLin++;
-			}
-		}	
 	}
-	infile.clear();
-	infile.seekg(0, ios::beg);          
 
 	vector<vector<double> > netStructure;               
-	for (int row=0; row<ROWin; row++) {	
-		vector<double> netStructurerow;
-		getline(infile, inputline, '\n');             
-		istringstream iss;
-		iss.str(inputline);
-		for (int col=0; col<COLin; col++) {       
-			while(getline(iss, inputval, ',')){	
-				istringstream fs;
-				fs.str(inputval);
-				double f=0;
-				fs >> f;				
-				netStructurerow.push_back(f);			
-			}			
-		}		
-		netStructure.push_back(netStructurerow);
+	for (int row=0; row<csv.size(); row++) {	
+		netStructure.push_back(vector<double>(csv[row], csv[row] + csv.NumField(row)));
 	}
-	infile.close();
 	
 	return netStructure;
-	netStructure.clear();
 }	
 
-
-
+// 模拟计算逐层评估时各层的文件为argv[4*i+5..7]，param->prefetchLayers为0时不预读，返回NULL
+LayerPrefetcher *StartLayerPrefetch(SimulationContext &context, int numLayer, char *argv[]) {
+	if (param->prefetchLayers <= 0) {
+		return NULL;
+	}
+	vector<LayerFiles> files(numLayer);
+	for (int i=0; i<numLayer; i++) {
+		files[i].newWeight = argv[4*i+5];
+		files[i].oldWeight = argv[4*i+6];
+		files[i].input = argv[4*i+7];
+	}
+	return new LayerPrefetcher(context, files, param->prefetchLayers, param->prefetchMemoryBudget);
+}
@@ -12,6 +12,7 @@ from utee import wage_util
 from datetime import datetime
 from utee import wage_quantizer
 from utee import hook
+from utee import neurosim
 import numpy as np
 import csv
 from subprocess import call
@@ -47,6 +48,7 @@ parser.add_argument('--nonlinearityLTD', default=-0.01)
 parser.add_argument('--max_level', default=100)
 parser.add_argument('--d2dVari', default=0)
 parser.add_argument('--c2cVari', default=0)
+parser.add_argument('--inprocess', type=int, default=1, help='run NeuroSIM in this process through NeuroSIM/libneurosim.so when it is built (make lib), otherwise call ./NeuroSIM/main every epoch')
 current_time = datetime.now().strftime('%Y_%m_%d_%H_%M_%S')
 
 args = parser.parse_args()
@@ -118,6 +120,11 @@ best_acc, old_file = 0, None
 t_begin = time.time()
 grad_scale = args.grad_scale
 
+# initialize the simulated chip once for the whole run instead of once per epoch
+if args.inprocess and os.path.exists(neurosim.DEFAULT_LIBRARY):
+    hook.simulator = neurosim.NeuroSim('./NeuroSIM/NetWork.csv', args.wl_weight, args.wl_activate)
+    logger('NeuroSim: in-process simulation with ' + neurosim.DEFAULT_LIBRARY)
+
 try:
     # ready to go
     if args.cellBit != args.wl_weight:
@@ -221,13 +228,19 @@ try:
         h = 0
         for i, layer in enumerate(model.features.modules()):
             if isinstance(layer, QConv2d) or isinstance(layer,QLinear):
-                weight_file_name =  './layer_record/weightOld' + str(layer.name) + '.csv'
-                hook.write_matrix_weight( (oldWeight[h]).cpu().data.numpy(),weight_file_name)
+                weight_file_name =  './layer_record/weightOld' + str(layer.name) + '.bin'
+                if hook.simulator is not None:
+                    hook.old_weights[str(layer.name)] = hook.weight_matrix((oldWeight[h]).cpu().data.numpy())
+                else:
+                    hook.write_matrix_weight( (oldWeight[h]).cpu().data.numpy(),weight_file_name,args.wl_weight)
                 h = h+1
         for i, layer in enumerate(model.classifier.modules()):
             if isinstance(layer, QLinear):
-                weight_file_name =  './layer_record/weightOld' + str(layer.name) + '.csv'
-                hook.write_matrix_weight( (oldWeight[h]).cpu().data.numpy(),weight_file_name)
+                weight_file_name =  './layer_record/weightOld' + str(layer.name) + '.bin'
+                if hook.simulator is not None:
+                    hook.old_weights[str(layer.name)] = hook.weight_matrix((oldWeight[h]).cpu().data.numpy())
+                else:
+                    hook.write_matrix_weight( (oldWeight[h]).cpu().data.numpy(),weight_file_name,args.wl_weight)
                 h = h+1
         
         if epoch % args.test_interval == 0:
@@ -264,7 +277,16 @@ try:
                 misc.model_save(model, new_file, old_file=old_file, verbose=True)
                 best_acc = acc
                 old_file = new_file
-            call(["/bin/bash", "./layer_record/trace_command.sh"])
+            if hook.simulator is not None:
+                layer_results, chip_result = hook.run_simulator()
+                hook.simulator.write_breakdown('./NeuroSim_Results_Each_Epoch/NeuroSim_Breakdown_Epock_{}.csv'.format(epoch), layer_results, chip_result)
+                row = chip_result.output_row()
+                with open("NeuroSim_Output.csv", 'a') as neurosim_out:
+                    np.savetxt(neurosim_out, [row], delimiter=",")
+                logger('\tEpoch {} NeuroSim: latency {:.4e}s, energy {:.4e}J, {:.2f} TOPS/W'.format(
+                    epoch, sum(row[0:4]), sum(row[4:8]), chip_result.energyEfficiency))
+            else:
+                call(["/bin/bash", "./layer_record/trace_command.sh"])
 
 
 except Exception as e:
@@ -1,5 +1,6 @@
 #from modules.quantize import quantize, quantize_grad, QConv2d, QLinear, RangeBN
 import os
+import struct
 import torch.nn as nn
 import shutil
 from modules.quantization_cpu_np_infer import QConv2d,QLinear
@@ -7,14 +8,48 @@ import numpy as np
 import torch
 from utee import wage_quantizer
 
+# Binary layer trace read by NeuroSIM/TraceFile.cpp (mmap'ed, no text parsing):
+# a 40-byte little-endian header followed by the data, see TraceHeader in TraceFile.h
+TRACE_MAGIC = b'NSTRACE\x00'
+TRACE_VERSION = 1
+TRACE_FLOAT32 = 1   # row-major float32 matrix (weights)
+TRACE_BIT = 2       # 0/1 matrix packed column by column into 64-bit words (input bit planes)
+TRACE_HEADER = struct.Struct('<8sIIIIIId')
+
+# When set to a utee.neurosim.NeuroSim, the hooks keep each layer's weight and input bit planes in memory
+# (layer_traces, in forward order) instead of writing trace files, and run_simulator() evaluates them in-process
+simulator = None
+layer_traces = []
+old_weights = {}
+
+def write_trace(filename, data_type, num_row, num_col, quant_bits, activity, payload):
+    with open(filename, 'wb') as f:
+        f.write(TRACE_HEADER.pack(TRACE_MAGIC, TRACE_VERSION, data_type, num_row, num_col, quant_bits, 0, activity))
+        f.write(payload)
+
+def pack_bit_columns(bit_matrix):
+    # same layout as BitMatrix: row i of a column is bit i%64 of word i//64, each column padded to whole words
+    num_row, num_col = bit_matrix.shape
+    num_word = (num_row + 63) // 64
+    packed = np.zeros((num_col, num_word * 8), dtype=np.uint8)
+    packed[:, :(num_row + 7) // 8] = np.packbits(bit_matrix.transpose().astype(np.uint8), axis=1, bitorder='little')
+    return packed
+
 def Neural_Sim(self, input, output):
-    input_file_name =  './layer_record/input' + str(self.name) + '.csv'
-    weight_file_name =  './layer_record/weight' + str(self.name) + '.csv'
-    weightOld_file_name = './layer_record/weightOld' + str(self.name) + '.csv'
+    if simulator is not None:
+        if len(self.weight.shape) > 2:
+            bits = activation_bits_conv(stretch_input(input[0].cpu().data.numpy(),self.weight.shape[-1],self.padding,self.stride),self.wl_input)
+        else:
+            bits = activation_bits_fc(input[0].cpu().data.numpy(),self.wl_input)
+        layer_traces.append((weight_matrix(wage_quantizer.Q(self.weight,self.wl_weight).cpu().data.numpy()), old_weights[str(self.name)], pack_bit_columns(bits), bits.shape[0], np.mean(bits)))
+        return
+    input_file_name =  './layer_record/input' + str(self.name) + '.bin'
+    weight_file_name =  './layer_record/weight' + str(self.name) + '.bin'
+    weightOld_file_name = './layer_record/weightOld' + str(self.name) + '.bin'
     f = open('./layer_record/trace_command.sh', "a")
     input_activity = open('./input_activity.csv', "a")
     weight_q = wage_quantizer.Q(self.weight,self.wl_weight)
-    write_matrix_weight( weight_q.cpu().data.numpy(),weight_file_name)
+    write_matrix_weight( weight_q.cpu().data.numpy(),weight_file_name,self.wl_weight)
     if len(self.weight.shape) > 2:
         k=self.weight.shape[-1]
         padding = self.padding
@@ -30,27 +65,39 @@ def Neural_Sim(self, input, output):
     f.write(weight_file_name+' '+weightOld_file_name+' '+input_file_name+' '+str(activity)+' ')
     
 
-def write_matrix_weight(input_matrix,filename):
+def weight_matrix(input_matrix):
+    # one row per input (cin x kernel), one column per output channel
     cout = input_matrix.shape[0]
-    weight_matrix = input_matrix.reshape(cout,-1).transpose()
-    np.savetxt(filename, weight_matrix, delimiter=",",fmt='%10.5f')
+    return np.ascontiguousarray(input_matrix.reshape(cout,-1).transpose(), dtype='<f4')
 
-def write_matrix_activation_conv(input_matrix,fill_dimension,length,filename):
-    filled_matrix_b = np.zeros([input_matrix.shape[2],input_matrix.shape[1]*length],dtype=str)
+def write_matrix_weight(input_matrix,filename,wl_weight=0):
+    matrix = weight_matrix(input_matrix)
+    write_trace(filename, TRACE_FLOAT32, matrix.shape[0], matrix.shape[1], wl_weight, 0.0, matrix.tobytes())
+
+def activation_bits_conv(input_matrix,length):
+    filled_matrix_b = np.zeros([input_matrix.shape[2],input_matrix.shape[1]*length],dtype=np.uint8)
     filled_matrix_bin,scale = dec2bin(input_matrix[0,:],length)
     for i,b in enumerate(filled_matrix_bin):
         filled_matrix_b[:,i::length] =  b.transpose()
-    activity = np.sum(filled_matrix_b.astype(float), axis=None)/np.size(filled_matrix_b)
-    np.savetxt(filename, filled_matrix_b, delimiter=",",fmt='%s')
-    return activity
+    return filled_matrix_b
 
-def write_matrix_activation_fc(input_matrix,fill_dimension,length,filename):
-    filled_matrix_b = np.zeros([input_matrix.shape[1],length],dtype=str)
+def activation_bits_fc(input_matrix,length):
+    filled_matrix_b = np.zeros([input_matrix.shape[1],length],dtype=np.uint8)
     filled_matrix_bin,scale = dec2bin(input_matrix[0,:],length)
     for i,b in enumerate(filled_matrix_bin):
         filled_matrix_b[:,i] =  b
-    activity = np.sum(filled_matrix_b.astype(float), axis=None)/np.size(filled_matrix_b)
-    np.savetxt(filename, filled_matrix_b, delimiter=",",fmt='%s')
+    return filled_matrix_b
+
+def write_matrix_activation_conv(input_matrix,fill_dimension,length,filename):
+    filled_matrix_b = activation_bits_conv(input_matrix,length)
+    activity = np.sum(filled_matrix_b, axis=None)/np.size(filled_matrix_b)
+    write_trace(filename, TRACE_BIT, filled_matrix_b.shape[0], filled_matrix_b.shape[1], length, activity, pack_bit_columns(filled_matrix_b).tobytes())
+    return activity
+
+def write_matrix_activation_fc(input_matrix,fill_dimension,length,filename):
+    filled_matrix_b = activation_bits_fc(input_matrix,length)
+    activity = np.sum(filled_matrix_b, axis=None)/np.size(filled_matrix_b)
+    write_trace(filename, TRACE_BIT, filled_matrix_b.shape[0], filled_matrix_b.shape[1], length, activity, pack_bit_columns(filled_matrix_b).tobytes())
     return activity
 
 def stretch_input(input_matrix,window_size = 5,padding=(0,0),stride=(1,1)):
@@ -109,12 +156,14 @@ def remove_hook_list(hook_handle_list):
 
 def hardware_evaluation(model,wl_weight,wl_activation,numEpoch):
     hook_handle_list = []
-    if not os.path.exists('./layer_record'):
-        os.makedirs('./layer_record')
-    if os.path.exists('./layer_record/trace_command.sh'):
-        os.remove('./layer_record/trace_command.sh')
-    f = open('./layer_record/trace_command.sh', "w")
-    f.write('./NeuroSIM/main '+str(numEpoch)+' ./NeuroSIM/NetWork.csv '+str(wl_weight)+' '+str(wl_activation)+' ')
+    del layer_traces[:]
+    if simulator is None:
+        if not os.path.exists('./layer_record'):
+            os.makedirs('./layer_record')
+        if os.path.exists('./layer_record/trace_command.sh'):
+            os.remove('./layer_record/trace_command.sh')
+        f = open('./layer_record/trace_command.sh', "w")
+        f.write('./NeuroSIM/main '+str(numEpoch)+' ./NeuroSIM/NetWork.csv '+str(wl_weight)+' '+str(wl_activation)+' ')
     for i, layer in enumerate(model.features.modules()):
         if isinstance(layer, QConv2d) or isinstance(layer,QLinear):
             hook_handle_list.append(layer.register_forward_hook(Neural_Sim))
@@ -124,9 +173,14 @@ def hardware_evaluation(model,wl_weight,wl_activation,numEpoch):
     return hook_handle_list
 
 
+def run_simulator():
+    # evaluate the layers recorded by the hooks with the in-process simulator, returns (per-layer, chip) results
+    layers = [simulator.evaluate_layer(i, *trace) for i, trace in enumerate(layer_traces)]
+    return layers, simulator.summarize(layers)
+
 def pre_save_old_weight(oldWeight, name, wl_weight):
     if not os.path.exists('./layer_record'):
         os.makedirs('./layer_record')
-    weight_file_name =  './layer_record/Oldweight' + str(name) + '.csv'
+    weight_file_name =  './layer_record/Oldweight' + str(name) + '.bin'
     weight_q = wage_quantizer.Q(oldWeight,wl_weight)
-    write_matrix_weight( weight_q.cpu().data.numpy(),weight_file_name)
+    write_matrix_weight( weight_q.cpu().data.numpy(),weight_file_name,wl_weight)
@@ -0,0 +1,156 @@
+# In-process binding of NeuroSIM/libneurosim.so (build it with `make lib` in NeuroSIM/, C API in NeuroSIM/NeuroSim.h).
+# The chip (technology, floorplan, modules and area) is initialized once; every layer is then evaluated
+# directly from numpy buffers and the results come back as ctypes structures instead of trace files and CSVs.
+import ctypes
+import os
+import numpy as np
+
+API_VERSION = 2
+DEFAULT_LIBRARY = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'NeuroSIM', 'libneurosim.so')
+
+PERFORMANCE_FIELDS = [
+    'readLatency', 'readDynamicEnergy', 'readLatencyAG', 'readDynamicEnergyAG',
+    'readLatencyWG', 'readDynamicEnergyWG', 'writeLatencyWU', 'writeDynamicEnergyWU',
+    'readLatencyPeakFW', 'readDynamicEnergyPeakFW', 'readLatencyPeakAG', 'readDynamicEnergyPeakAG',
+    'readLatencyPeakWG', 'readDynamicEnergyPeakWG', 'writeLatencyPeakWU', 'writeDynamicEnergyPeakWU',
+    'leakagePower', 'leakageEnergy',
+    'bufferLatency', 'bufferDynamicEnergy', 'icLatency', 'icDynamicEnergy',
+    'coreLatencyADC', 'coreLatencyAccum', 'coreLatencyOther', 'coreEnergyADC', 'coreEnergyAccum', 'coreEnergyOther',
+    'dramLatency', 'dramDynamicEnergy']
+
+class Performance(ctypes.Structure):
+    # latency (s), energy (J) and leakage power (W) of one layer or of the whole chip
+    _fields_ = [(name, ctypes.c_double) for name in PERFORMANCE_FIELDS]
+
+    def as_dict(self):
+        return dict((name, getattr(self, name)) for name in PERFORMANCE_FIELDS)
+
+class ChipInfo(ctypes.Structure):
+    _fields_ = [('numLayer', ctypes.c_int), ('pipeline', ctypes.c_int), ('digital', ctypes.c_int),
+                ('numRowPerSynapse', ctypes.c_int), ('numColPerSynapse', ctypes.c_int),
+                ('numComputation', ctypes.c_double), ('height', ctypes.c_double), ('width', ctypes.c_double)] + \
+               [(name, ctypes.c_double) for name in ['area', 'areaArray', 'areaIC', 'areaADC', 'areaAccum', 'areaOther', 'areaWG']]
+
+class ChipPerformance(ctypes.Structure):
+    _fields_ = [('total', Performance)] + \
+               [(name, ctypes.c_double) for name in ['numComputation', 'energyEfficiency', 'throughputTOPS', 'throughputFPS',
+                                                     'peakEnergyEfficiency', 'peakThroughputTOPS', 'peakThroughputFPS']]
+
+    def output_row(self):
+        # same columns as the rows ./NeuroSIM/main appends to NeuroSim_Output.csv
+        t = self.total
+        return [t.readLatency, t.readLatencyAG, t.readLatencyWG, t.writeLatencyWU,
+                t.readDynamicEnergy, t.readDynamicEnergyAG, t.readDynamicEnergyWG, t.writeDynamicEnergyWU,
+                t.readLatencyPeakFW, t.readLatencyPeakAG, t.readLatencyPeakWG, t.writeLatencyPeakWU,
+                t.readDynamicEnergyPeakFW, t.readDynamicEnergyPeakAG, t.readDynamicEnergyPeakWG, t.writeDynamicEnergyPeakWU,
+                self.energyEfficiency, self.throughputTOPS, self.peakEnergyEfficiency, self.peakThroughputTOPS]
+
+BREAKDOWN_HEADER = ('layer_number, latency_FW(s), latency_AG(s), latency_WG(s), latency_WU(s), energy_FW(J), energy_AG(J), energy_WG(J), energy_WU(J),'
+                    'Peak_latency_FW(s), Peak_latency_AG(s), Peak_latency_WG(s), Peak_latency_WU(s), Peak_energy_FW(J), Peak_energy_AG(J), Peak_energy_WG(J), Peak_energy_WU(J),'
+                    ', , ADC_latency(s), Accumulation_latency(s), Synaptic Array w/o ADC_latency(s), Buffer_latency(s), IC_latency(s), Weight_gradient_latency(s), Weight_update(s), DRAM_latency(s), '
+                    'ADC_energy(J), Accumulation_energy(J), Synaptic Array w/o ADC_energy(J), Buffer_energy(J), IC_energy(J), Weight_gradient_energy(J), Weight_update_energy(J), DRAM_energy(J)')
+
+def _format(values):
+    # %g gives the same 6 significant digits as the default ostream formatting of ./NeuroSIM/main
+    return ','.join('%g' % v for v in values)
+
+def _breakdown_row(name, p):
+    return (str(name) + ',' + _format([p.readLatency, p.readLatencyAG, p.readLatencyWG, p.writeLatencyWU,
+                                       p.readDynamicEnergy, p.readDynamicEnergyAG, p.readDynamicEnergyWG, p.writeDynamicEnergyWU,
+                                       p.readLatencyPeakFW, p.readLatencyPeakAG, p.readLatencyPeakWG, p.writeLatencyPeakWU,
+                                       p.readDynamicEnergyPeakFW, p.readDynamicEnergyPeakAG, p.readDynamicEnergyPeakWG, p.writeDynamicEnergyPeakWU]) +
+            ',, , ' + _format([p.coreLatencyADC, p.coreLatencyAccum, p.coreLatencyOther, p.bufferLatency, p.icLatency,
+                               p.readLatencyPeakWG, p.writeLatencyPeakWU, p.dramLatency,
+                               p.coreEnergyADC, p.coreEnergyAccum, p.coreEnergyOther, p.bufferDynamicEnergy, p.icDynamicEnergy,
+                               p.readDynamicEnergyPeakWG, p.writeDynamicEnergyPeakWU, p.dramDynamicEnergy]))
+
+def _load(library):
+    lib = ctypes.CDLL(library)
+    lib.neurosim_api_version.restype = ctypes.c_int
+    lib.neurosim_last_error.restype = ctypes.c_char_p
+    lib.neurosim_create.restype = ctypes.c_void_p
+    lib.neurosim_create.argtypes = [ctypes.c_char_p, ctypes.c_int, ctypes.c_int]
+    lib.neurosim_destroy.argtypes = [ctypes.c_void_p]
+    lib.neurosim_get_chip_info.argtypes = [ctypes.c_void_p, ctypes.POINTER(ChipInfo)]
+    lib.neurosim_evaluate_layer.restype = ctypes.c_int
+    lib.neurosim_evaluate_layer.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int, ctypes.c_int,
+                                            ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_double, ctypes.POINTER(Performance)]
+    lib.neurosim_evaluate_layer_files.restype = ctypes.c_int
+    lib.neurosim_evaluate_layer_files.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p,
+                                                  ctypes.c_double, ctypes.POINTER(Performance)]
+    lib.neurosim_summarize.argtypes = [ctypes.c_void_p, ctypes.POINTER(Performance), ctypes.POINTER(ChipPerformance)]
+    lib.neurosim_evaluate_tokens.restype = ctypes.c_int
+    lib.neurosim_evaluate_tokens.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.POINTER(ChipPerformance)]
+    if lib.neurosim_api_version() != API_VERSION:
+        raise RuntimeError('{} implements NeuroSim API version {}, expected {}'.format(library, lib.neurosim_api_version(), API_VERSION))
+    return lib
+
+class NeuroSim(object):
+    def __init__(self, network_file, wl_weight, wl_activate, library=DEFAULT_LIBRARY):
+        self.lib = _load(library)
+        self.handle = self.lib.neurosim_create(network_file.encode(), wl_weight, wl_activate)
+        if not self.handle:
+            raise RuntimeError('NeuroSim: ' + self.lib.neurosim_last_error().decode())
+        self.info = ChipInfo()
+        self.lib.neurosim_get_chip_info(self.handle, ctypes.byref(self.info))
+
+    def close(self):
+        if self.handle:
+            self.lib.neurosim_destroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
+
+    def _check(self, status):
+        if status != 0:
+            raise ValueError('NeuroSim: ' + self.lib.neurosim_last_error().decode())
+
+    def evaluate_layer(self, layer, weight, old_weight, input_bits, input_rows, activity):
+        # weight, old_weight: float32 matrices as returned by hook.weight_matrix (rows = inputs, columns = output channels)
+        # input_bits: bit planes packed by hook.pack_bit_columns, input_rows = number of rows before packing
+        # contiguous float32 / uint8 buffers are passed without copying
+        weight = np.ascontiguousarray(weight, dtype=np.float32)
+        old_weight = np.ascontiguousarray(old_weight, dtype=np.float32)
+        input_bits = np.ascontiguousarray(input_bits, dtype=np.uint8)
+        if weight.shape != old_weight.shape:
+            raise ValueError('NeuroSim: weight {} and old weight {} of layer {} differ in shape'.format(weight.shape, old_weight.shape, layer))
+        result = Performance()
+        self._check(self.lib.neurosim_evaluate_layer(self.handle, layer, weight.ctypes.data, old_weight.ctypes.data, weight.shape[0], weight.shape[1],
+                                                     input_bits.ctypes.data, input_rows, input_bits.shape[0], activity, ctypes.byref(result)))
+        return result
+
+    def evaluate_layer_files(self, layer, weight_file, old_weight_file, input_file, activity):
+        result = Performance()
+        self._check(self.lib.neurosim_evaluate_layer_files(self.handle, layer, weight_file.encode(), old_weight_file.encode(), input_file.encode(),
+                                                           activity, ctypes.byref(result)))
+        return result
+
+    def summarize(self, layers):
+        # combine the results of all layers (layer-by-layer or pipeline, as in ./NeuroSIM/main)
+        if len(layers) != self.info.numLayer:
+            raise ValueError('NeuroSim: {} layer results given, the network has {} layers'.format(len(layers), self.info.numLayer))
+        array = (Performance * len(layers))(*layers)
+        chip = ChipPerformance()
+        self.lib.neurosim_summarize(self.handle, array, ctypes.byref(chip))
+        return chip
+
+    def write_breakdown(self, file_name, layers, chip):
+        # append the per-layer breakdown in the layout of ./NeuroSIM/main (NeuroSim_Breakdown_Epock_<epoch>.csv)
+        info = self.info
+        with open(file_name, 'a') as f:
+            f.write('Total Area(m^2), Total CIM (FW+AG) Area (m^2), Routing Area(m^2), ADC Area(m^2), Accumulation Area(m^2), Other Logic&Storage Area(m^2), Weight Gradient Area(m^2),\n')
+            f.write(_format([info.area, info.areaArray, info.areaIC, info.areaADC, info.areaAccum, info.areaOther, info.areaWG]) + '\n\n\n')
+            f.write(BREAKDOWN_HEADER + '\n')
+            for i, layer in enumerate(layers):
+                f.write(_breakdown_row(i+1, layer) + '\n')
+            f.write(_breakdown_row('Total', chip.total) + '\n\n\n')
+            f.write('TOPS/W,FPS,TOPS,Peak TOPS/W,Peak FPS,Peak TOPS,\n')
+            f.write(_format([chip.energyEfficiency, chip.throughputFPS, chip.throughputTOPS,
+                             chip.peakEnergyEfficiency, chip.peakThroughputFPS, chip.peakThroughputTOPS]) + '\n')
+
+    def evaluate_tokens(self, input_len, output_len):
+        # digital mode only: one query with the given input and output length (prefill included when Param::digital is 1)
+        chip = ChipPerformance()
+        self._check(self.lib.neurosim_evaluate_tokens(self.handle, input_len, output_len, ctypes.byref(chip)))
+        return chip